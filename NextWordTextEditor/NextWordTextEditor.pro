@@ -1,12 +1,41 @@
 TEMPLATE = app
 
-QT += widgets
+QT += widgets concurrent network
 CONFIG += c++11
 
 SOURCES += main.cpp \
     mainwindow.cpp \
     textedit.cpp \
-    highlighter.cpp
+    highlighter.cpp \
+    highlightscheduler.cpp \
+    blockdata.cpp \
+    documentfile.cpp \
+    largefileview.cpp \
+    piecetable.cpp \
+    textsearch.cpp \
+    projectindex.cpp \
+    latencyhistogram.cpp \
+    keystrokereplay.cpp \
+    perfprobe.cpp \
+    perfoverlay.cpp \
+    findbar.cpp \
+    projectpanel.cpp \
+    documentvocabulary.cpp \
+    tokenpool.cpp \
+    wordindex.cpp \
+    nextwordpredictor.cpp \
+    dictionary.cpp \
+    dictionaryimage.cpp \
+    dictionarymanager.cpp \
+    usageranking.cpp \
+    learningstore.cpp \
+    completionmodel.cpp \
+    completionquery.cpp \
+    completionworker.cpp \
+    completionclient.cpp \
+    completionprotocol.cpp \
+    completionserver.cpp \
+    latexcompletion.cpp
 
 RESOURCES += \
     NextWordTextEditor.qrc
@@ -17,4 +46,33 @@ include(deployment.pri)
 HEADERS += \
     mainwindow.h \
     textedit.h \
-    highlighter.h
+    highlighter.h \
+    highlightscheduler.h \
+    blockdata.h \
+    documentfile.h \
+    largefileview.h \
+    piecetable.h \
+    textsearch.h \
+    projectindex.h \
+    latencyhistogram.h \
+    keystrokereplay.h \
+    perfprobe.h \
+    perfoverlay.h \
+    findbar.h \
+    projectpanel.h \
+    documentvocabulary.h \
+    tokenpool.h \
+    wordindex.h \
+    nextwordpredictor.h \
+    dictionary.h \
+    dictionaryimage.h \
+    dictionarymanager.h \
+    usageranking.h \
+    learningstore.h \
+    completionmodel.h \
+    completionquery.h \
+    completionworker.h \
+    completionclient.h \
+    completionprotocol.h \
+    completionserver.h \
+    latexcompletion.h
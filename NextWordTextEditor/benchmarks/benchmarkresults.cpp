@@ -0,0 +1,64 @@
+/*
+ * BenchmarkResults Class
+ * Reduce timing samples to statistics and write them as JSON
+*/
+#include "benchmarkresults.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QSysInfo>
+#include <algorithm>
+
+//! [0]
+//! main function
+//! create an empty result set
+BenchmarkResults::BenchmarkResults()
+{
+}
+//! [0]
+
+//! [1]
+//! function: add(param: benchmark name, parameters, samples in ns, bytes per sample)
+//! append the statistics of one benchmark
+void BenchmarkResults::add(const QString &name, const QJsonObject &parameters,
+                           QVector<qint64> samples, qint64 bytesPerSample)
+{
+    if (samples.isEmpty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    qint64 total = 0;
+    foreach (qint64 sample, samples)
+        total += sample;
+    const int count = samples.size();
+
+    QJsonObject result;
+    result["name"] = name;
+    result["parameters"] = parameters;
+    result["samples"] = count;
+    result["min_ns"] = double(samples.first());
+    result["median_ns"] = double(samples.at(count / 2));
+    result["mean_ns"] = double(total) / count;
+    result["p99_ns"] = double(samples.at(qMin(count - 1, count * 99 / 100)));
+    result["max_ns"] = double(samples.last());
+    if (bytesPerSample > 0 && total > 0)
+        result["mb_per_s"] = double(bytesPerSample) * count / (1024.0 * 1024.0) / (total / 1e9);
+    results.append(result);
+}
+//! [1]
+
+//! [2]
+//! function: document()
+//! all results with the build they were measured on
+QJsonDocument BenchmarkResults::document() const
+{
+    QJsonObject root;
+    root["application"] = QCoreApplication::applicationName();
+    root["version"] = QCoreApplication::applicationVersion();
+    root["qt"] = QString(qVersion());
+    root["cpu"] = QSysInfo::currentCpuArchitecture();
+    root["os"] = QSysInfo::prettyProductName();
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["results"] = results;
+    return QJsonDocument(root);
+}
+//! [2]
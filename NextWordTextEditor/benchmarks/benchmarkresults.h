@@ -0,0 +1,36 @@
+/*
+ * Header BenchmarkResults class
+ * Timing samples of the benchmarks, written as JSON
+*/
+
+#ifndef BENCHMARKRESULTS_H
+#define BENCHMARKRESULTS_H
+
+//import dependencies
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+
+//! [0]
+//! Every benchmark adds one result: its name, the parameters it ran with
+//! and the duration of each sample in nanoseconds. Results are reduced to
+//! min, median, mean, p99 and max, plus the throughput when the number of
+//! bytes processed per sample is known.
+class BenchmarkResults
+{
+    //set public methods & variables
+    public:
+        BenchmarkResults();
+
+        void add(const QString &name, const QJsonObject &parameters,
+                 QVector<qint64> samples, qint64 bytesPerSample = 0);
+        QJsonDocument document() const;
+
+    //set private methods & variables
+    private:
+        QJsonArray results;
+};
+//! [0]
+
+#endif // BENCHMARKRESULTS_H
@@ -0,0 +1,61 @@
+TEMPLATE = app
+TARGET = nextword-benchmarks
+
+QT += widgets concurrent network
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+#the benchmarks build the editor sources they measure
+APP = $$PWD/..
+INCLUDEPATH += $$APP
+DEFINES += RESOURCE_DIR=\\\"$$APP/resources\\\"
+
+SOURCES += main.cpp \
+    benchmarkresults.cpp \
+    $$APP/highlighter.cpp \
+    $$APP/blockdata.cpp \
+    $$APP/documentvocabulary.cpp \
+    $$APP/perfprobe.cpp \
+    $$APP/latencyhistogram.cpp \
+    $$APP/documentfile.cpp \
+    $$APP/textsearch.cpp \
+    $$APP/projectindex.cpp \
+    $$APP/tokenpool.cpp \
+    $$APP/wordindex.cpp \
+    $$APP/nextwordpredictor.cpp \
+    $$APP/dictionary.cpp \
+    $$APP/dictionaryimage.cpp \
+    $$APP/usageranking.cpp \
+    $$APP/learningstore.cpp \
+    $$APP/completionmodel.cpp \
+    $$APP/completionquery.cpp \
+    $$APP/completionworker.cpp \
+    $$APP/completionclient.cpp \
+    $$APP/completionprotocol.cpp \
+    $$APP/dictionarymanager.cpp \
+    $$APP/latexcompletion.cpp
+
+HEADERS += \
+    benchmarkresults.h \
+    $$APP/highlighter.h \
+    $$APP/blockdata.h \
+    $$APP/documentvocabulary.h \
+    $$APP/perfprobe.h \
+    $$APP/latencyhistogram.h \
+    $$APP/documentfile.h \
+    $$APP/textsearch.h \
+    $$APP/projectindex.h \
+    $$APP/tokenpool.h \
+    $$APP/wordindex.h \
+    $$APP/nextwordpredictor.h \
+    $$APP/dictionary.h \
+    $$APP/dictionaryimage.h \
+    $$APP/usageranking.h \
+    $$APP/learningstore.h \
+    $$APP/completionmodel.h \
+    $$APP/completionquery.h \
+    $$APP/completionworker.h \
+    $$APP/completionclient.h \
+    $$APP/completionprotocol.h \
+    $$APP/dictionarymanager.h \
+    $$APP/latexcompletion.h
@@ -0,0 +1,362 @@
+//include necessary classes
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+//include headers of the measured classes
+#include "benchmarkresults.h"
+#include "completionmodel.h"
+#include "dictionary.h"
+#include "documentfile.h"
+#include "highlighter.h"
+#include "projectindex.h"
+#include "textsearch.h"
+
+//queries timed per prefix length and completions recorded
+static const int QueryCount = 1000;
+//line of the synthetic LaTeX documents, cycled through
+static const char *const LatexLines[] = {
+    "\\section{Results and \\emph{discussion}}",
+    "The measured latency stays below the budget for every prefix length.",
+    "% TODO: rerun on the release build",
+    "\\begin{itemize} \\item first \\item second {with \\textbf{nested} groups} \\end{itemize}",
+    "/* a comment spanning",
+    "   two lines */ \\label{sec:results} and 50\\% of the time",
+    "\\cite{knuth1984} showed that {\\bf grouping} is cheap."
+};
+static const int LatexLineCount = int(sizeof(LatexLines) / sizeof(LatexLines[0]));
+
+//function timed
+//run a function once and return the elapsed nanoseconds
+template <typename Function>
+static qint64 timed(Function function)
+{
+    QElapsedTimer timer;
+    timer.start();
+    function();
+    return timer.nsecsElapsed();
+}
+
+//function latexText
+//synthetic LaTeX of at least the given size in bytes
+static QString latexText(qint64 bytes)
+{
+    QString text;
+    text.reserve(int(bytes + 128));
+    for (int i = 0; text.size() < bytes; ++i) {
+        text += QLatin1String(LatexLines[i % LatexLineCount]);
+        text += QLatin1Char('\n');
+    }
+    return text;
+}
+
+//function writeLatexFile
+//write synthetic LaTeX of the given size in bytes, return false on error
+static bool writeLatexFile(const QString &fileName, qint64 bytes)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+    const QByteArray chunk = latexText(1024 * 1024).toUtf8();
+    for (qint64 written = 0; written < bytes; written += chunk.size()) {
+        if (file.write(chunk.constData(), int(qMin(qint64(chunk.size()), bytes - written))) < 0)
+            return false;
+    }
+    return true;
+}
+
+//function benchmarkDictionaries
+//build every word list the way modelFromFiles does, and map its compiled image
+static void benchmarkDictionaries(BenchmarkResults *results, const QString &directory)
+{
+    const QStringList lists = QStringList() << "wordlist.txt" << "wordlist20k"
+                                            << "wordlistf500" << "wordlistupdate.txt";
+    foreach (const QString &list, lists) {
+        const QString fileName = QString(RESOURCE_DIR) + "/" + list;
+        const QString imageName = directory + "/" + list + ".nwd";
+        QJsonObject parameters;
+        parameters["list"] = list;
+
+        QVector<qint64> samples;
+        for (int i = 0; i < 5; ++i) {
+            samples.append(timed([&]() {
+                QSharedPointer<Dictionary> dictionary(new Dictionary);
+                dictionary->build(Dictionary::readWordList(fileName));
+                CompletionModel model;
+                model.setDictionary(dictionary);
+                if (i == 0)
+                    dictionary->save(imageName);
+            }));
+        }
+        results->add("model_from_file", parameters, samples, QFileInfo(fileName).size());
+
+        samples.clear();
+        for (int i = 0; i < 20; ++i) {
+            samples.append(timed([&]() {
+                Dictionary dictionary;
+                dictionary.map(imageName);
+            }));
+        }
+        results->add("dictionary_map", parameters, samples, QFileInfo(imageName).size());
+    }
+}
+
+//function benchmarkCompletion
+//latency of the query of one keystroke for prefixes of 1 to 6 characters,
+//then of recording an accepted completion
+static void benchmarkCompletion(BenchmarkResults *results)
+{
+    const QStringList words = Dictionary::readWordList(QString(RESOURCE_DIR) + "/wordlist20k");
+    QSharedPointer<Dictionary> dictionary(new Dictionary);
+    dictionary->build(words);
+    CompletionModel model;
+    model.setDictionary(dictionary);
+
+    for (int length = 1; length <= 6; ++length) {
+        QVector<qint64> samples;
+        for (int i = 0, w = 0; samples.size() < QueryCount && w < words.size(); ++w) {
+            const QString word = words.at((w * 7919) % words.size()).trimmed();
+            if (word.length() < length)
+                continue;
+            const QString previous = words.at((++i * 104729) % words.size()).trimmed();
+            const QString prefix = word.left(length);
+            samples.append(timed([&]() { model.setQuery(previous, prefix); }));
+        }
+        QJsonObject parameters;
+        parameters["list"] = QString("wordlist20k");
+        parameters["prefix_length"] = length;
+        results->add("prefix_lookup", parameters, samples);
+    }
+
+    QVector<qint64> samples;
+    for (int i = 0; i < QueryCount; ++i) {
+        const QString word = words.at((i * 7919) % words.size()).trimmed();
+        model.setQuery(QString(), word.left(2));
+        samples.append(timed([&]() { model.recordCompletion(word); }));
+    }
+    QJsonObject parameters;
+    parameters["list"] = QString("wordlist20k");
+    results->add("record_completion", parameters, samples);
+}
+
+//function benchmarkHighlighting
+//tokenizer throughput, and a full rehighlight of a document
+static void benchmarkHighlighting(BenchmarkResults *results)
+{
+    const qint64 bytes = 8 * 1024 * 1024;
+    const QString text = latexText(bytes);
+    const QStringList lines = text.split(QLatin1Char('\n'));
+    QJsonObject parameters;
+    parameters["bytes"] = double(bytes);
+    parameters["lines"] = lines.size();
+
+    QVector<Highlighter::Token> tokens;
+    QVector<qint64> samples;
+    for (int i = 0; i < 5; ++i) {
+        samples.append(timed([&]() {
+            int state = Highlighter::Normal;
+            foreach (const QString &line, lines) {
+                tokens.resize(0);
+                state = Highlighter::tokenize(line, state, &tokens);
+            }
+        }));
+    }
+    results->add("highlight_tokenize", parameters, samples, bytes * 2);
+
+    samples.clear();
+    QTextDocument document;
+    document.setPlainText(text);
+    Highlighter highlighter(&document);
+    for (int i = 0; i < 3; ++i)
+        samples.append(timed([&]() { highlighter.rehighlight(); }));
+    results->add("highlight_document", parameters, samples, bytes * 2);
+}
+
+//function benchmarkSearch
+//literal, case-insensitive and regular expression scans of UTF-16 and UTF-8 text
+static void benchmarkSearch(BenchmarkResults *results)
+{
+    const qint64 bytes = 64 * 1024 * 1024;
+    const QString text = latexText(bytes);
+    const QByteArray utf8 = text.toUtf8();
+    QVector<TextSearch::Span> spans;
+    for (qint64 start = 0; start < utf8.size(); start += 64 * 1024) {
+        TextSearch::Span span = { utf8.constData() + start, qMin(qint64(64 * 1024), utf8.size() - start) };
+        spans.append(span);
+    }
+
+    static const struct { const char *name; const char *pattern; int options; } queries[] = {
+        { "literal", "budget", TextSearch::CaseSensitive },
+        { "ignore_case", "Nested", 0 },
+        { "regular_expression", "\\\\(emph|textbf)\\{", TextSearch::RegularExpression }
+    };
+    for (unsigned i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        TextSearch search;
+        search.setQuery(QString::fromLatin1(queries[i].pattern), TextSearch::Options(queries[i].options));
+        QJsonObject parameters;
+        parameters["bytes"] = double(bytes);
+        parameters["query"] = QString::fromLatin1(queries[i].name);
+
+        QVector<qint64> samples;
+        for (int run = 0; run < 3; ++run)
+            samples.append(timed([&]() { search.findAll(text, TextSearch::MaxMatches); }));
+        results->add("search_document", parameters, samples, bytes * 2);
+
+        samples.clear();
+        for (int run = 0; run < 3; ++run)
+            samples.append(timed([&]() { search.findAll(spans, TextSearch::MaxMatches); }));
+        results->add("search_large_file", parameters, samples, utf8.size());
+    }
+}
+
+//function benchmarkProject
+//index a folder of files with one thread up to all cores, then search it
+//for a word of every file and for one the trigrams rule out; the crawlers
+//run on the pool of the index, the searches on the global pool, both are
+//given the same number of threads
+static void benchmarkProject(BenchmarkResults *results, const QString &directory)
+{
+    const int fileCount = 64;
+    const qint64 fileBytes = 1024 * 1024;
+    const QString folder = directory + "/project";
+    for (int i = 0; i < fileCount; ++i) {
+        const QString part = folder + QString("/part%1").arg(i % 8);
+        const QString fileName = part + QString("/chapter%1.tex").arg(i);
+        if (!QDir().mkpath(part) || !writeLatexFile(fileName, fileBytes)) {
+            QTextStream(stderr) << "cannot write " << fileName << endl;
+            return;
+        }
+    }
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int cores = qMax(1, QThread::idealThreadCount());
+    for (int threads = 1; ; threads = qMin(threads * 2, cores)) {
+        pool->setMaxThreadCount(threads);
+        QVector<qint64> indexing;
+        QVector<qint64> present;
+        QVector<qint64> absent;
+        for (int run = 0; run < 3; ++run) {
+            ProjectIndex index;
+            index.setMaxThreadCount(threads);
+            QEventLoop loop;
+            QObject::connect(&index, SIGNAL(indexed()), &loop, SLOT(quit()));
+            QObject::connect(&index, SIGNAL(searchFinished(int)), &loop, SLOT(quit()));
+            indexing.append(timed([&]() { index.open(folder); loop.exec(); }));
+            present.append(timed([&]() { index.find("budget", TextSearch::CaseSensitive); loop.exec(); }));
+            absent.append(timed([&]() { index.find("zebrafish", TextSearch::CaseSensitive); loop.exec(); }));
+        }
+        QJsonObject parameters;
+        parameters["files"] = fileCount;
+        parameters["bytes"] = double(fileCount * fileBytes);
+        parameters["threads"] = threads;
+        results->add("project_index", parameters, indexing, fileCount * fileBytes);
+        results->add("project_search", parameters, present, fileCount * fileBytes);
+        results->add("project_search_absent", parameters, absent);
+        if (threads == cores)
+            break;
+    }
+    pool->setMaxThreadCount(cores);
+}
+
+//function benchmarkFiles
+//chunked load and streamed save of synthetic files up to maxBytes
+static void benchmarkFiles(BenchmarkResults *results, const QString &directory, qint64 maxBytes)
+{
+    for (qint64 bytes = 1024 * 1024; bytes <= maxBytes; bytes *= 4) {
+        const QString input = directory + "/input.tex";
+        const QString output = directory + "/output.tex";
+        if (!writeLatexFile(input, bytes)) {
+            QTextStream(stderr) << "cannot write " << input << endl;
+            return;
+        }
+        QJsonObject parameters;
+        parameters["bytes"] = double(bytes);
+        const int runs = bytes <= 16 * 1024 * 1024 ? 3 : 1;
+
+        QVector<qint64> loads;
+        QVector<qint64> saves;
+        for (int i = 0; i < runs; ++i) {
+            QTextDocument document;
+            DocumentFile file(&document);
+            loads.append(timed([&]() { file.load(input); }));
+            saves.append(timed([&]() { file.save(output); }));
+        }
+        results->add("load_file", parameters, loads, bytes);
+        results->add("save_file", parameters, saves, bytes);
+        QFile::remove(input);
+        QFile::remove(output);
+    }
+}
+
+//main function
+//run the selected benchmarks and print the results as JSON
+int main(int argc, char *argv[])
+{
+    //text documents need a GUI application, but no display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("QtProject");
+    QCoreApplication::setApplicationName("Next Word Text Editor Benchmarks");
+    QCoreApplication::setApplicationVersion(QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QCoreApplication::applicationName());
+    parser.addHelpOption();
+    QCommandLineOption outputOption("output", "Write the JSON results to <file> instead of stdout.", "file");
+    QCommandLineOption sizeOption("max-file-size",
+                                  "Largest file loaded and saved, in MB (default 64, up to 1024).", "MB", "64");
+    QCommandLineOption filterOption("filter",
+                                    "Only run the groups named: dictionary, completion, highlight, search, project, file.",
+                                    "group");
+    parser.addOption(outputOption);
+    parser.addOption(sizeOption);
+    parser.addOption(filterOption);
+    parser.process(app);
+
+    const QStringList groups = parser.values(filterOption);
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        QTextStream(stderr) << "cannot create a temporary directory" << endl;
+        return 1;
+    }
+
+    BenchmarkResults results;
+    if (groups.isEmpty() || groups.contains("dictionary"))
+        benchmarkDictionaries(&results, directory.path());
+    if (groups.isEmpty() || groups.contains("completion"))
+        benchmarkCompletion(&results);
+    if (groups.isEmpty() || groups.contains("highlight"))
+        benchmarkHighlighting(&results);
+    if (groups.isEmpty() || groups.contains("search"))
+        benchmarkSearch(&results);
+    if (groups.isEmpty() || groups.contains("project"))
+        benchmarkProject(&results, directory.path());
+    if (groups.isEmpty() || groups.contains("file"))
+        benchmarkFiles(&results, directory.path(), parser.value(sizeOption).toLongLong() * 1024 * 1024);
+
+    const QByteArray json = results.document().toJson();
+    if (!parser.isSet(outputOption)) {
+        QFile out;
+        out.open(stdout, QFile::WriteOnly);
+        out.write(json);
+        return 0;
+    }
+    QFile out(parser.value(outputOption));
+    if (!out.open(QFile::WriteOnly) || out.write(json) != json.size()) {
+        QTextStream(stderr) << "cannot write " << out.fileName() << ": " << out.errorString() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * BlockData Class
+ * Per-block state shared by the editor services
+*/
+#include "blockdata.h"
+#include "documentvocabulary.h"
+
+#include <QTextBlock>
+
+//! [0]
+//! main function
+//! create data for a block that was not highlighted yet
+BlockData::BlockData()
+    : highlighted(false), vocabularyRevision(-1)
+{
+}
+
+//! a deleted block takes its terms and keys out of the vocabulary
+BlockData::~BlockData()
+{
+    if (vocabulary)
+        vocabulary->releaseBlock(*this);
+}
+//! [0]
+
+//! [1]
+//! function: of(param: text block)
+//! data attached to the block, null if there is none
+BlockData *BlockData::of(const QTextBlock &block)
+{
+    return static_cast<BlockData *>(block.userData());
+}
+//! [1]
@@ -0,0 +1,43 @@
+/*
+ * Header BlockData class
+ * Per-block state shared by the editor services
+*/
+
+#ifndef BLOCKDATA_H
+#define BLOCKDATA_H
+
+//import dependencies
+#include <QPointer>
+#include <QStringList>
+#include <QTextBlockUserData>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QTextBlock;
+QT_END_NAMESPACE
+class DocumentVocabulary;
+
+//! [0]
+//! User data attached to a text block, owned by the document.
+//! Blocks without data have not been highlighted yet.
+//! The terms and keys of a block stay counted in the DocumentVocabulary
+//! until the block is indexed again or deleted with its data.
+class BlockData : public QTextBlockUserData
+{
+    //set public methods & variables
+    public:
+        BlockData();
+        ~BlockData();
+
+        static BlockData *of(const QTextBlock &block);
+
+        bool highlighted;
+        int vocabularyRevision;                 // block revision the terms were read at
+        QVector<int> terms;                     // term ids in text order
+        QStringList labels;                     // keys of \label and \ref
+        QStringList citations;                  // keys of \bibitem and \cite
+        QPointer<DocumentVocabulary> vocabulary;
+};
+//! [0]
+
+#endif // BLOCKDATA_H
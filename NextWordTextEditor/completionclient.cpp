@@ -0,0 +1,100 @@
+/*
+ * CompletionClient Class
+ * Send queries to the completion server and read its answers
+*/
+#include "completionclient.h"
+#include "completionprotocol.h"
+#include "dictionarymanager.h"
+
+#include <QLocalSocket>
+
+//! [0]
+//! main function
+//! answers cross as queued arguments like those of the worker
+CompletionClient::CompletionClient(QObject *parent)
+    : QObject(parent), attached(false)
+{
+    qRegisterMetaType<CompletionMatches>();
+    socket = new QLocalSocket(this);
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readAnswers()));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(socketGone()));
+}
+//! [0]
+
+//! [1]
+//! function: attach(), isAttached()
+//! connect to a running server; a local socket connects at once or not at all
+bool CompletionClient::attach()
+{
+    if (attached)
+        return true;
+    const QString name = CompletionProtocol::serverName();
+    if (name.isEmpty())
+        return false;
+    socket->connectToServer(name);
+    attached = socket->waitForConnected(ConnectTimeoutMs);
+    if (!attached)
+        socket->abort();
+    return attached;
+}
+
+bool CompletionClient::isAttached() const
+{
+    return attached;
+}
+//! [1]
+
+//! [2]
+//! function: setLayers(param: list names, highest priority first),
+//! post(param: query), learn(param: previous word, word)
+//! written at once, never waiting for an answer; the layers are sent as
+//! their files, the server may not know lists added in this editor
+void CompletionClient::setLayers(const QStringList &layers)
+{
+    send(CompletionProtocol::layersFrame(DictionaryManager::instance()->layerFiles(layers)));
+}
+
+void CompletionClient::post(const CompletionQuery &query)
+{
+    send(CompletionProtocol::queryFrame(query));
+}
+
+void CompletionClient::learn(const QString &previousWord, const QString &word)
+{
+    send(CompletionProtocol::learnFrame(previousWord, word));
+}
+
+void CompletionClient::send(const QByteArray &frame)
+{
+    if (attached)
+        socket->write(frame);
+}
+//! [2]
+
+//! [3]
+//! function: readAnswers()
+//! every complete answer in the buffer, a broken stream detaches
+void CompletionClient::readAnswers()
+{
+    QByteArray frame;
+    bool invalid = false;
+    while (CompletionProtocol::takeFrame(socket, &frame, &invalid)) {
+        if (CompletionProtocol::message(frame) == CompletionProtocol::Matches)
+            emit finished(CompletionProtocol::readMatches(frame));
+    }
+    if (invalid) {
+        socket->abort();
+        socketGone();
+    }
+}
+
+//! function: socketGone()
+//! the server quit or the stream broke, stay detached
+void CompletionClient::socketGone()
+{
+    if (!attached)
+        return;
+    attached = false;
+    emit detached();
+}
+//! [3]
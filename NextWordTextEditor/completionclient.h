@@ -0,0 +1,60 @@
+/*
+ * Header CompletionClient class
+ * Editor side of the connection to the completion server
+*/
+
+#ifndef COMPLETIONCLIENT_H
+#define COMPLETIONCLIENT_H
+
+//import dependencies
+#include <QObject>
+#include <QStringList>
+#include "completionquery.h"
+
+QT_BEGIN_NAMESPACE
+class QLocalSocket;
+QT_END_NAMESPACE
+
+//! [0]
+//! Attaches to the completion server of the user if one is running. Queries
+//! and learned words are written as they are made, without waiting for the
+//! answers of earlier queries; answers are read as they arrive and handed
+//! on like those of a CompletionWorker, the model drops the stale ones.
+//! Once the server goes away the client stays detached and the editor
+//! falls back to its own dictionary.
+class CompletionClient : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const int ConnectTimeoutMs = 200;
+
+        CompletionClient(QObject *parent = 0);
+
+        bool attach();
+        bool isAttached() const;
+        void setLayers(const QStringList &layers);
+        void post(const CompletionQuery &query);
+        void learn(const QString &previousWord, const QString &word);
+
+    //set signals
+    signals:
+        void finished(const CompletionMatches &matches);
+        void detached();
+
+    //set private slots methods
+    private slots:
+        void readAnswers();
+        void socketGone();
+
+    //set private methods & variables
+    private:
+        void send(const QByteArray &frame);
+
+        QLocalSocket *socket;
+        bool attached;
+};
+//! [0]
+
+#endif // COMPLETIONCLIENT_H
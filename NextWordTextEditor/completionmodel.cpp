@@ -0,0 +1,531 @@
+/*
+ * CompletionModel Class
+ * Implement QAbstractListModel over the matches of a WordIndex
+*/
+#include "completionmodel.h"
+#include "completionworker.h"
+#include "completionclient.h"
+#include "learningstore.h"
+#include "documentvocabulary.h"
+#include "projectindex.h"
+
+#include <QThread>
+
+//! [0]
+//! main function
+CompletionModel::CompletionModel(QObject *parent)
+    : QAbstractListModel(parent), learning(0), documentTerms(0), projectTerms(0), markup(LatexCompletion::Text),
+      generation(0), fuzzy(false), worker(0), workerThread(0), server(0), snapshotDirty(true)
+{
+}
+
+//! the worker thread is stopped before the model goes away
+CompletionModel::~CompletionModel()
+{
+    if (workerThread) {
+        workerThread->quit();
+        workerThread->wait();
+    }
+}
+//! [0]
+
+//! [1]
+//! function: setDictionary(param: loaded dictionary)
+//! switch the completion data in one step, called once loading finished
+void CompletionModel::setDictionary(const QSharedPointer<Dictionary> &dictionary)
+{
+    words = dictionary;
+    //learned counters refer to entry ids of the previous dictionary
+    rebuildRanking();
+}
+
+QSharedPointer<Dictionary> CompletionModel::dictionary() const
+{
+    return words;
+}
+
+//! function: setLearningStore(param: per-user store)
+//! list learned words and replay their counts into the ranking
+void CompletionModel::setLearningStore(LearningStore *store)
+{
+    if (learning)
+        disconnect(learning, 0, this, 0);
+    learning = store;
+    if (learning)
+        connect(learning, SIGNAL(loaded()), this, SLOT(rebuildRanking()));
+    rebuildRanking();
+}
+
+//! function: setDocumentVocabulary(param: vocabulary of the edited document)
+//! complete and predict words of the document, read at every query
+void CompletionModel::setDocumentVocabulary(DocumentVocabulary *vocabulary)
+{
+    documentTerms = vocabulary;
+    updateMatches();
+}
+
+//! function: setProjectIndex(param: index of the open folder)
+//! also complete words of the other files of the folder
+void CompletionModel::setProjectIndex(ProjectIndex *index)
+{
+    projectTerms = index;
+    updateMatches();
+}
+//! [1]
+
+//! [2]
+//! function: setCompletionPrefix(param: string, word under cursor)
+//! replace the rows with the best ranked words starting with prefix
+void CompletionModel::setCompletionPrefix(const QString &completionPrefix)
+{
+    if (completionPrefix == prefix)
+        return;
+    const bool narrowing = canNarrow(completionPrefix);
+    prefix = completionPrefix;
+    if (narrowing)
+        narrowMatches();
+    else
+        updateMatches();
+}
+
+QString CompletionModel::completionPrefix() const
+{
+    return prefix;
+}
+//! [2]
+
+//! [3]
+//! function: setContext(param: string, word before the prefix)
+//! rank the predicted successors of previousWord first
+void CompletionModel::setContext(const QString &previousWord)
+{
+    if (previousWord == contextWord)
+        return;
+    contextWord = previousWord;
+    updateMatches();
+}
+
+QString CompletionModel::context() const
+{
+    return contextWord;
+}
+
+//! function: setQuery(param: previous word, typed prefix)
+//! set context and prefix with a single update
+void CompletionModel::setQuery(const QString &previousWord, const QString &completionPrefix)
+{
+    if (markup == LatexCompletion::Text && previousWord == contextWord) {
+        if (completionPrefix == prefix)
+            return;
+        //one more character typed: filter the rows instead of querying again
+        if (canNarrow(completionPrefix)) {
+            prefix = completionPrefix;
+            narrowMatches();
+            return;
+        }
+    }
+    markup = LatexCompletion::Text;
+    contextWord = previousWord;
+    prefix = completionPrefix;
+    updateMatches();
+}
+
+//! function: setLatexQuery(param: markup context, typed part of the name or key)
+//! list the commands, labels or citation keys instead of words,
+//! until the next setQuery
+void CompletionModel::setLatexQuery(LatexCompletion::Context context, const QString &completionPrefix)
+{
+    if (context == markup && completionPrefix == prefix)
+        return;
+    markup = context;
+    prefix = completionPrefix;
+    updateMatches();
+}
+
+LatexCompletion::Context CompletionModel::latexContext() const
+{
+    return markup;
+}
+
+//! function: predictionCount()
+//! number of rows predicted from the context word
+int CompletionModel::predictionCount() const
+{
+    return matches.predictedRows;
+}
+//! [3]
+
+//! [4]
+//! function: recordCompletion(param: string, accepted completion)
+//! learn the accepted word and, with a context, the accepted bigram
+//! the affected row moves up, all other rows stay as they are
+void CompletionModel::recordCompletion(const QString &completion)
+{
+    learn(contextWord, completion);
+    //rows of a dictionary replaced meanwhile are left alone
+    if (!words || matches.words != words)
+        return;
+
+    const int id = words->wordIndex().find(completion);
+    const int row = findRow(Row::Indexed, id);
+    if (row > matches.predictedRows) {
+        int target = row;
+        while (target > matches.predictedRows && matches.rows.at(target - 1).source == Row::Indexed
+               && ranking.wordLessThan(id, matches.rows.at(target - 1).id))
+            --target;
+        moveRow(row, target);
+    }
+
+    const NextWordPredictor &nextWords = words->predictor();
+    const int head = nextWords.tokenId(contextWord);
+    const int tail = nextWords.tokenId(completion);
+    const int predictedRow = findRow(Row::Predicted, tail);
+    if (head >= 0 && predictedRow > 0) {
+        const double score = ranking.bigramScore(head, tail);
+        int target = predictedRow;
+        while (target > 0 && matches.rows.at(target - 1).source == Row::Predicted
+               && score > ranking.bigramScore(head, matches.rows.at(target - 1).id))
+            --target;
+        moveRow(predictedRow, target);
+    }
+}
+
+//! function: recordTypedWord(param: previous word, finished word)
+//! learn a word typed without the completer
+void CompletionModel::recordTypedWord(const QString &previousWord, const QString &word)
+{
+    learn(previousWord, word);
+}
+
+const UsageRanking &CompletionModel::usageRanking() const
+{
+    return ranking;
+}
+//! [4]
+
+//! [5]
+//! implement rowCount & data from QAbstractListModel
+//! predicted rows come before the prefix matches;
+//! commands are shown with their backslash, which is already typed
+int CompletionModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : matches.rows.size();
+}
+
+QVariant CompletionModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= matches.rows.size())
+        return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+        return QVariant();
+    const Row &row = matches.rows.at(index.row());
+    if (row.source == Row::Command && role == Qt::DisplayRole)
+        return QString(QLatin1String("\\") + LatexCompletion::command(row.id));
+    return matches.text(row);
+}
+//! [5]
+
+//! [6]
+//! function: updateMatches()
+//! query the sources for the context and prefix: LaTeX queries and queries
+//! without a worker are answered at once, others when the worker or the
+//! completion server is done
+void CompletionModel::updateMatches()
+{
+    ++generation;
+    if (markup != LatexCompletion::Text) {
+        beginResetModel();
+        matches = CompletionMatches();
+        matches.generation = generation;
+        updateLatexMatches();
+        endResetModel();
+        return;
+    }
+
+    CompletionQuery query;
+    query.generation = generation;
+    query.contextWord = contextWord;
+    query.prefix = prefix;
+    query.fuzzy = fuzzy;
+    const bool served = isServed();
+    //the document changes on the GUI thread, its few matches are taken along
+    if (documentTerms && (words || served)) {
+        if (!contextWord.isEmpty())
+            query.documentPredictions = documentTerms->predict(contextWord, prefix, CompletionQuery::DocumentMatches);
+        if (!prefix.isEmpty())
+            query.documentCompletions = documentTerms->complete(prefix, CompletionQuery::DocumentMatches);
+    }
+    if (projectTerms && (words || served) && !prefix.isEmpty())
+        query.projectCompletions = projectTerms->complete(prefix, CompletionQuery::ProjectMatches);
+
+    if (served) {
+        server->post(query);
+        return;
+    }
+    if (!worker) {
+        setMatches(query.run(snapshot()));
+        return;
+    }
+    if (snapshotDirty) {
+        worker->publish(std::make_shared<const CompletionSnapshot>(snapshot()));
+        snapshotDirty = false;
+    }
+    worker->post(query);
+}
+
+//! function: setMatches(param: answered query)
+//! show the rows of the query, unless a newer query was made meanwhile
+void CompletionModel::setMatches(const CompletionMatches &answered)
+{
+    if (answered.generation != generation)
+        return;
+    beginResetModel();
+    matches = answered;
+    endResetModel();
+}
+
+//! function: workerFinished(param: answered query)
+//! called on the GUI thread when the worker answered a query
+void CompletionModel::workerFinished(const CompletionMatches &answered)
+{
+    if (answered.generation != generation)
+        return;
+    setMatches(answered);
+    emit matchesReady();
+}
+
+//! function: isPending()
+//! true while the rows are older than the last query
+bool CompletionModel::isPending() const
+{
+    return matches.generation != generation;
+}
+//! [6]
+
+//! [7]
+//! function: moveRow(param: source row, destination row above it)
+//! move a single row up, keeping the rest of the model untouched
+void CompletionModel::moveRow(int from, int to)
+{
+    if (to >= from)
+        return;
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
+    matches.rows.move(from, to);
+    endMoveRows();
+}
+//! [7]
+
+//! [8]
+//! function: rebuildRanking()
+//! replay the learned counts into the usage ranking of the dictionary
+//! called when the dictionary or the learned data changes
+void CompletionModel::rebuildRanking()
+{
+    snapshotDirty = true;
+    ranking.clear();
+    if (words && learning) {
+        const WordIndex &prefixIndex = words->wordIndex();
+        const NextWordPredictor &nextWords = words->predictor();
+        const LearningStore::Counts &counts = learning->counts();
+        foreach (const LearningStore::Learned &learned, counts.words) {
+            const int id = prefixIndex.find(learned.word);
+            if (id >= 0)
+                ranking.recordWord(id, learned.count);
+        }
+        for (QHash<QString, QMap<QString, LearningStore::Learned> >::const_iterator it = counts.bigrams.constBegin();
+             it != counts.bigrams.constEnd(); ++it) {
+            const int head = nextWords.tokenId(it.key());
+            if (head < 0)
+                continue;
+            foreach (const LearningStore::Learned &learned, it.value()) {
+                const int tail = nextWords.tokenId(learned.word);
+                if (tail >= 0)
+                    ranking.recordBigram(head, tail, learned.count);
+            }
+        }
+    }
+    updateMatches();
+}
+//! [8]
+
+//! [9]
+//! function: findRow(param: source, id)
+//! row bookkeeping, returns -1 if the row is not listed
+int CompletionModel::findRow(Row::Source source, int id) const
+{
+    for (int i = 0; i < matches.rows.size(); ++i) {
+        if (matches.rows.at(i).source == source && matches.rows.at(i).id == id)
+            return i;
+    }
+    return -1;
+}
+//! [9]
+
+//! [10]
+//! function: learn(param: previous word, word)
+//! count the word and the bigram in the ranking and persist them,
+//! or have the completion server do so
+void CompletionModel::learn(const QString &previousWord, const QString &word)
+{
+    //the server keeps the one store of the user
+    if (isServed()) {
+        server->learn(previousWord, word);
+        return;
+    }
+    snapshotDirty = true;
+    if (learning) {
+        learning->recordWord(word);
+        if (!previousWord.isEmpty())
+            learning->recordBigram(previousWord, word);
+    }
+    if (!words)
+        return;
+
+    const int id = words->wordIndex().find(word);
+    if (id >= 0)
+        ranking.recordWord(id);
+    const int head = words->predictor().tokenId(previousWord);
+    const int tail = words->predictor().tokenId(word);
+    if (head >= 0 && tail >= 0)
+        ranking.recordBigram(head, tail);
+}
+//! [10]
+
+//! [11]
+//! function: setFuzzy(param: bool), isFuzzy()
+//! also list entries within a small edit distance of the prefix
+void CompletionModel::setFuzzy(bool enabled)
+{
+    if (enabled == fuzzy)
+        return;
+    fuzzy = enabled;
+    updateMatches();
+}
+
+bool CompletionModel::isFuzzy() const
+{
+    return fuzzy;
+}
+//! [11]
+
+//! [12]
+//! function: updateLatexMatches()
+//! fill the rows from the index of the LaTeX context, called by updateMatches
+void CompletionModel::updateLatexMatches()
+{
+    if (markup == LatexCompletion::Command) {
+        foreach (int id, LatexCompletion::commands(prefix, CompletionQuery::MaxMatches))
+            matches.append(Row::Command, id);
+        return;
+    }
+    if (!documentTerms)
+        return;
+    matches.documentWords = markup == LatexCompletion::Label
+            ? documentTerms->labels(prefix, CompletionQuery::MaxMatches)
+            : documentTerms->citations(prefix, CompletionQuery::MaxMatches);
+    for (int i = 0; i < matches.documentWords.size(); ++i)
+        matches.append(Row::Document, i);
+}
+//! [12]
+
+//! [13]
+//! function: canNarrow(param: new prefix), narrowMatches()
+//! a prefix extending the current one matches a subset of exhaustive rows,
+//! in the same order; fuzzy rows are not a subset and are queried again
+bool CompletionModel::canNarrow(const QString &completionPrefix) const
+{
+    return matches.exhaustive && !isPending() && markup == LatexCompletion::Text
+            && completionPrefix.size() > prefix.size()
+            && completionPrefix.toCaseFolded().startsWith(prefix.toCaseFolded())
+            && (!fuzzy || completionPrefix.size() < CompletionQuery::FuzzyMinimumLength);
+}
+
+void CompletionModel::narrowMatches()
+{
+    const QString folded = prefix.toCaseFolded();
+    beginResetModel();
+    int kept = 0;
+    int keptPredicted = 0;
+    for (int i = 0; i < matches.rows.size(); ++i) {
+        const Row row = matches.rows.at(i);
+        const QString word = matches.text(row).toCaseFolded();
+        //the document and the folder never suggest the word being typed itself
+        if (!word.startsWith(folded)
+                || ((row.source == Row::Document || row.source == Row::Project) && word.size() == folded.size()))
+            continue;
+        if (i < matches.predictedRows)
+            ++keptPredicted;
+        matches.rows[kept++] = row;
+    }
+    matches.rows.resize(kept);
+    matches.predictedRows = keptPredicted;
+    matches.generation = ++generation;
+    endResetModel();
+}
+//! [13]
+
+//! [14]
+//! function: snapshot()
+//! copy of the query inputs; the copies share their data until the GUI
+//! thread changes the ranking or the learned counts again
+CompletionSnapshot CompletionModel::snapshot() const
+{
+    CompletionSnapshot copy;
+    copy.words = words;
+    copy.ranking = ranking;
+    if (learning)
+        copy.learned = learning->counts();
+    return copy;
+}
+//! [14]
+
+//! [15]
+//! function: setBackgroundQueries(param: bool)
+//! answer word queries on a worker thread instead of the calling thread
+void CompletionModel::setBackgroundQueries(bool enabled)
+{
+    if (enabled == (worker != 0))
+        return;
+    if (enabled) {
+        workerThread = new QThread(this);
+        worker = new CompletionWorker;
+        worker->moveToThread(workerThread);
+        connect(worker, SIGNAL(finished(CompletionMatches)), this, SLOT(workerFinished(CompletionMatches)));
+        connect(workerThread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+        workerThread->start();
+        snapshotDirty = true;
+        return;
+    }
+    workerThread->quit();
+    workerThread->wait();
+    delete workerThread;
+    workerThread = 0;
+    worker = 0;
+    //a query still out is answered here instead
+    if (isPending())
+        updateMatches();
+}
+//! [15]
+
+//! [16]
+//! function: setCompletionClient(param: attached client, 0 to detach)
+//! answer word queries by the completion server; a query still out when
+//! the client is dropped is answered here instead
+void CompletionModel::setCompletionClient(CompletionClient *client)
+{
+    if (client == server)
+        return;
+    if (server)
+        disconnect(server, 0, this, 0);
+    server = client;
+    if (server)
+        connect(server, SIGNAL(finished(CompletionMatches)), this, SLOT(workerFinished(CompletionMatches)));
+    if (isPending() || isServed())
+        updateMatches();
+}
+
+bool CompletionModel::isServed() const
+{
+    return server && server->isAttached();
+}
+//! [16]
@@ -0,0 +1,129 @@
+/*
+ * Header CompletionModel class
+ * Item model feeding the QCompleter popup from a WordIndex
+*/
+
+#ifndef COMPLETIONMODEL_H
+#define COMPLETIONMODEL_H
+
+//import dependencies
+#include <QAbstractListModel>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+#include "completionquery.h"
+#include "dictionary.h"
+#include "latexcompletion.h"
+#include "usageranking.h"
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+class LearningStore;
+class DocumentVocabulary;
+class ProjectIndex;
+class CompletionWorker;
+class CompletionClient;
+
+//! [0]
+//! Only the current matches are exposed as rows, the completer is used in
+//! unfiltered mode so it never scans the dictionary itself.
+//! When a context word is set, its predicted successors come first.
+//! Until a dictionary is set the model is simply empty.
+//! Accepted completions are learned by a UsageRanking; recording one only
+//! moves the affected row instead of rebuilding the rows.
+//! Words and bigrams of the LearningStore that the dictionary does not know
+//! are listed before the dictionary rows of the same kind.
+//! Words of the open document follow the learned ones, in both lists; the
+//! words of the files of an open folder follow them among the completions.
+//! In fuzzy mode, prefixes of 3 characters or more are followed by the
+//! entries within 1 edit (2 from 6 characters on) of the prefix.
+//! While the prefix grows and no source was cut off at its limit, the rows
+//! of the shorter prefix are filtered instead of querying every source again.
+//! With background queries a word query is answered by a CompletionWorker
+//! from a snapshot of the dictionary, ranking and learned counts, published
+//! again whenever one of them changed. The rows are replaced once the
+//! answer to the latest query arrives, answers to older ones are dropped.
+//! While a CompletionClient is attached, word queries and learned words go
+//! to the completion server instead, which ranks them with its own
+//! dictionary and learned words; the model needs no dictionary of its own.
+//! A LaTeX query replaces all of this by the rows of its own context:
+//! command names, or the labels or citation keys of the document.
+class CompletionModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        CompletionModel(QObject *parent = 0);
+        ~CompletionModel();
+
+        void setDictionary(const QSharedPointer<Dictionary> &dictionary);
+        QSharedPointer<Dictionary> dictionary() const;
+        void setLearningStore(LearningStore *store);
+        void setDocumentVocabulary(DocumentVocabulary *vocabulary);
+        void setProjectIndex(ProjectIndex *index);
+
+        void setContext(const QString &previousWord);
+        QString context() const;
+        void setQuery(const QString &previousWord, const QString &completionPrefix);
+        void setLatexQuery(LatexCompletion::Context context, const QString &completionPrefix);
+        LatexCompletion::Context latexContext() const;
+        int predictionCount() const;
+        void setCompletionPrefix(const QString &prefix);
+        QString completionPrefix() const;
+        void setFuzzy(bool enabled);
+        bool isFuzzy() const;
+        void setBackgroundQueries(bool enabled);
+        void setCompletionClient(CompletionClient *client);
+        bool isServed() const;
+        bool isPending() const;
+        void recordCompletion(const QString &completion);
+        void recordTypedWord(const QString &previousWord, const QString &word);
+        const UsageRanking &usageRanking() const;
+        CompletionSnapshot snapshot() const;
+
+        int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+        QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+
+    //set signals
+    signals:
+        void matchesReady();
+
+    //set private slots methods
+    private slots:
+        void rebuildRanking();
+        void workerFinished(const CompletionMatches &answered);
+
+    //set private methods & variables
+    private:
+        typedef CompletionMatches::Row Row;
+
+        void updateMatches();
+        void setMatches(const CompletionMatches &answered);
+        void updateLatexMatches();
+        bool canNarrow(const QString &completionPrefix) const;
+        void narrowMatches();
+        void learn(const QString &previousWord, const QString &word);
+        int findRow(Row::Source source, int id) const;
+        void moveRow(int from, int to);
+
+        QSharedPointer<Dictionary> words;
+        LearningStore *learning;
+        DocumentVocabulary *documentTerms;
+        ProjectIndex *projectTerms;
+        UsageRanking ranking;
+        QString contextWord;
+        QString prefix;
+        LatexCompletion::Context markup;
+        CompletionMatches matches;
+        int generation;     // of the latest query
+        bool fuzzy;
+        CompletionWorker *worker;
+        QThread *workerThread;
+        CompletionClient *server;   // attached completion server, answers word queries instead
+        bool snapshotDirty; // ranking or learned counts changed since the last publish
+};
+//! [0]
+
+#endif // COMPLETIONMODEL_H
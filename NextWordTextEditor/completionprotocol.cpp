@@ -0,0 +1,252 @@
+/*
+ * CompletionProtocol Class
+ * Write and read the frames of the completion server
+*/
+#include "completionprotocol.h"
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+//bytes of the length in front of every frame, and of the message after it
+const int LengthSize = 4;
+const int HeaderSize = 5;
+
+//the length and message in front of the fields
+QByteArray frame(CompletionProtocol::Message message, const QByteArray &fields)
+{
+    QByteArray header(HeaderSize, Qt::Uninitialized);
+    qToBigEndian(quint32(HeaderSize - LengthSize + fields.size()), reinterpret_cast<uchar *>(header.data()));
+    header[LengthSize] = char(message);
+    return header + fields;
+}
+
+void writeText(QDataStream &out, const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8().left(0xffff);
+    out << quint16(utf8.size());
+    out.writeRawData(utf8.constData(), utf8.size());
+}
+
+QString readText(QDataStream &in)
+{
+    quint16 size = 0;
+    in >> size;
+    QByteArray utf8(size, Qt::Uninitialized);
+    if (in.readRawData(utf8.data(), size) != size) {
+        in.setStatus(QDataStream::ReadPastEnd);
+        return QString();
+    }
+    return QString::fromUtf8(utf8);
+}
+
+void writeList(QDataStream &out, const QStringList &list)
+{
+    const int count = qMin(list.size(), 0xffff);
+    out << quint16(count);
+    for (int i = 0; i < count; ++i)
+        writeText(out, list.at(i));
+}
+
+QStringList readList(QDataStream &in)
+{
+    quint16 count = 0;
+    in >> count;
+    QStringList list;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+        list << readText(in);
+    return list;
+}
+
+} // namespace
+
+//! [0]
+//! function: serverName()
+//! one server per user: the learned words are the user's own, and the
+//! dictionary images are shared between users through the page cache anyway;
+//! the socket lives in the runtime directory of the user, which no other
+//! user can enter, so nobody else can take the name first. Empty when there
+//! is no such directory, there is no server then
+QString CompletionProtocol::serverName()
+{
+#ifdef Q_OS_UNIX
+    const QString runtime = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtime.isEmpty())
+        return QString();
+    const QFileInfo directory(runtime);
+    const QFile::Permissions shared = QFile::ReadGroup | QFile::WriteGroup | QFile::ExeGroup
+            | QFile::ReadOther | QFile::WriteOther | QFile::ExeOther;
+    if (!directory.isDir() || directory.ownerId() != uint(::getuid()) || (directory.permissions() & shared))
+        return QString();
+    return directory.absoluteFilePath() + QLatin1String("/NextWordTextEditor-completion");
+#else
+    return QString();
+#endif
+}
+//! [0]
+
+//! [1]
+//! function: layersFrame(param: files of the layers), queryFrame(param: query),
+//! learnFrame(param: previous word, word), matchesFrame(param: answer)
+//! encode one message; the words of a query are all sent along
+QByteArray CompletionProtocol::layersFrame(const QStringList &fileNames)
+{
+    QByteArray fields;
+    QDataStream out(&fields, QIODevice::WriteOnly);
+    writeList(out, fileNames);
+    return frame(Layers, fields);
+}
+
+QByteArray CompletionProtocol::queryFrame(const CompletionQuery &query)
+{
+    QByteArray fields;
+    QDataStream out(&fields, QIODevice::WriteOnly);
+    out << quint32(query.generation) << quint8(query.fuzzy);
+    writeText(out, query.contextWord);
+    writeText(out, query.prefix);
+    writeList(out, query.documentPredictions);
+    writeList(out, query.documentCompletions);
+    writeList(out, query.projectCompletions);
+    return frame(Query, fields);
+}
+
+QByteArray CompletionProtocol::learnFrame(const QString &previousWord, const QString &word)
+{
+    QByteArray fields;
+    QDataStream out(&fields, QIODevice::WriteOnly);
+    writeText(out, previousWord);
+    writeText(out, word);
+    return frame(Learn, fields);
+}
+
+QByteArray CompletionProtocol::matchesFrame(const CompletionMatches &matches)
+{
+    QByteArray fields;
+    QDataStream out(&fields, QIODevice::WriteOnly);
+    const int count = qMin(matches.rows.size(), 0xffff);
+    out << quint32(matches.generation) << quint8(matches.exhaustive)
+         << quint16(qMin(matches.predictedRows, count)) << quint16(count);
+    for (int i = 0; i < count; ++i) {
+        const CompletionMatches::Row &row = matches.rows.at(i);
+        out << quint8(row.source);
+        writeText(out, matches.text(row));
+    }
+    return frame(Matches, fields);
+}
+//! [1]
+
+//! [2]
+//! function: takeFrame(param: socket, frame read, set when the peer is broken)
+//! read the next frame if it is complete, leave a partial one buffered
+bool CompletionProtocol::takeFrame(QIODevice *device, QByteArray *frame, bool *invalid)
+{
+    *invalid = false;
+    if (device->bytesAvailable() < LengthSize)
+        return false;
+    const QByteArray length = device->peek(LengthSize);
+    const quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(length.constData()));
+    if (size < quint32(HeaderSize - LengthSize) || size > quint32(MaxFrameSize)) {
+        *invalid = true;
+        return false;
+    }
+    if (device->bytesAvailable() < LengthSize + qint64(size))
+        return false;
+    *frame = device->read(LengthSize + size);
+    return true;
+}
+
+CompletionProtocol::Message CompletionProtocol::message(const QByteArray &frame)
+{
+    return Message(quint8(frame.at(LengthSize)));
+}
+//! [2]
+
+//! [3]
+//! function: readLayers(param: frame), readQuery(param: frame),
+//! readLearn(param: frame), readMatches(param: frame)
+//! decode one message; fields missing from a short frame are left empty
+QStringList CompletionProtocol::readLayers(const QByteArray &frame)
+{
+    QDataStream in(frame);
+    in.skipRawData(HeaderSize);
+    return readList(in);
+}
+
+CompletionQuery CompletionProtocol::readQuery(const QByteArray &frame)
+{
+    QDataStream in(frame);
+    in.skipRawData(HeaderSize);
+    quint32 generation = 0;
+    quint8 fuzzy = 0;
+    in >> generation >> fuzzy;
+    CompletionQuery query;
+    query.generation = int(generation);
+    query.fuzzy = fuzzy;
+    query.contextWord = readText(in);
+    query.prefix = readText(in);
+    query.documentPredictions = readList(in);
+    query.documentCompletions = readList(in);
+    query.projectCompletions = readList(in);
+    return query;
+}
+
+//! the previous word and the word, in this order
+QStringList CompletionProtocol::readLearn(const QByteArray &frame)
+{
+    QDataStream in(frame);
+    in.skipRawData(HeaderSize);
+    QStringList words;
+    words << readText(in);
+    words << readText(in);
+    return words;
+}
+
+//! rows of the other sources keep their source, dictionary rows are served
+CompletionMatches CompletionProtocol::readMatches(const QByteArray &frame)
+{
+    QDataStream in(frame);
+    in.skipRawData(HeaderSize);
+    quint32 generation = 0;
+    quint8 exhaustive = 0;
+    quint16 predictedRows = 0;
+    quint16 count = 0;
+    in >> generation >> exhaustive >> predictedRows >> count;
+    CompletionMatches matches;
+    matches.generation = int(generation);
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint8 source = 0;
+        in >> source;
+        const QString text = readText(in);
+        switch (source) {
+        case CompletionMatches::Row::Learned:
+            matches.learnedWords.append(text);
+            matches.append(CompletionMatches::Row::Learned, matches.learnedWords.size() - 1);
+            break;
+        case CompletionMatches::Row::Document:
+            matches.documentWords.append(text);
+            matches.append(CompletionMatches::Row::Document, matches.documentWords.size() - 1);
+            break;
+        case CompletionMatches::Row::Project:
+            matches.projectWords.append(text);
+            matches.append(CompletionMatches::Row::Project, matches.projectWords.size() - 1);
+            break;
+        default:
+            matches.servedWords.append(text);
+            matches.append(CompletionMatches::Row::Served, matches.servedWords.size() - 1);
+            break;
+        }
+    }
+    matches.predictedRows = qMin(int(predictedRows), matches.rows.size());
+    //a frame cut short is not the whole answer
+    matches.exhaustive = exhaustive && in.status() == QDataStream::Ok;
+    return matches;
+}
+//! [3]
@@ -0,0 +1,52 @@
+/*
+ * Header CompletionProtocol class
+ * Frames exchanged between the editors and the completion server
+*/
+
+#ifndef COMPLETIONPROTOCOL_H
+#define COMPLETIONPROTOCOL_H
+
+//import dependencies
+#include <QByteArray>
+#include <QStringList>
+#include "completionquery.h"
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+//! [0]
+//! The socket is a path in the runtime directory of the user (owned by the
+//! user, mode 0700), on Unix only.
+//! Every frame is a 32-bit length, a message byte and the fields of the
+//! message; numbers are big endian and text is UTF-8 behind a 16-bit length.
+//! A client selects its dictionary once by the word list files of its
+//! layers, then sends queries and learned words without waiting for answers. The server answers the
+//! queries of a connection in the order they were sent, each answer
+//! carrying the generation of its query, and never answers Learn frames.
+//! Dictionary rows cross as their text and come back as Served rows.
+class CompletionProtocol
+{
+    //set public methods & variables
+    public:
+        enum Message { Layers = 1, Query, Learn, Matches };
+
+        static const int MaxFrameSize = 1024 * 1024;    // larger frames break the connection
+
+        static QString serverName();
+
+        static QByteArray layersFrame(const QStringList &fileNames);
+        static QByteArray queryFrame(const CompletionQuery &query);
+        static QByteArray learnFrame(const QString &previousWord, const QString &word);
+        static QByteArray matchesFrame(const CompletionMatches &matches);
+
+        static bool takeFrame(QIODevice *device, QByteArray *frame, bool *invalid);
+        static Message message(const QByteArray &frame);
+        static QStringList readLayers(const QByteArray &frame);
+        static CompletionQuery readQuery(const QByteArray &frame);
+        static QStringList readLearn(const QByteArray &frame);
+        static CompletionMatches readMatches(const QByteArray &frame);
+};
+//! [0]
+
+#endif // COMPLETIONPROTOCOL_H
@@ -0,0 +1,201 @@
+/*
+ * CompletionQuery Class
+ * Rank the predictions and completions of a prefix from a snapshot
+*/
+#include "completionquery.h"
+#include "latexcompletion.h"
+
+#include <QSet>
+#include <algorithm>
+
+//the index answers a query from the best entries kept per trie node
+Q_STATIC_ASSERT(CompletionQuery::MaxMatches <= WordIndex::BestCount);
+
+namespace {
+
+//matches of one source, noting whether its limit cut them off
+template <typename List>
+List uncut(const List &matches, int limit, bool *exhaustive)
+{
+    if (matches.size() >= limit)
+        *exhaustive = false;
+    return matches;
+}
+
+} // namespace
+
+//! [0]
+//! main function
+//! empty matches of no query
+CompletionMatches::CompletionMatches()
+    : generation(0), predictedRows(0), exhaustive(false)
+{
+}
+
+//! function: append(param: source, id)
+void CompletionMatches::append(Row::Source source, int id)
+{
+    Row row;
+    row.source = source;
+    row.id = id;
+    rows.append(row);
+}
+
+//! function: text(param: row)
+//! the text a row completes to
+QString CompletionMatches::text(const Row &row) const
+{
+    switch (row.source) {
+    case Row::Predicted:
+        return words->predictor().token(row.id);
+    case Row::Indexed:
+        return words->wordIndex().word(row.id);
+    case Row::Learned:
+        return learnedWords.at(row.id);
+    case Row::Document:
+        return documentWords.at(row.id);
+    case Row::Project:
+        return projectWords.at(row.id);
+    case Row::Command:
+        return LatexCompletion::command(row.id);
+    case Row::Served:
+        return servedWords.at(row.id);
+    }
+    return QString();
+}
+//! [0]
+
+//! [1]
+//! main function
+CompletionQuery::CompletionQuery()
+    : generation(0), fuzzy(false)
+{
+}
+//! [1]
+
+//! [2]
+//! function: run(param: snapshot to read)
+//! query the predictor for the context and the index for the prefix
+//! learned words come first, then words of the document and of the open
+//! folder, then used entries, then the static order
+//! the rows are exhaustive if no source was cut off at its limit
+CompletionMatches CompletionQuery::run(const CompletionSnapshot &snapshot) const
+{
+    CompletionMatches matches;
+    matches.generation = generation;
+    matches.words = snapshot.words;
+    if (!snapshot.words)
+        return matches;
+    //without a prefix there are no completions to filter later
+    matches.exhaustive = !prefix.isEmpty();
+
+    const NextWordPredictor &nextWords = snapshot.words->predictor();
+    const WordIndex &prefixIndex = snapshot.words->wordIndex();
+    const UsageRanking &ranking = snapshot.ranking;
+    QVector<CompletionMatches::Row> &rows = matches.rows;
+    QSet<QString> shown;
+
+    //successors of the context word
+    if (!contextWord.isEmpty()) {
+        foreach (const LearningStore::Learned &learned,
+                 uncut(LearningStore::predict(snapshot.learned, contextWord, prefix, MaxMatches),
+                       MaxMatches, &matches.exhaustive)) {
+            if (!shown.contains(learned.word.toCaseFolded())) {
+                shown.insert(learned.word.toCaseFolded());
+                matches.learnedWords.append(learned.word);
+                matches.append(CompletionMatches::Row::Learned, matches.learnedWords.size() - 1);
+            }
+        }
+        foreach (const QString &word, uncut(documentPredictions, DocumentMatches, &matches.exhaustive)) {
+            if (!shown.contains(word.toCaseFolded())) {
+                shown.insert(word.toCaseFolded());
+                matches.documentWords.append(word);
+                matches.append(CompletionMatches::Row::Document, matches.documentWords.size() - 1);
+            }
+        }
+        const int head = nextWords.tokenId(contextWord);
+        QVector<int> predictions = uncut(nextWords.predict(contextWord, prefix, MaxMatches),
+                                         MaxMatches, &matches.exhaustive);
+        if (!ranking.isEmpty()) {
+            std::stable_sort(predictions.begin(), predictions.end(), [&](int a, int b) {
+                return ranking.bigramScore(head, a) > ranking.bigramScore(head, b);
+            });
+        }
+        foreach (int id, predictions) {
+            const QString folded = nextWords.token(id).toCaseFolded();
+            if (rows.size() < MaxMatches && !shown.contains(folded)) {
+                shown.insert(folded);
+                matches.append(CompletionMatches::Row::Predicted, id);
+            }
+        }
+        matches.predictedRows = rows.size();
+    }
+
+    //words starting with the prefix
+    int begin, end;
+    if (!prefix.isEmpty() && rows.size() < MaxMatches) {
+        foreach (const LearningStore::Learned &learned,
+                 uncut(LearningStore::completeWords(snapshot.learned, prefix, MaxMatches),
+                       MaxMatches, &matches.exhaustive)) {
+            const QString folded = learned.word.toCaseFolded();
+            //known words are ranked through the usage counters instead
+            if (rows.size() < MaxMatches && !shown.contains(folded) && prefixIndex.find(learned.word) < 0) {
+                shown.insert(folded);
+                matches.learnedWords.append(learned.word);
+                matches.append(CompletionMatches::Row::Learned, matches.learnedWords.size() - 1);
+            }
+        }
+        foreach (const QString &word, uncut(documentCompletions, DocumentMatches, &matches.exhaustive)) {
+            const QString folded = word.toCaseFolded();
+            if (rows.size() < MaxMatches && !shown.contains(folded)) {
+                shown.insert(folded);
+                matches.documentWords.append(word);
+                matches.append(CompletionMatches::Row::Document, matches.documentWords.size() - 1);
+            }
+        }
+        foreach (const QString &word, uncut(projectCompletions, ProjectMatches, &matches.exhaustive)) {
+            const QString folded = word.toCaseFolded();
+            if (rows.size() < MaxMatches && !shown.contains(folded)) {
+                shown.insert(folded);
+                matches.projectWords.append(word);
+                matches.append(CompletionMatches::Row::Project, matches.projectWords.size() - 1);
+            }
+        }
+        if (prefixIndex.prefixRange(prefix, &begin, &end)) {
+            QVector<int> candidates = ranking.usedWords(begin, end);
+            QSet<int> used;
+            foreach (int id, candidates)
+                used.insert(id);
+            foreach (int id, uncut(prefixIndex.complete(prefix, MaxMatches), MaxMatches, &matches.exhaustive)) {
+                if (!used.contains(id))
+                    candidates.append(id);
+            }
+            foreach (int id, candidates) {
+                if (rows.size() >= MaxMatches)
+                    break;
+                const QString folded = prefixIndex.word(id).toCaseFolded();
+                if (!shown.contains(folded)) {
+                    shown.insert(folded);
+                    matches.append(CompletionMatches::Row::Indexed, id);
+                }
+            }
+        }
+        //then entries a typo or two away, closest and best ranked first
+        if (fuzzy && prefix.length() >= FuzzyMinimumLength && rows.size() < MaxMatches) {
+            const int maxDistance = prefix.length() >= FuzzyTwoEditLength ? 2 : 1;
+            foreach (const WordIndex::FuzzyMatch &match, prefixIndex.fuzzyComplete(prefix, maxDistance, MaxMatches)) {
+                if (rows.size() >= MaxMatches)
+                    break;
+                const QString folded = prefixIndex.word(match.id).toCaseFolded();
+                if (match.distance > 0 && !shown.contains(folded)) {
+                    shown.insert(folded);
+                    matches.append(CompletionMatches::Row::Indexed, match.id);
+                }
+            }
+        }
+    }
+    if (rows.size() >= MaxMatches)
+        matches.exhaustive = false;
+    return matches;
+}
+//! [2]
@@ -0,0 +1,101 @@
+/*
+ * Header CompletionQuery class
+ * One word completion query, answered from an immutable snapshot
+*/
+
+#ifndef COMPLETIONQUERY_H
+#define COMPLETIONQUERY_H
+
+//import dependencies
+#include <QMetaType>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+#include "dictionary.h"
+#include "learningstore.h"
+#include "usageranking.h"
+
+//! [0]
+//! Everything a query reads besides the document: the dictionary and copies
+//! of the usage ranking and the learned counts. A published snapshot is
+//! never modified, a change publishes a new one, so it can be read by the
+//! completion worker without any lock.
+struct CompletionSnapshot
+{
+    QSharedPointer<Dictionary> words;
+    UsageRanking ranking;
+    LearningStore::Counts learned;
+};
+//! [0]
+
+//! [1]
+//! Rows of a query in display order, tagged with the generation of the
+//! query. Rows refer to the dictionary of the snapshot and to the word lists
+//! carried along; the rows of a completion server carry their text instead.
+class CompletionMatches
+{
+    //set public methods & variables
+    public:
+        struct Row
+        {
+            enum Source { Predicted, Indexed, Learned, Document, Project, Command, Served };
+            Source source;
+            int id;     // token id, entry id, index in learnedWords, documentWords, projectWords
+                        // or servedWords, command id
+        };
+
+        CompletionMatches();
+
+        void append(Row::Source source, int id);
+        QString text(const Row &row) const;
+
+        int generation;
+        QSharedPointer<Dictionary> words;   // dictionary the ids refer to
+        QVector<Row> rows;
+        QStringList learnedWords;
+        QStringList documentWords;
+        QStringList projectWords;
+        QStringList servedWords;            // dictionary rows answered by the completion server
+        int predictedRows;
+        bool exhaustive;    // no source was cut off at its limit
+};
+//! [1]
+
+//! [2]
+//! The words of the document change with every keystroke and are looked up
+//! by the GUI thread when the query is made, as are the words of the other
+//! files of the open folder; run() merges them with the snapshot and may be
+//! called from any thread.
+class CompletionQuery
+{
+    //set public methods & variables
+    public:
+        //the popup shows a handful of rows, never lay out more than this
+        static const int MaxMatches = 100;
+        //rows taken from the document before the dictionary rows
+        static const int DocumentMatches = 10;
+        //rows taken from the open folder after those of the document
+        static const int ProjectMatches = 10;
+        //shorter prefixes are too ambiguous to correct
+        static const int FuzzyMinimumLength = 3;
+        //prefixes from this length on may have two typos
+        static const int FuzzyTwoEditLength = 6;
+
+        CompletionQuery();
+
+        CompletionMatches run(const CompletionSnapshot &snapshot) const;
+
+        int generation;
+        QString contextWord;
+        QString prefix;
+        bool fuzzy;
+        QStringList documentPredictions;
+        QStringList documentCompletions;
+        QStringList projectCompletions;
+};
+//! [2]
+
+Q_DECLARE_METATYPE(CompletionQuery)
+Q_DECLARE_METATYPE(CompletionMatches)
+
+#endif // COMPLETIONQUERY_H
@@ -0,0 +1,182 @@
+/*
+ * CompletionServer Class
+ * Share dictionaries and learned words between the editors of a user
+*/
+#include "completionserver.h"
+#include "completionclient.h"
+#include "completionmodel.h"
+#include "completionprotocol.h"
+#include "dictionarymanager.h"
+#include "learningstore.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+
+//! [0]
+//! main function
+//! the learned words are read at once, dictionaries when asked for
+CompletionServer::CompletionServer(QObject *parent)
+    : QObject(parent)
+{
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, SIGNAL(newConnection()), this, SLOT(newClient()));
+    learning = new LearningStore(LearningStore::defaultFileName(), this);
+    learning->load();
+    connect(DictionaryManager::instance(), SIGNAL(loaded(QStringList)), this, SLOT(dictionaryLoaded(QStringList)));
+}
+//! [0]
+
+//! [1]
+//! function: listen(), errorString()
+//! take the name of the user's server; the socket of a server that
+//! crashed is removed, a running server is left alone
+bool CompletionServer::listen()
+{
+    const QString name = CompletionProtocol::serverName();
+    if (name.isEmpty()) {
+        error = tr("There is no private runtime directory for the socket");
+        return false;
+    }
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(CompletionClient::ConnectTimeoutMs)) {
+        error = tr("A completion server is already running as %1").arg(name);
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        error = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+QString CompletionServer::errorString() const
+{
+    return error;
+}
+//! [1]
+
+//! [2]
+//! function: newClient(), clientGone()
+//! an editor attached or went away; the models of layers no editor uses
+//! any more are dropped, which releases their dictionaries
+void CompletionServer::newClient()
+{
+    while (server->hasPendingConnections()) {
+        QLocalSocket *client = server->nextPendingConnection();
+        clientLayers.insert(client, QString());
+        connect(client, SIGNAL(readyRead()), this, SLOT(readRequests()));
+        connect(client, SIGNAL(disconnected()), this, SLOT(clientGone()));
+    }
+}
+
+void CompletionServer::clientGone()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+    clientLayers.remove(client);
+    client->deleteLater();
+    releaseUnused();
+}
+
+//! function: releaseUnused()
+void CompletionServer::releaseUnused()
+{
+    const QList<QString> used = clientLayers.values();
+    QHash<QString, CompletionModel *>::iterator it = models.begin();
+    while (it != models.end()) {
+        if (used.contains(it.key())) {
+            ++it;
+        } else {
+            delete it.value();
+            it = models.erase(it);
+        }
+    }
+}
+//! [2]
+
+//! [3]
+//! function: readRequests()
+//! answer every complete frame of the editor in order, with one write
+void CompletionServer::readRequests()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+    QByteArray frame;
+    QByteArray answers;
+    bool invalid = false;
+    while (CompletionProtocol::takeFrame(client, &frame, &invalid)) {
+        switch (CompletionProtocol::message(frame)) {
+        case CompletionProtocol::Layers: {
+            const QStringList fileNames = CompletionProtocol::readLayers(frame);
+            model(fileNames);
+            clientLayers.insert(client, fileNames.join(QLatin1Char('\n')));
+            releaseUnused();
+            break;
+        }
+        case CompletionProtocol::Query: {
+            const CompletionQuery query = CompletionProtocol::readQuery(frame);
+            CompletionModel *layers = models.value(clientLayers.value(client));
+            CompletionMatches answered;
+            answered.generation = query.generation;
+            if (layers && layers->dictionary())
+                answered = query.run(layers->snapshot());
+            answers += CompletionProtocol::matchesFrame(answered);
+            break;
+        }
+        case CompletionProtocol::Learn: {
+            const QStringList words = CompletionProtocol::readLearn(frame);
+            CompletionModel *layers = models.value(clientLayers.value(client));
+            if (layers) {
+                layers->recordTypedWord(words.at(0), words.at(1));
+            } else {
+                learning->recordWord(words.at(1));
+                if (!words.at(0).isEmpty())
+                    learning->recordBigram(words.at(0), words.at(1));
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (!answers.isEmpty())
+        client->write(answers);
+    if (invalid)
+        client->abort();
+}
+//! [3]
+
+//! [4]
+//! function: model(param: word list files, highest priority first)
+//! the model of these files, its dictionary loaded through the manager by
+//! the files themselves; files changed since they were loaded are loaded
+//! again and the model switches once they are
+CompletionModel *CompletionServer::model(const QStringList &fileNames)
+{
+    const QString key = fileNames.join(QLatin1Char('\n'));
+    CompletionModel *layers = models.value(key);
+    if (!layers) {
+        layers = new CompletionModel(this);
+        layers->setLearningStore(learning);
+        models.insert(key, layers);
+    }
+
+    DictionaryManager *dictionaries = DictionaryManager::instance();
+    const QSharedPointer<Dictionary> dictionary = dictionaries->filesDictionary(fileNames);
+    if (!dictionary)
+        dictionaries->loadFiles(fileNames);
+    else if (dictionary != layers->dictionary())
+        layers->setDictionary(dictionary);
+    return layers;
+}
+
+//! function: dictionaryLoaded(param: files of the loaded layers)
+void CompletionServer::dictionaryLoaded(const QStringList &fileNames)
+{
+    CompletionModel *loaded = models.value(fileNames.join(QLatin1Char('\n')));
+    const QSharedPointer<Dictionary> dictionary = DictionaryManager::instance()->filesDictionary(fileNames);
+    if (loaded && dictionary)
+        loaded->setDictionary(dictionary);
+}
+//! [4]
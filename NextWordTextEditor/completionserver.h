@@ -0,0 +1,61 @@
+/*
+ * Header CompletionServer class
+ * Answer the completion queries of the editors of one user
+*/
+
+#ifndef COMPLETIONSERVER_H
+#define COMPLETIONSERVER_H
+
+//import dependencies
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QLocalServer;
+class QLocalSocket;
+QT_END_NAMESPACE
+class CompletionModel;
+class LearningStore;
+
+//! [0]
+//! Run with --serve. Loads the learned words of the user once and each
+//! requested dictionary once, by its files through the DictionaryManager,
+//! and answers the editors attached to it with CompletionProtocol frames.
+//! Every combination of word lists in use gets a CompletionModel, which
+//! keeps its usage ranking and records what the editors learn into the one
+//! LearningStore; it is dropped when no editor uses it any more.
+//! All frames already received from an editor are answered together with a
+//! single write. Queries are answered empty until their dictionary is loaded.
+class CompletionServer : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        CompletionServer(QObject *parent = 0);
+
+        bool listen();
+        QString errorString() const;
+
+    //set private slots methods
+    private slots:
+        void newClient();
+        void readRequests();
+        void clientGone();
+        void dictionaryLoaded(const QStringList &fileNames);
+
+    //set private methods & variables
+    private:
+        CompletionModel *model(const QStringList &fileNames);
+        void releaseUnused();
+
+        QLocalServer *server;
+        LearningStore *learning;
+        QHash<QString, CompletionModel *> models;       // layer key of the word list files
+        QHash<QLocalSocket *, QString> clientLayers;    // layer key of each editor
+        QString error;
+};
+//! [0]
+
+#endif // COMPLETIONSERVER_H
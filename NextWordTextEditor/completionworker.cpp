@@ -0,0 +1,51 @@
+/*
+ * CompletionWorker Class
+ * Run posted completion queries against the published snapshot
+*/
+#include "completionworker.h"
+
+#include <QMetaObject>
+
+//! [0]
+//! main function
+//! queries and matches cross threads as queued arguments
+CompletionWorker::CompletionWorker()
+    : QObject(0)
+{
+    qRegisterMetaType<CompletionQuery>();
+    qRegisterMetaType<CompletionMatches>();
+}
+//! [0]
+
+//! [1]
+//! function: publish(param: new snapshot)
+//! called from the GUI thread, replaces the snapshot of later queries
+void CompletionWorker::publish(const std::shared_ptr<const CompletionSnapshot> &snapshot)
+{
+    std::atomic_store(&current, snapshot);
+}
+//! [1]
+
+//! [2]
+//! function: post(param: query)
+//! called from the GUI thread, queues the query on the worker thread
+void CompletionWorker::post(const CompletionQuery &query)
+{
+    latestGeneration.storeRelease(query.generation);
+    QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection, Q_ARG(CompletionQuery, query));
+}
+//! [2]
+
+//! [3]
+//! function: run(param: query)
+//! answer the query unless a newer one is already waiting
+void CompletionWorker::run(const CompletionQuery &query)
+{
+    if (query.generation != latestGeneration.loadAcquire())
+        return;
+    const std::shared_ptr<const CompletionSnapshot> snapshot = std::atomic_load(&current);
+    if (!snapshot)
+        return;
+    emit finished(query.run(*snapshot));
+}
+//! [3]
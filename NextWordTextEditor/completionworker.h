@@ -0,0 +1,47 @@
+/*
+ * Header CompletionWorker class
+ * Answer completion queries on a dedicated thread
+*/
+
+#ifndef COMPLETIONWORKER_H
+#define COMPLETIONWORKER_H
+
+//import dependencies
+#include <QAtomicInt>
+#include <QObject>
+#include <memory>
+#include "completionquery.h"
+
+//! [0]
+//! Lives on its own thread. The GUI thread publishes snapshots with an
+//! atomic pointer swap and posts queries; the worker loads the current
+//! snapshot at the start of each query and keeps it alive until the query
+//! is answered, so neither side ever waits for the other. A query that was
+//! superseded by a newer one before it started is dropped unanswered.
+class CompletionWorker : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        CompletionWorker();
+
+        void publish(const std::shared_ptr<const CompletionSnapshot> &snapshot);
+        void post(const CompletionQuery &query);
+
+    //set signals
+    signals:
+        void finished(const CompletionMatches &matches);
+
+    //set private slots methods
+    private slots:
+        void run(const CompletionQuery &query);
+
+    //set private methods & variables
+    private:
+        std::shared_ptr<const CompletionSnapshot> current;
+        QAtomicInt latestGeneration;
+};
+//! [0]
+
+#endif // COMPLETIONWORKER_H
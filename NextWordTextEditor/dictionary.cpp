@@ -0,0 +1,204 @@
+/*
+ * Dictionary Class
+ * Read the word lists and build the completion data, off the GUI thread
+*/
+#include "dictionary.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <cstring>
+
+namespace {
+
+//suffix of compiled dictionary images
+const char ImageSuffix[] = "nwd";
+
+} // namespace
+
+//! [0]
+//! main function
+//! create an empty dictionary
+Dictionary::Dictionary()
+{
+}
+//! [0]
+
+//! [1]
+//! function: build(param: list of words, best ranked first)
+//! intern the tokens of the list once, then compile the prefix index and
+//! the predictor over the token ids side by side into an in-memory image
+//! and read them from it
+void Dictionary::build(const QStringList &list)
+{
+    const TokenPool::Builder tokens(list);
+    QFuture<void> index = QtConcurrent::run(&WordIndex::compile, tokens, &image);
+    NextWordPredictor::compile(tokens, &image);
+    tokens.write(&image);
+    index.waitForFinished();
+    image.finish();
+    attach();
+}
+//! [1]
+
+//! [2]
+//! function: map(param: string of file path), save(param: string of file path)
+//! read a compiled image in place, or write the current one
+bool Dictionary::map(const QString &fileName)
+{
+    return image.map(fileName) && attach();
+}
+
+bool Dictionary::save(const QString &fileName) const
+{
+    return image.save(fileName);
+}
+
+bool Dictionary::isMapped() const
+{
+    return image.isMapped();
+}
+//! [2]
+
+//! [3]
+//! function: wordIndex(), predictor()
+//! access the completion data
+const WordIndex &Dictionary::wordIndex() const
+{
+    return words;
+}
+
+const NextWordPredictor &Dictionary::predictor() const
+{
+    return nextWords;
+}
+//! [3]
+
+//! [4]
+//! function: readWordList(param: string of file path)
+//! read a word list in one go and split it into trimmed lines
+QStringList Dictionary::readWordList(const QString &fileName)
+{
+    QStringList lines;
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return lines;
+
+    const QByteArray data = file.readAll();
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+    while (begin < end) {
+        const char *eol = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+        if (!eol)
+            eol = end;
+        const QString line = QString::fromUtf8(begin, int(eol - begin)).trimmed();
+        if (!line.isEmpty())
+            lines << line;
+        begin = eol + 1;
+    }
+    return lines;
+}
+//! [4]
+
+//! [5]
+//! function: fromFiles(param: list of file paths, best list first)
+//! map a compiled image if one is given or cached for these lists,
+//! otherwise read the lists in parallel, build and cache the image
+//! meant to be called through QtConcurrent::run
+QSharedPointer<Dictionary> Dictionary::fromFiles(const QStringList &fileNames)
+{
+    QSharedPointer<Dictionary> dictionary(new Dictionary);
+    if (fileNames.size() == 1 && QFileInfo(fileNames.first()).suffix() == QLatin1String(ImageSuffix)) {
+        if (!dictionary->map(fileNames.first()))
+            qWarning("Cannot map dictionary image %s", qPrintable(fileNames.first()));
+        return dictionary;
+    }
+
+    //a corrupt cache fails to attach and is compiled again over
+    const QString cache = cacheFileName(fileNames);
+    if (!cache.isEmpty() && dictionary->map(cache))
+        return dictionary;
+
+    dictionary->build(readWordLists(fileNames));
+    //compile once, later launches and other editors map the image
+    if (!cache.isEmpty() && QDir().mkpath(QFileInfo(cache).absolutePath()))
+        dictionary->save(cache);
+    return dictionary;
+}
+//! [5]
+
+//! [6]
+//! function: compileFiles(param: list of file paths, output image path)
+//! offline compiler: build the lists into an image file
+bool Dictionary::compileFiles(const QStringList &fileNames, const QString &imageName)
+{
+    Dictionary dictionary;
+    dictionary.build(readWordLists(fileNames));
+    return dictionary.save(imageName);
+}
+//! [6]
+
+//! [7]
+//! function: filesKey(param: list of file paths)
+//! key of the dictionary of these lists in their current state, it changes
+//! whenever a list, the application or the format changes
+QString Dictionary::filesKey(const QStringList &fileNames)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(QByteArray::number(DictionaryImage::Version));
+    foreach (const QString &fileName, fileNames) {
+        //resources change with the executable only
+        const QFileInfo info(fileName.startsWith(QLatin1Char(':'))
+                             ? QCoreApplication::applicationFilePath() : fileName);
+        hash.addData(fileName.toUtf8());
+        hash.addData(QByteArray::number(info.size()));
+        hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+//! function: cacheFileName(param: list of file paths)
+//! path of the cached image for these lists, empty without a cache location
+QString Dictionary::cacheFileName(const QStringList &fileNames)
+{
+    const QString location = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (location.isEmpty())
+        return QString();
+    return location + QLatin1String("/dictionaries/") + filesKey(fileNames)
+            + QLatin1Char('.') + QLatin1String(ImageSuffix);
+}
+//! [7]
+
+//! [8]
+//! function: attach()
+//! point index and predictor at the current image
+bool Dictionary::attach()
+{
+    if (words.attach(image) && nextWords.attach(image))
+        return true;
+    words.clear();
+    nextWords.clear();
+    return false;
+}
+//! [8]
+
+//! [9]
+//! function: readWordLists(param: list of file paths, best list first)
+//! read the lists in parallel and concatenate them in order
+QStringList Dictionary::readWordLists(const QStringList &fileNames)
+{
+    const QList<QStringList> lists
+        = QtConcurrent::blockingMapped<QList<QStringList> >(fileNames, &Dictionary::readWordList);
+
+    QStringList words;
+    foreach (const QStringList &list, lists)
+        words << list;
+    return words;
+}
+//! [9]
@@ -0,0 +1,54 @@
+/*
+ * Header Dictionary class
+ * Word suggestion data loaded from the word lists
+*/
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+//import dependencies
+#include <QSharedPointer>
+#include <QStringList>
+#include "dictionaryimage.h"
+#include "wordindex.h"
+#include "nextwordpredictor.h"
+
+//! [0]
+//! Bundles the prefix index and the bigram predictor built from the same
+//! lists over one shared token pool. Both read their tables from one
+//! compiled DictionaryImage, either built in memory from the text lists or
+//! mapped from a compiled file.
+//! A dictionary is complete before it is handed to the model, so loading
+//! can run on a worker thread and be published in one step.
+class Dictionary
+{
+    //set public methods & variables
+    public:
+        Dictionary();
+
+        void build(const QStringList &list);
+        bool map(const QString &fileName);
+        bool save(const QString &fileName) const;
+        bool isMapped() const;
+
+        const WordIndex &wordIndex() const;
+        const NextWordPredictor &predictor() const;
+
+        static QStringList readWordList(const QString &fileName);
+        static QSharedPointer<Dictionary> fromFiles(const QStringList &fileNames);
+        static bool compileFiles(const QStringList &fileNames, const QString &imageName);
+        static QString filesKey(const QStringList &fileNames);
+        static QString cacheFileName(const QStringList &fileNames);
+
+    //set private methods & variables
+    private:
+        bool attach();
+        static QStringList readWordLists(const QStringList &fileNames);
+
+        DictionaryImage image;
+        WordIndex words;
+        NextWordPredictor nextWords;
+};
+//! [0]
+
+#endif // DICTIONARY_H
@@ -0,0 +1,207 @@
+/*
+ * DictionaryImage Class
+ * Assemble, save, map and validate compiled dictionary images
+*/
+#include "dictionaryimage.h"
+
+#include <QSaveFile>
+#include <cstring>
+
+namespace {
+
+quint32 align8(quint32 offset)
+{
+    return (offset + 7) & ~quint32(7);
+}
+
+} // namespace
+
+//! [0]
+//! main function
+//! create an empty, invalid image
+DictionaryImage::DictionaryImage()
+    : base(0), length(0)
+{
+    std::memset(offsets, 0, sizeof(offsets));
+    std::memset(sizes, 0, sizeof(sizes));
+}
+
+DictionaryImage::~DictionaryImage()
+{
+    reset();
+}
+//! [0]
+
+//! [1]
+//! function: setSection(param: section id, raw bytes)
+//! store a section until finish() assembles the image
+void DictionaryImage::setSection(Section section, const QByteArray &data)
+{
+    pending[section] = data;
+}
+//! [1]
+
+//! [2]
+//! function: finish()
+//! lay out header and aligned sections in one buffer and attach to it
+void DictionaryImage::finish()
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = Magic;
+    header.version = Version;
+    header.sectionCount = SectionCount;
+
+    quint32 offset = align8(sizeof(Header));
+    for (int i = 0; i < SectionCount; ++i) {
+        header.offsets[i] = offset;
+        header.sizes[i] = pending[i].size();
+        offset = align8(offset + header.sizes[i]);
+    }
+    header.size = offset;
+
+    QByteArray image(int(offset), '\0');
+    std::memcpy(image.data(), &header, sizeof(header));
+    for (int i = 0; i < SectionCount; ++i) {
+        std::memcpy(image.data() + header.offsets[i], pending[i].constData(), pending[i].size());
+        pending[i].clear();
+    }
+    load(image);
+}
+//! [2]
+
+//! [3]
+//! function: load(param: image bytes)
+//! read an image held in memory
+bool DictionaryImage::load(const QByteArray &image)
+{
+    reset();
+    bytes = image;
+    if (attach(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size()))
+        return true;
+    bytes.clear();
+    return false;
+}
+//! [3]
+
+//! [4]
+//! function: map(param: string of file path)
+//! map a compiled dictionary file read-only and read it in place
+bool DictionaryImage::map(const QString &fileName)
+{
+    reset();
+    file.setFileName(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    uchar *data = file.map(0, file.size());
+    if (data && attach(data, file.size()))
+        return true;
+    if (data)
+        file.unmap(data);
+    file.close();
+    return false;
+}
+//! [4]
+
+//! [5]
+//! function: save(param: string of file path)
+//! write the image atomically, readers never see a partial file
+bool DictionaryImage::save(const QString &fileName) const
+{
+    if (!isValid())
+        return false;
+    QSaveFile out(fileName);
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+    if (out.write(reinterpret_cast<const char *>(base), length) != length) {
+        out.cancelWriting();
+        return false;
+    }
+    return out.commit();
+}
+//! [5]
+
+//! [6]
+//! function: isValid(), isMapped()
+//! state of the attached image
+bool DictionaryImage::isValid() const
+{
+    return base != 0;
+}
+
+bool DictionaryImage::isMapped() const
+{
+    return base != 0 && bytes.isEmpty();
+}
+//! [6]
+
+//! [7]
+//! function: attach(param: image data, length)
+//! check header and section bounds before any section is read
+bool DictionaryImage::attach(const uchar *data, qint64 size)
+{
+    if (size < qint64(sizeof(Header)))
+        return false;
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != Magic || header.version != Version
+            || header.sectionCount != SectionCount || header.size > size)
+        return false;
+    for (int i = 0; i < SectionCount; ++i) {
+        if (header.offsets[i] % 8 != 0
+                || qint64(header.offsets[i]) + header.sizes[i] > header.size)
+            return false;
+    }
+
+    for (int i = 0; i < SectionCount; ++i) {
+        offsets[i] = header.offsets[i];
+        sizes[i] = int(header.sizes[i]);
+    }
+    base = data;
+    length = header.size;
+    return true;
+}
+//! [7]
+
+//! [8]
+//! function: validOffsets(param: offset table, number of offsets, size of the indexed table, no empty ranges)
+//! count - 1 ranges starting at 0, in order and ending at total
+bool DictionaryImage::validOffsets(const qint32 *offsets, int count, int total, bool nonEmpty)
+{
+    if (count < 1 || offsets[0] != 0 || offsets[count - 1] != total)
+        return false;
+    for (int i = 1; i < count; ++i) {
+        if (offsets[i] < offsets[i - 1] || (nonEmpty && offsets[i] == offsets[i - 1]))
+            return false;
+    }
+    return true;
+}
+
+//! function: validIds(param: id table, number of ids, smallest allowed id, one past the largest)
+//! every id lies in [minimum, end)
+bool DictionaryImage::validIds(const qint32 *ids, int count, int minimum, int end)
+{
+    for (int i = 0; i < count; ++i) {
+        if (ids[i] < minimum || ids[i] >= end)
+            return false;
+    }
+    return true;
+}
+//! [8]
+
+//! [9]
+//! function: reset()
+//! drop the attached image, unmapping the file if needed
+void DictionaryImage::reset()
+{
+    if (base && bytes.isEmpty())
+        file.unmap(const_cast<uchar *>(base));
+    if (file.isOpen())
+        file.close();
+    bytes.clear();
+    base = 0;
+    length = 0;
+    std::memset(offsets, 0, sizeof(offsets));
+    std::memset(sizes, 0, sizeof(sizes));
+}
+//! [9]
@@ -0,0 +1,108 @@
+/*
+ * Header DictionaryImage class
+ * Versioned binary image of a compiled dictionary
+*/
+
+#ifndef DICTIONARYIMAGE_H
+#define DICTIONARYIMAGE_H
+
+//import dependencies
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+//! [0]
+//! The image is a header followed by 8-byte aligned sections (token pools,
+//! token ids of the entries, trie, best entries per node, token hash table,
+//! successor tables). Sections are stored in native byte order and read in
+//! place, either from a byte array or from a file mapped with QFile::map, so
+//! loading a compiled dictionary allocates nothing per entry and several
+//! editors share the mapped pages.
+//! The readers check every offset and id table against its sections when
+//! they attach, so a truncated or corrupt cached image is rebuilt instead of
+//! read out of bounds.
+class DictionaryImage
+{
+    //set public methods & variables
+    public:
+        enum Section {
+            WordTokenOffsets,
+            WordTokens,
+            WordRanks,
+            WordNodes,
+            WordEdgeLabels,
+            WordEdgeTargets,
+            WordBestOffsets,
+            WordBest,
+            TokenKeyOffsets,
+            TokenWordOffsets,
+            TokenKeyPool,
+            TokenWordPool,
+            TokenHash,
+            SuccessorOffsets,
+            Successors,
+            SectionCount
+        };
+
+        static const quint32 Magic = 0x44574e4e; // "NNWD"
+        static const quint32 Version = 3;
+
+        DictionaryImage();
+        ~DictionaryImage();
+
+        //write side: fill the sections, then finish() to read them back
+        void setSection(Section section, const QByteArray &data);
+        template <typename T>
+        void setSection(Section section, const QVector<T> &values)
+        {
+            setSection(section, QByteArray(reinterpret_cast<const char *>(values.constData()),
+                                           values.size() * int(sizeof(T))));
+        }
+        void finish();
+
+        //read side
+        bool load(const QByteArray &image);
+        bool map(const QString &fileName);
+        bool save(const QString &fileName) const;
+        bool isValid() const;
+        bool isMapped() const;
+
+        template <typename T>
+        const T *section(Section section, int *count = 0) const
+        {
+            if (count)
+                *count = sizes[section] / int(sizeof(T));
+            return reinterpret_cast<const T *>(base + offsets[section]);
+        }
+
+        //checks of the tables read from a section, a cached image may be corrupt
+        static bool validOffsets(const qint32 *offsets, int count, int total, bool nonEmpty = false);
+        static bool validIds(const qint32 *ids, int count, int minimum, int end);
+
+    //set private methods & variables
+    private:
+        struct Header
+        {
+            quint32 magic;
+            quint32 version;
+            quint32 sectionCount;
+            quint32 size;
+            quint32 offsets[SectionCount];
+            quint32 sizes[SectionCount];
+        };
+
+        bool attach(const uchar *data, qint64 length);
+        void reset();
+
+        QByteArray pending[SectionCount];
+        QByteArray bytes;
+        QFile file;
+        const uchar *base;
+        qint64 length;
+        quint32 offsets[SectionCount];
+        int sizes[SectionCount];
+};
+//! [0]
+
+#endif // DICTIONARYIMAGE_H
@@ -0,0 +1,167 @@
+/*
+ * DictionaryManager Class
+ * Register word lists, load and share the dictionaries of their layers
+*/
+#include "dictionarymanager.h"
+
+#include <QCoreApplication>
+#include <QtConcurrent>
+
+//! [0]
+//! main function
+//! the lists shipped in the resources are always available
+DictionaryManager::DictionaryManager(QObject *parent)
+    : QObject(parent)
+{
+    addList(QLatin1String("wordlist"), QStringList() << QLatin1String(":/resources/wordlist.txt"));
+    addList(QLatin1String("wordlist20k"), QStringList() << QLatin1String(":/resources/wordlist20k"));
+    addList(QLatin1String("wordlistf500"), QStringList() << QLatin1String(":/resources/wordlistf500"));
+}
+
+//! function: instance()
+//! the manager shared by all windows, owned by the application
+DictionaryManager *DictionaryManager::instance()
+{
+    static DictionaryManager *manager = new DictionaryManager(QCoreApplication::instance());
+    return manager;
+}
+//! [0]
+
+//! [1]
+//! function: addList(param: name, files of the list)
+//! register a list, or replace the files of a registered name; windows
+//! using a replaced name are told to load its dictionary again
+void DictionaryManager::addList(const QString &name, const QStringList &fileNames)
+{
+    const bool replaced = lists.contains(name);
+    if (!replaced)
+        names.append(name);
+    lists.insert(name, fileNames);
+    releaseUnused();
+    emit listsChanged();
+    if (replaced)
+        emit listChanged(name);
+}
+
+QStringList DictionaryManager::listNames() const
+{
+    return names;
+}
+
+QStringList DictionaryManager::listFiles(const QString &name) const
+{
+    return lists.value(name);
+}
+
+//! function: layerFiles(param: list names, highest priority first)
+//! the files of the layers in the order they are compiled
+QStringList DictionaryManager::layerFiles(const QStringList &layers) const
+{
+    QStringList fileNames;
+    foreach (const QString &name, layers)
+        fileNames << lists.value(name);
+    return fileNames;
+}
+
+//! function: defaultList()
+//! the general list used until another one is chosen
+QString DictionaryManager::defaultList() const
+{
+    return QLatin1String("wordlist");
+}
+//! [1]
+
+//! [2]
+//! function: dictionary(param: list names, highest priority first)
+//! the loaded dictionary of these layers, null if not loaded yet
+QSharedPointer<Dictionary> DictionaryManager::dictionary(const QStringList &layers) const
+{
+    return filesDictionary(layerFiles(layers));
+}
+
+//! function: isLoading(param: list names)
+bool DictionaryManager::isLoading(const QStringList &layers) const
+{
+    return isLoadingFiles(layerFiles(layers));
+}
+
+//! function: filesDictionary(param: word list files, highest priority first)
+//! the loaded dictionary of these files as they are now, null if not
+//! loaded yet, changed since or no longer used
+QSharedPointer<Dictionary> DictionaryManager::filesDictionary(const QStringList &fileNames) const
+{
+    if (fileNames.isEmpty())
+        return QSharedPointer<Dictionary>();
+    return loadedDictionaries.value(Dictionary::filesKey(fileNames)).dictionary.toStrongRef();
+}
+
+//! function: isLoadingFiles(param: word list files)
+bool DictionaryManager::isLoadingFiles(const QStringList &fileNames) const
+{
+    const QString key = Dictionary::filesKey(fileNames);
+    foreach (const Cached &loading, pending) {
+        if (loading.key == key)
+            return true;
+    }
+    return false;
+}
+//! [2]
+
+//! [3]
+//! function: load(param: list names, highest priority first)
+//! start loading the layers unless they are loaded or loading already,
+//! loaded() is emitted with their files when they are ready
+void DictionaryManager::load(const QStringList &layers)
+{
+    loadFiles(layerFiles(layers));
+}
+
+//! function: loadFiles(param: word list files, highest priority first)
+void DictionaryManager::loadFiles(const QStringList &fileNames)
+{
+    if (fileNames.isEmpty() || filesDictionary(fileNames) || isLoadingFiles(fileNames))
+        return;
+
+    Cached loading;
+    loading.key = Dictionary::filesKey(fileNames);
+    loading.fileNames = fileNames;
+    QFutureWatcher<QSharedPointer<Dictionary> > *watcher = new QFutureWatcher<QSharedPointer<Dictionary> >(this);
+    pending.insert(watcher, loading);
+    connect(watcher, SIGNAL(finished()), this, SLOT(loadFinished()));
+    watcher->setFuture(QtConcurrent::run(&Dictionary::fromFiles, fileNames));
+}
+//! [3]
+
+//! [4]
+//! function: loadFinished()
+//! share the dictionary with every later request while it is in use and
+//! announce it; receivers take their reference in the signal
+void DictionaryManager::loadFinished()
+{
+    QFutureWatcher<QSharedPointer<Dictionary> > *watcher
+        = static_cast<QFutureWatcher<QSharedPointer<Dictionary> > *>(sender());
+    Cached done = pending.take(watcher);
+    const QSharedPointer<Dictionary> dictionary = watcher->result();
+    done.dictionary = dictionary;
+    loadedDictionaries.insert(done.key, done);
+    watcher->deleteLater();
+    releaseUnused();
+    emit loaded(done.fileNames);
+}
+//! [4]
+
+//! [5]
+//! function: releaseUnused()
+//! forget dictionaries no model holds any more and those of files that
+//! changed since they were loaded
+void DictionaryManager::releaseUnused()
+{
+    QHash<QString, Cached>::iterator it = loadedDictionaries.begin();
+    while (it != loadedDictionaries.end()) {
+        if (it.value().dictionary.isNull() || Dictionary::filesKey(it.value().fileNames) != it.key())
+            it = loadedDictionaries.erase(it);
+        else
+            ++it;
+    }
+}
+//! [5]
@@ -0,0 +1,86 @@
+/*
+ * Header DictionaryManager class
+ * Named word lists and the dictionaries compiled from them
+*/
+
+#ifndef DICTIONARYMANAGER_H
+#define DICTIONARYMANAGER_H
+
+//import dependencies
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QWeakPointer>
+#include "dictionary.h"
+
+//! [0]
+//! One manager serves every window of the application. Word lists are
+//! registered under a name, the shipped ones from the resources, others
+//! from the file system. A dictionary is requested for a list of layers,
+//! highest priority first, e.g. a domain list over the general one: the
+//! layers are compiled into one image in that order, so an entry of a
+//! higher layer outranks the same word further down. The user and document
+//! layers on top are the LearningStore and DocumentVocabulary of the model.
+//! Dictionaries are cached by their files in their current state
+//! (Dictionary::filesKey), not by list names: layers naming the same files
+//! share one dictionary, and a list whose files were replaced or changed on
+//! disk is loaded again instead of served from the cache. Each one is
+//! loaded once, on a worker thread, and the same dictionary is handed to
+//! every model asking for it; a model switches to it with
+//! CompletionModel::setDictionary without a restart. The manager only keeps
+//! weak references, a dictionary no model uses any more is released.
+class DictionaryManager : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static DictionaryManager *instance();
+
+        void addList(const QString &name, const QStringList &fileNames);
+        QStringList listNames() const;
+        QStringList listFiles(const QString &name) const;
+        QStringList layerFiles(const QStringList &layers) const;
+        QString defaultList() const;
+
+        QSharedPointer<Dictionary> dictionary(const QStringList &layers) const;
+        void load(const QStringList &layers);
+        bool isLoading(const QStringList &layers) const;
+
+        QSharedPointer<Dictionary> filesDictionary(const QStringList &fileNames) const;
+        void loadFiles(const QStringList &fileNames);
+        bool isLoadingFiles(const QStringList &fileNames) const;
+
+    //set signals
+    signals:
+        void listsChanged();
+        void listChanged(const QString &name);
+        void loaded(const QStringList &fileNames);
+
+    //set private slots methods
+    private slots:
+        void loadFinished();
+
+    //set private methods & variables
+    private:
+        struct Cached
+        {
+            QString key;        // files key when the load started
+            QStringList fileNames;
+            QWeakPointer<Dictionary> dictionary;
+        };
+
+        DictionaryManager(QObject *parent = 0);
+
+        void releaseUnused();
+
+        QStringList names;                                  // in registration order
+        QHash<QString, QStringList> lists;                  // name, files best first
+        QHash<QString, Cached> loadedDictionaries;          // files key
+        QHash<QFutureWatcher<QSharedPointer<Dictionary> > *, Cached> pending;  // without dictionary yet
+};
+//! [0]
+
+#endif // DICTIONARYMANAGER_H
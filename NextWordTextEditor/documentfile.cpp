@@ -0,0 +1,201 @@
+/*
+ * DocumentFile Class
+ * Read a file into the document in chunks, save it block by block
+*/
+#include "documentfile.h"
+#include "perfprobe.h"
+
+#include <QSaveFile>
+#include <QTextBlock>
+#include <QTextCodec>
+#include <QTextDocument>
+
+//! [0]
+//! main function
+//! chunks are read whenever the event loop is idle
+DocumentFile::DocumentFile(QTextDocument *document, QObject *parent)
+    : QObject(parent), document(document)
+{
+    chunks.setInterval(0);
+    connect(&chunks, SIGNAL(timeout()), this, SLOT(readChunk()));
+}
+
+DocumentFile::~DocumentFile()
+{
+    if (isLoading())
+        finish();
+}
+//! [0]
+
+//! [1]
+//! function: startLoading(param: string of file path)
+//! replace the document with the file, appended chunk by chunk from the
+//! event loop; progress() follows the read position, loaded() the end
+bool DocumentFile::startLoading(const QString &fileName)
+{
+    if (!open(fileName))
+        return false;
+    chunks.start();
+    return true;
+}
+//! [1]
+
+//! [2]
+//! function: load(param: string of file path)
+//! replace the document with the file without returning to the event loop
+bool DocumentFile::load(const QString &fileName)
+{
+    if (!open(fileName))
+        return false;
+    while (appendChunk()) {
+    }
+    finish();
+    return error.isEmpty();
+}
+//! [2]
+
+//! [3]
+//! function: isLoading(), errorString()
+//! state of the current or last operation
+bool DocumentFile::isLoading() const
+{
+    return file.isOpen();
+}
+
+QString DocumentFile::errorString() const
+{
+    return error;
+}
+//! [3]
+
+//! [4]
+//! function: cancel()
+//! stop loading, the text read so far stays in the document
+void DocumentFile::cancel()
+{
+    if (!isLoading())
+        return;
+    finish();
+    emit loaded(false);
+}
+//! [4]
+
+//! [5]
+//! function: readChunk()
+//! append the next chunk, called by the idle timer
+void DocumentFile::readChunk()
+{
+    if (appendChunk()) {
+        emit progress(file.size() > 0 ? int(file.pos() * 100 / file.size()) : 100);
+        return;
+    }
+    finish();
+    emit progress(100);
+    emit loaded(error.isEmpty());
+}
+//! [5]
+
+//! [6]
+//! function: save(param: string of file path)
+//! encode the document block by block and write it in ChunkSize pieces;
+//! a document still being loaded is only part of its file and is not saved
+bool DocumentFile::save(const QString &fileName)
+{
+    PerfProbe probe(PerfProbe::SaveFile);
+    if (isLoading()) {
+        error = tr("The document is still being loaded");
+        return false;
+    }
+    error.clear();
+    QSaveFile out(fileName);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        error = out.errorString();
+        return false;
+    }
+
+    //same encoding QTextStream writes by default, without a byte order mark
+    QScopedPointer<QTextEncoder> encoder(QTextCodec::codecForLocale()->makeEncoder(QTextCodec::IgnoreHeader));
+    QByteArray buffer;
+    buffer.reserve(ChunkSize);
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        //the same characters toPlainText() would substitute
+        QString text = block.text();
+        text.replace(QChar::Nbsp, QLatin1Char(' '));
+        text.replace(QChar::LineSeparator, QLatin1Char('\n'));
+        if (block.next().isValid())
+            text += QLatin1Char('\n');
+        buffer += encoder->fromUnicode(text);
+        if (buffer.size() >= ChunkSize) {
+            if (out.write(buffer) != buffer.size())
+                break;
+            buffer.resize(0);
+        }
+    }
+    if (out.error() == QFileDevice::NoError)
+        out.write(buffer);
+    if (out.error() != QFileDevice::NoError || !out.commit()) {
+        error = out.errorString();
+        out.cancelWriting();
+        return false;
+    }
+    return true;
+}
+//! [6]
+
+//! [7]
+//! function: open(param: string of file path)
+//! open the file and empty the document, undo stays off until finish()
+bool DocumentFile::open(const QString &fileName)
+{
+    if (isLoading())
+        finish();
+    error.clear();
+    file.setFileName(fileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        error = file.errorString();
+        return false;
+    }
+    decoder.reset();
+    document->setUndoRedoEnabled(false);
+    document->clear();
+    cursor = QTextCursor(document);
+    return true;
+}
+//! [7]
+
+//! [8]
+//! function: appendChunk()
+//! decode the next chunk and append it, return false at the end of the file
+//! a character split between chunks is kept by the decoder
+bool DocumentFile::appendChunk()
+{
+    PerfProbe probe(PerfProbe::LoadChunk);
+    const QByteArray bytes = file.read(ChunkSize);
+    if (bytes.isEmpty()) {
+        if (file.error() != QFileDevice::NoError)
+            error = file.errorString();
+        return false;
+    }
+    //a byte order mark picks the encoding, otherwise the locale one as QTextStream
+    if (!decoder)
+        decoder.reset(QTextCodec::codecForUtfText(bytes, QTextCodec::codecForLocale())->makeDecoder());
+
+    cursor.beginEditBlock();
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(decoder->toUnicode(bytes));
+    cursor.endEditBlock();
+    return !file.atEnd();
+}
+//! [8]
+
+//! [9]
+//! function: finish()
+//! close the file and switch undo back on
+void DocumentFile::finish()
+{
+    chunks.stop();
+    file.close();
+    cursor = QTextCursor();
+    document->setUndoRedoEnabled(true);
+}
+//! [9]
@@ -0,0 +1,74 @@
+/*
+ * Header DocumentFile class
+ * Streaming load and save of the editor document
+*/
+
+#ifndef DOCUMENTFILE_H
+#define DOCUMENTFILE_H
+
+//import dependencies
+#include <QFile>
+#include <QObject>
+#include <QScopedPointer>
+#include <QTextCursor>
+#include <QTimer>
+
+QT_BEGIN_NAMESPACE
+class QTextDecoder;
+class QTextDocument;
+QT_END_NAMESPACE
+
+//! [0]
+//! Files are read in chunks of ChunkSize bytes, decoded incrementally and
+//! appended at the end of the document, one chunk per turn of the event
+//! loop, so the editor stays responsive and a load can be cancelled. Undo is
+//! off while loading. Saving walks the document block by block and streams
+//! the encoded text to a QSaveFile, no full copy of the text is made and a
+//! failed save leaves the old file untouched. Saving is refused while a
+//! load is in progress.
+class DocumentFile : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const int ChunkSize = 256 * 1024;
+
+        DocumentFile(QTextDocument *document, QObject *parent = 0);
+        ~DocumentFile();
+
+        bool startLoading(const QString &fileName);
+        bool load(const QString &fileName);
+        bool isLoading() const;
+        bool save(const QString &fileName);
+        QString errorString() const;
+
+    //set public slots methods
+    public slots:
+        void cancel();
+
+    //set signals
+    signals:
+        void progress(int percent);
+        void loaded(bool complete);
+
+    //set private slots methods
+    private slots:
+        void readChunk();
+
+    //set private methods & variables
+    private:
+        bool open(const QString &fileName);
+        bool appendChunk();
+        void finish();
+
+        QTextDocument *document;
+        QFile file;
+        QScopedPointer<QTextDecoder> decoder;
+        QTextCursor cursor;
+        QTimer chunks;
+        QString error;
+};
+//! [0]
+
+#endif // DOCUMENTFILE_H
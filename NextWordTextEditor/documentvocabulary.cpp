@@ -0,0 +1,358 @@
+/*
+ * DocumentVocabulary Class
+ * Count the words of the document block by block, from contentsChange deltas
+*/
+#include "documentvocabulary.h"
+#include "blockdata.h"
+#include "latexcompletion.h"
+
+#include <QElapsedTimer>
+#include <QTextDocument>
+#include <algorithm>
+
+namespace {
+
+inline bool isWordCharacter(QChar c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_');
+}
+
+//- and : join parts of one term, as in sec:results or well-known
+inline bool isJoiner(QChar c)
+{
+    return c == QLatin1Char('-') || c == QLatin1Char(':');
+}
+
+struct Ranked
+{
+    QString word;
+    int count;
+};
+
+bool rankedMoreThan(const Ranked &a, const Ranked &b)
+{
+    return a.count > b.count;
+}
+
+void releaseKey(QMap<QString, int> *keys, const QString &key)
+{
+    QMap<QString, int>::iterator it = keys->find(key);
+    if (it != keys->end() && --it.value() == 0)
+        keys->erase(it);
+}
+
+//keys are case sensitive, they are listed in order
+QStringList keysWithPrefix(const QMap<QString, int> &keys, const QString &prefix, int limit)
+{
+    QStringList found;
+    for (QMap<QString, int>::const_iterator it = keys.lowerBound(prefix);
+         it != keys.constEnd() && found.size() < limit && it.key().startsWith(prefix); ++it)
+        found << it.key();
+    return found;
+}
+
+QStringList bestWords(QVector<Ranked> ranked, int limit)
+{
+    if (ranked.size() > limit) {
+        std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(), rankedMoreThan);
+        ranked.resize(limit);
+    } else {
+        std::sort(ranked.begin(), ranked.end(), rankedMoreThan);
+    }
+    QStringList words;
+    foreach (const Ranked &r, ranked)
+        words << r.word;
+    return words;
+}
+
+} // namespace
+
+//! [0]
+//! main function
+//! follow the changes of the document
+DocumentVocabulary::DocumentVocabulary(QTextDocument *document, QObject *parent)
+    : QObject(parent), document(document), loading(false), nextBlock(0)
+{
+    idle.setInterval(0);
+    connect(&idle, SIGNAL(timeout()), this, SLOT(indexSlice()));
+    connect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(contentsChanged(int,int,int)));
+}
+//! [0]
+
+//! [1]
+//! function: beginLoad(), endLoad()
+//! changes made while loading are not read, the loaded blocks are indexed
+//! from the idle timer afterwards
+void DocumentVocabulary::beginLoad()
+{
+    idle.stop();
+    loading = true;
+}
+
+void DocumentVocabulary::endLoad()
+{
+    loading = false;
+    nextBlock = 0;
+    idle.start();
+}
+
+bool DocumentVocabulary::isPending() const
+{
+    return idle.isActive();
+}
+//! [1]
+
+//! [2]
+//! function: termCount(), count(param: string)
+//! number of distinct counted words, occurrences of one word
+int DocumentVocabulary::termCount() const
+{
+    return present.size();
+}
+
+int DocumentVocabulary::count(const QString &word) const
+{
+    const int id = termIds.value(word.toCaseFolded(), -1);
+    return id < 0 ? 0 : terms.at(id).count;
+}
+//! [2]
+
+//! [3]
+//! function: complete(param: prefix, max number of results)
+//! words of the document starting with prefix, most frequent first;
+//! the prefix itself is left out, it is usually the word being typed
+QStringList DocumentVocabulary::complete(const QString &prefix, int limit) const
+{
+    const QString folded = prefix.toCaseFolded();
+    QVector<Ranked> ranked;
+    for (QMap<QString, int>::const_iterator it = present.lowerBound(folded);
+         it != present.constEnd() && it.key().startsWith(folded); ++it) {
+        if (it.key().size() == folded.size())
+            continue;
+        const Term &term = terms.at(it.value());
+        Ranked r;
+        r.word = term.word;
+        r.count = term.count;
+        ranked.append(r);
+    }
+    return bestWords(ranked, limit);
+}
+//! [3]
+
+//! [4]
+//! function: predict(param: previous word, prefix, max number of results)
+//! words following previousWord in the document, most frequent first
+QStringList DocumentVocabulary::predict(const QString &previousWord, const QString &prefix, int limit) const
+{
+    const int head = termIds.value(previousWord.toCaseFolded(), -1);
+    if (head < 0)
+        return QStringList();
+    const QString folded = prefix.toCaseFolded();
+    const QHash<int, int> tails = successors.value(head);
+    QVector<Ranked> ranked;
+    for (QHash<int, int>::const_iterator it = tails.constBegin(); it != tails.constEnd(); ++it) {
+        const Term &term = terms.at(it.key());
+        if (!folded.isEmpty() && (!term.word.toCaseFolded().startsWith(folded)
+                                  || term.word.size() == folded.size()))
+            continue;
+        Ranked r;
+        r.word = term.word;
+        r.count = it.value();
+        ranked.append(r);
+    }
+    return bestWords(ranked, limit);
+}
+//! [4]
+
+//! [5]
+//! function: releaseBlock(param: data of a block)
+//! uncount the terms, bigrams and keys a block contributed
+void DocumentVocabulary::releaseBlock(const BlockData &data)
+{
+    foreach (const QString &key, data.labels)
+        releaseKey(&labelKeys, key);
+    foreach (const QString &key, data.citations)
+        releaseKey(&citationKeys, key);
+
+    const QVector<int> &ids = data.terms;
+    for (int i = 0; i < ids.size(); ++i) {
+        Term &term = terms[ids.at(i)];
+        if (--term.count == 0)
+            present.remove(term.word.toCaseFolded());
+        if (i == 0)
+            continue;
+        QHash<int, QHash<int, int> >::iterator head = successors.find(ids.at(i - 1));
+        if (head == successors.end())
+            continue;
+        QHash<int, int>::iterator tail = head.value().find(ids.at(i));
+        if (tail != head.value().end() && --tail.value() == 0) {
+            head.value().erase(tail);
+            if (head.value().isEmpty())
+                successors.erase(head);
+        }
+    }
+}
+//! [5]
+
+//! [6]
+//! function: contentsChanged(param: position, removed and added characters)
+//! read again the blocks touched by a change, unchanged ones are skipped
+//! by their revision (highlighting reports format changes the same way)
+void DocumentVocabulary::contentsChanged(int position, int, int charsAdded)
+{
+    if (loading)
+        return;
+    QTextBlock block = document->findBlock(position);
+    const QTextBlock last = document->findBlock(position + charsAdded);
+    while (block.isValid()) {
+        indexBlock(block);
+        if (block == last)
+            break;
+        block = block.next();
+    }
+}
+//! [6]
+
+//! [7]
+//! function: indexSlice()
+//! index blocks in document order for at most SliceMs
+void DocumentVocabulary::indexSlice()
+{
+    QElapsedTimer slice;
+    slice.start();
+    QTextBlock block = document->findBlockByNumber(nextBlock);
+    while (block.isValid() && slice.elapsed() < SliceMs) {
+        indexBlock(block);
+        block = block.next();
+    }
+    if (!block.isValid()) {
+        idle.stop();
+        return;
+    }
+    nextBlock = block.blockNumber();
+}
+//! [7]
+
+//! [8]
+//! function: indexBlock(param: text block)
+//! replace the terms and bigrams of a block by those of its current text;
+//! commands such as \section are not words of the text
+void DocumentVocabulary::indexBlock(QTextBlock block)
+{
+    BlockData *data = BlockData::of(block);
+    if (data && data->vocabulary == this && data->vocabularyRevision == block.revision())
+        return;
+    if (!data) {
+        data = new BlockData;
+        block.setUserData(data);
+    }
+    if (data->vocabulary == this)
+        releaseBlock(*data);
+    data->terms.resize(0);
+    data->labels.clear();
+    data->citations.clear();
+
+    const QString text = block.text();
+    const int length = text.length();
+    int i = 0;
+    while (i < length) {
+        if (!isWordCharacter(text.at(i))) {
+            ++i;
+            continue;
+        }
+        const int start = i;
+        while (i < length && (isWordCharacter(text.at(i))
+                              || (isJoiner(text.at(i)) && i + 1 < length && isWordCharacter(text.at(i + 1)))))
+            ++i;
+        if (i - start < MinimumLength || (start > 0 && text.at(start - 1) == QLatin1Char('\\')))
+            continue;
+        const int id = intern(text.mid(start, i - start));
+        if (++terms[id].count == 1)
+            present.insert(terms.at(id).word.toCaseFolded(), id);
+        if (!data->terms.isEmpty())
+            ++successors[data->terms.last()][id];
+        data->terms.append(id);
+    }
+    if (text.contains(QLatin1Char('\\')))
+        indexKeys(text, data);
+    data->vocabulary = this;
+    data->vocabularyRevision = block.revision();
+}
+//! [8]
+
+//! [9]
+//! function: intern(param: word)
+//! id of a word, the spelling seen first is the one shown
+int DocumentVocabulary::intern(const QString &word)
+{
+    const QString folded = word.toCaseFolded();
+    QHash<QString, int>::const_iterator it = termIds.constFind(folded);
+    if (it != termIds.constEnd())
+        return it.value();
+    Term term;
+    term.word = word;
+    term.count = 0;
+    terms.append(term);
+    termIds.insert(folded, terms.size() - 1);
+    return terms.size() - 1;
+}
+//! [9]
+
+//! [10]
+//! function: labels(param: prefix, max number of results), citations(...)
+//! keys of the document starting with prefix, for \ref{} and \cite{}
+QStringList DocumentVocabulary::labels(const QString &prefix, int limit) const
+{
+    return keysWithPrefix(labelKeys, prefix, limit);
+}
+
+QStringList DocumentVocabulary::citations(const QString &prefix, int limit) const
+{
+    return keysWithPrefix(citationKeys, prefix, limit);
+}
+//! [10]
+
+//! [11]
+//! function: indexKeys(param: block text, block data)
+//! count the keys in the braces of \label, \cite and the like,
+//! an optional [..] argument before the braces is skipped
+void DocumentVocabulary::indexKeys(const QString &text, BlockData *data)
+{
+    const int length = text.length();
+    int i = text.indexOf(QLatin1Char('\\'));
+    while (i >= 0) {
+        int end = i + 1;
+        while (end < length && text.at(end).isLetter())
+            ++end;
+        if (end == i + 1) {
+            //an escaped character such as \\ does not start a command
+            i = text.indexOf(QLatin1Char('\\'), end + 1);
+            continue;
+        }
+        const LatexCompletion::Context kind = LatexCompletion::argumentContext(text.mid(i + 1, end - i - 1));
+        if (kind != LatexCompletion::Text) {
+            if (end < length && text.at(end) == QLatin1Char('*'))
+                ++end;
+            if (end < length && text.at(end) == QLatin1Char('[')) {
+                const int close = text.indexOf(QLatin1Char(']'), end);
+                end = close < 0 ? length : close + 1;
+            }
+            const int close = end < length && text.at(end) == QLatin1Char('{')
+                    ? text.indexOf(QLatin1Char('}'), end) : -1;
+            if (close > end) {
+                QStringList *keys = kind == LatexCompletion::Label ? &data->labels : &data->citations;
+                QMap<QString, int> *counts = kind == LatexCompletion::Label ? &labelKeys : &citationKeys;
+                foreach (const QString &part, text.mid(end + 1, close - end - 1).split(QLatin1Char(','))) {
+                    const QString key = part.trimmed();
+                    if (!key.isEmpty()) {
+                        keys->append(key);
+                        ++(*counts)[key];
+                    }
+                }
+                end = close + 1;
+            }
+        }
+        i = text.indexOf(QLatin1Char('\\'), end);
+    }
+}
+//! [11]
@@ -0,0 +1,86 @@
+/*
+ * Header DocumentVocabulary class
+ * Words and bigrams of the open document, kept up to date while editing
+*/
+
+#ifndef DOCUMENTVOCABULARY_H
+#define DOCUMENTVOCABULARY_H
+
+//import dependencies
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QTextBlock>
+#include <QTimer>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QTextDocument;
+QT_END_NAMESPACE
+class BlockData;
+
+//! [0]
+//! Every block remembers the term ids it contributed (BlockData::terms)
+//! and the block revision they were read at. A contentsChange only reads
+//! the blocks it touched again: their old terms are released, the new ones
+//! counted, deleted blocks release theirs from the BlockData destructor.
+//! Bigrams are consecutive terms of one block. The keys in the braces of
+//! \label and \ref, and of \bibitem and \cite, are counted the same way in
+//! two small maps of their own for the completion of such arguments. After a load the
+//! blocks are indexed from an idle timer in slices of at most SliceMs.
+class DocumentVocabulary : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const int SliceMs = 8;
+        static const int MinimumLength = 3;
+
+        DocumentVocabulary(QTextDocument *document, QObject *parent = 0);
+
+        void beginLoad();
+        void endLoad();
+        bool isPending() const;
+
+        int termCount() const;
+        int count(const QString &word) const;
+        QStringList complete(const QString &prefix, int limit) const;
+        QStringList predict(const QString &previousWord, const QString &prefix, int limit) const;
+        QStringList labels(const QString &prefix, int limit) const;
+        QStringList citations(const QString &prefix, int limit) const;
+
+        void releaseBlock(const BlockData &data);
+
+    //set private slots methods
+    private slots:
+        void contentsChanged(int position, int charsRemoved, int charsAdded);
+        void indexSlice();
+
+    //set private methods & variables
+    private:
+        struct Term
+        {
+            QString word;
+            int count;
+        };
+
+        void indexBlock(QTextBlock block);
+        void indexKeys(const QString &text, BlockData *data);
+        int intern(const QString &word);
+
+        QTextDocument *document;
+        QVector<Term> terms;                            // by term id, ids are never reused
+        QHash<QString, int> termIds;                    // folded word
+        QMap<QString, int> present;                     // folded word of counted terms, for prefixes
+        QHash<int, QHash<int, int> > successors;        // head id, tail id, count
+        QMap<QString, int> labelKeys;                   // key, occurrences
+        QMap<QString, int> citationKeys;                // key, occurrences
+        bool loading;
+        QTimer idle;
+        int nextBlock;
+};
+//! [0]
+
+#endif // DOCUMENTVOCABULARY_H
@@ -0,0 +1,122 @@
+/*
+ * FindBar Class
+ * Edit the query and the replacement, and show how many matches there are
+*/
+#include "findbar.h"
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+
+//! [0]
+//! main function
+//! lay out the fields, options and buttons in one row
+FindBar::FindBar(QWidget *parent)
+    : QWidget(parent)
+{
+    findEdit = new QLineEdit;
+    findEdit->setPlaceholderText(tr("Find"));
+    replaceEdit = new QLineEdit;
+    replaceEdit->setPlaceholderText(tr("Replace with"));
+    caseBox = new QCheckBox(tr("Match case"));
+    regexBox = new QCheckBox(tr("Regular expression"));
+    status = new QLabel;
+    status->setMinimumWidth(90);
+    QPushButton *previousButton = new QPushButton(tr("Previous"));
+    QPushButton *nextButton = new QPushButton(tr("Next"));
+    QPushButton *replaceButton = new QPushButton(tr("Replace"));
+    QPushButton *replaceAllButton = new QPushButton(tr("Replace All"));
+    QPushButton *closeButton = new QPushButton(tr("Close"));
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(4, 2, 4, 2);
+    layout->addWidget(findEdit, 1);
+    layout->addWidget(previousButton);
+    layout->addWidget(nextButton);
+    layout->addWidget(status);
+    layout->addWidget(replaceEdit, 1);
+    layout->addWidget(replaceButton);
+    layout->addWidget(replaceAllButton);
+    layout->addWidget(caseBox);
+    layout->addWidget(regexBox);
+    layout->addWidget(closeButton);
+
+    connect(findEdit, SIGNAL(textChanged(QString)), this, SIGNAL(queryChanged()));
+    connect(caseBox, SIGNAL(toggled(bool)), this, SIGNAL(queryChanged()));
+    connect(regexBox, SIGNAL(toggled(bool)), this, SIGNAL(queryChanged()));
+    connect(findEdit, SIGNAL(returnPressed()), this, SIGNAL(findNext()));
+    connect(nextButton, SIGNAL(clicked()), this, SIGNAL(findNext()));
+    connect(previousButton, SIGNAL(clicked()), this, SIGNAL(findPrevious()));
+    connect(replaceEdit, SIGNAL(returnPressed()), this, SIGNAL(replace()));
+    connect(replaceButton, SIGNAL(clicked()), this, SIGNAL(replace()));
+    connect(replaceAllButton, SIGNAL(clicked()), this, SIGNAL(replaceAll()));
+    connect(closeButton, SIGNAL(clicked()), this, SIGNAL(closed()));
+}
+//! [0]
+
+//! [1]
+//! function: pattern(), replacement(), options()
+//! the query as entered
+QString FindBar::pattern() const
+{
+    return findEdit->text();
+}
+
+QString FindBar::replacement() const
+{
+    return replaceEdit->text();
+}
+
+TextSearch::Options FindBar::options() const
+{
+    TextSearch::Options options;
+    if (caseBox->isChecked())
+        options |= TextSearch::CaseSensitive;
+    if (regexBox->isChecked())
+        options |= TextSearch::RegularExpression;
+    return options;
+}
+//! [1]
+
+//! [2]
+//! function: showFind()
+//! show the bar with the query selected, ready to be typed over
+void FindBar::showFind()
+{
+    show();
+    findEdit->setFocus();
+    findEdit->selectAll();
+}
+
+//! function: setMatches(param: search of the editor)
+//! number of matches, or why the query cannot match
+void FindBar::setMatches(const TextSearch &search)
+{
+    const int count = search.matches().size();
+    if (!search.errorString().isEmpty())
+        status->setText(tr("Invalid expression"));
+    else if (search.pattern().isEmpty())
+        status->clear();
+    else if (!search.isComplete())
+        status->setText(tr("%1+ matches").arg(count));
+    else
+        status->setText(tr("%n match(es)", 0, count));
+    status->setToolTip(search.errorString());
+}
+//! [2]
+
+//! [3]
+//! function: keyPressEvent(param: QKeyEvent)
+//! Escape closes the bar like its close button
+void FindBar::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_Escape) {
+        emit closed();
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
+//! [3]
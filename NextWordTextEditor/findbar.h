@@ -0,0 +1,60 @@
+/*
+ * Header FindBar class
+ * Find and replace controls below the editor
+*/
+
+#ifndef FINDBAR_H
+#define FINDBAR_H
+
+//import dependencies
+#include <QWidget>
+#include "textsearch.h"
+
+QT_BEGIN_NAMESPACE
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+QT_END_NAMESPACE
+
+//! [0]
+//! The query is reported on every edit of the find field, so that the
+//! editor narrows its matches as the query grows. Return finds the next
+//! match, Escape and the close button ask for the bar to be closed.
+class FindBar : public QWidget
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        FindBar(QWidget *parent = 0);
+
+        QString pattern() const;
+        QString replacement() const;
+        TextSearch::Options options() const;
+        void showFind();
+        void setMatches(const TextSearch &search);
+
+    //set signals
+    signals:
+        void queryChanged();
+        void findNext();
+        void findPrevious();
+        void replace();
+        void replaceAll();
+        void closed();
+
+    //set protected methods & variables
+    protected:
+        void keyPressEvent(QKeyEvent *event) Q_DECL_OVERRIDE;
+
+    //set private methods & variables
+    private:
+        QLineEdit *findEdit;
+        QLineEdit *replaceEdit;
+        QCheckBox *caseBox;
+        QCheckBox *regexBox;
+        QLabel *status;
+};
+//! [0]
+
+#endif // FINDBAR_H
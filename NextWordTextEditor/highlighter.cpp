@@ -52,79 +52,197 @@
 /*
  * Highlighter class
  * Implement QSyntaxHighLighter
- *
+ * LaTeX commands, groups and comments are found in one left-to-right scan
+ * per block, without regular expressions
 */
 
 #include <QtWidgets>
 #include "highlighter.h"
+#include "blockdata.h"
+#include "perfprobe.h"
+
+namespace {
+
+inline bool isAsciiLetter(ushort c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+//index of the "*/" at or after from, -1 if the line has none
+int commentEnd(const QChar *data, int length, int from)
+{
+    for (int i = from; i + 1 < length; ++i) {
+        if (data[i].unicode() == '*' && data[i + 1].unicode() == '/')
+            return i;
+    }
+    return -1;
+}
+
+void appendToken(QVector<Highlighter::Token> *tokens, int start, int length, Highlighter::TokenKind kind)
+{
+    Highlighter::Token token;
+    token.start = start;
+    token.length = length;
+    token.kind = kind;
+    tokens->append(token);
+}
+
+} // namespace
 
 //! [0]
 //! main function
-//! set Highlighter rule
+//! set the format of every token kind
 Highlighter::Highlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent)
+    : QSyntaxHighlighter(parent), deferred(false)
 {
-    HighlightingRule rule;
-
-    /*set rule for any keywords started with \*/
-    classFormat.setFontWeight(QFont::Bold);
-    classFormat.setForeground(Qt::darkMagenta);
-    rule.pattern = QRegExp("\\\\[A-Za-z]+");
-    rule.format = classFormat;
-    highlightingRules.append(rule);
-
-    //set rule for any keywords inside parenthesis {...}
-    functionFormat.setFontItalic(true);
-    functionFormat.setForeground(Qt::darkGreen);
-    rule.pattern = QRegExp("\\{(.*)\\}");
-    rule.format = functionFormat;
-    highlightingRules.append(rule);
-
-    //set rule for single line comment started with %
-    singleLineCommentFormat.setForeground(Qt::gray);
-    rule.pattern = QRegExp("%[^\n]*");
-    rule.format = singleLineCommentFormat;
-    highlightingRules.append(rule);
-
-    //set rule for multi line comment started with /* and ended with */
-    multiLineCommentFormat.setForeground(Qt::red);
-    commentStartExpression = QRegExp("/\\*");
-    commentEndExpression = QRegExp("\\*/");
+    /*set format for any keywords started with \*/
+    formats[Command].setFontWeight(QFont::Bold);
+    formats[Command].setForeground(Qt::darkMagenta);
+
+    //set format for any keywords inside parenthesis {...}
+    formats[Group].setFontItalic(true);
+    formats[Group].setForeground(Qt::darkGreen);
+
+    //set format for single line comment started with %
+    formats[Comment].setForeground(Qt::gray);
+
+    //set format for multi line comment started with /* and ended with */
+    formats[MultiLineComment].setForeground(Qt::red);
+
+    //reserved capacity survives the resize(0) done for every block
+    tokens.reserve(64);
 }
-//! [1]
+//! [0]
 
-//! [2]
+//! [1]
 //! implement highlightBlock function from QSyntaxHighLighter
-//! applying highlight rules to words
+//! applying the formats of the tokens of the block
+//! a deferred block keeps no formats and the Normal state until the
+//! HighlightScheduler gets to it
 void Highlighter::highlightBlock(const QString &text)
 {
-    //set highlight format
-    foreach (const HighlightingRule &rule, highlightingRules) {
-        QRegExp expression(rule.pattern);
-        int index = expression.indexIn(text);
-        while (index >= 0) {
-            int length = expression.matchedLength();
-            setFormat(index, length, rule.format);
-            index = expression.indexIn(text, index + length);
+    BlockData *data = BlockData::of(currentBlock());
+    if (deferred) {
+        if (data)
+            data->highlighted = false;
+        setCurrentBlockState(Normal);
+        return;
+    }
+    PerfProbe probe(PerfProbe::HighlightBlock);
+    if (!data) {
+        data = new BlockData;
+        setCurrentBlockUserData(data);
+    }
+    data->highlighted = true;
+
+    tokens.resize(0);
+    const int state = tokenize(text, previousBlockState(), &tokens);
+    foreach (const Token &token, tokens)
+        setFormat(token.start, token.length, formats[token.kind]);
+    setCurrentBlockState(state);
+}
+//! [1]
+
+//! [2]
+//! function: tokenize(param: block text, state of the previous block, out: tokens)
+//! scan the text once, return the state at the end of the block
+//! tokens are in start order, a group comes before the tokens it contains,
+//! so applying them in order lets commands and comments win over groups
+int Highlighter::tokenize(const QString &text, int previousState, QVector<Token> *tokens)
+{
+    const QChar *data = text.constData();
+    const int length = text.length();
+    int i = 0;
+
+    //continue a comment opened in an earlier block
+    if (previousState == InMultiLineComment) {
+        const int end = commentEnd(data, length, 0);
+        if (end < 0) {
+            appendToken(tokens, 0, length, MultiLineComment);
+            return InMultiLineComment;
         }
+        appendToken(tokens, 0, end + 2, MultiLineComment);
+        i = end + 2;
     }
-    setCurrentBlockState(0);
-    int startIndex = 0;
-    if (previousBlockState() != 1)
-        startIndex = commentStartExpression.indexIn(text);
-
-    while (startIndex >= 0) {
-        int endIndex = commentEndExpression.indexIn(text, startIndex);
-        int commentLength;
-        if (endIndex == -1) {
-            setCurrentBlockState(1);
-            commentLength = text.length() - startIndex;
+
+    int state = Normal;
+    int depth = 0;
+    int group = -1;
+    int stop = length;
+    while (i < length) {
+        const ushort c = data[i].unicode();
+        if (c == '\\') {
+            int j = i + 1;
+            while (j < length && isAsciiLetter(data[j].unicode()))
+                ++j;
+            if (j > i + 1) {
+                appendToken(tokens, i, j - i, Command);
+                i = j;
+            } else {
+                //escaped character such as \% or \{
+                i += 2;
+            }
+        } else if (c == '%') {
+            appendToken(tokens, i, length - i, Comment);
+            stop = i;
+            break;
+        } else if (c == '/' && i + 1 < length && data[i + 1].unicode() == '*') {
+            const int end = commentEnd(data, length, i + 2);
+            if (end < 0) {
+                appendToken(tokens, i, length - i, MultiLineComment);
+                state = InMultiLineComment;
+                stop = i;
+                break;
+            }
+            appendToken(tokens, i, end + 2 - i, MultiLineComment);
+            i = end + 2;
+        } else if (c == '{') {
+            if (depth++ == 0) {
+                group = tokens->size();
+                appendToken(tokens, i, 0, Group);
+            }
+            ++i;
+        } else if (c == '}' && depth > 0) {
+            if (--depth == 0)
+                (*tokens)[group].length = i + 1 - tokens->at(group).start;
+            ++i;
         } else {
-            commentLength = endIndex - startIndex
-                            + commentEndExpression.matchedLength();
+            ++i;
         }
-        setFormat(startIndex, commentLength, multiLineCommentFormat);
-        startIndex = commentStartExpression.indexIn(text, startIndex + commentLength);
     }
+
+    //a group left open runs to the end of the code on this line
+    if (depth > 0)
+        (*tokens)[group].length = stop - tokens->at(group).start;
+    return state;
 }
 //! [2]
+
+//! [3]
+//! function: tokenFormat(param: token kind)
+//! character format used for a kind of token
+const QTextCharFormat &Highlighter::tokenFormat(TokenKind kind) const
+{
+    return formats[kind];
+}
+//! [3]
+
+//! [4]
+//! function: setDeferred(param: bool)
+//! skip the formatting of blocks while a document is loaded
+void Highlighter::setDeferred(bool defer)
+{
+    deferred = defer;
+}
+
+bool Highlighter::isDeferred() const
+{
+    return deferred;
+}
+
+bool Highlighter::isHighlighted(const QTextBlock &block)
+{
+    const BlockData *data = BlockData::of(block);
+    return data && data->highlighted;
+}
+//! [4]
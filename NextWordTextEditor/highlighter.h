@@ -53,8 +53,10 @@
 
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
+class QTextBlock;
 class QTextDocument;
 QT_END_NAMESPACE
 
@@ -64,28 +66,42 @@ class Highlighter : public QSyntaxHighlighter
     Q_OBJECT
 
 public:
-    Highlighter(QTextDocument *parent = 0);
+    enum TokenKind {
+        Command,            // \name
+        Group,              // outermost {...} on the line
+        Comment,            // % to the end of the line
+        MultiLineComment,   // /* ... */, may span blocks
+        TokenKindCount
+    };
 
-protected:
-    void highlightBlock(const QString &text) Q_DECL_OVERRIDE;
+    enum BlockState {
+        Normal = 0,
+        InMultiLineComment = 1
+    };
 
-private:
-    struct HighlightingRule
+    struct Token
     {
-        QRegExp pattern;
-        QTextCharFormat format;
+        int start;
+        int length;
+        TokenKind kind;
     };
-    QVector<HighlightingRule> highlightingRules;
 
-    QRegExp commentStartExpression;
-    QRegExp commentEndExpression;
+    Highlighter(QTextDocument *parent = 0);
 
-    QTextCharFormat keywordFormat;
-    QTextCharFormat classFormat;
-    QTextCharFormat singleLineCommentFormat;
-    QTextCharFormat multiLineCommentFormat;
-    QTextCharFormat quotationFormat;
-    QTextCharFormat functionFormat;
+    static int tokenize(const QString &text, int previousState, QVector<Token> *tokens);
+    const QTextCharFormat &tokenFormat(TokenKind kind) const;
+
+    void setDeferred(bool deferred);
+    bool isDeferred() const;
+    static bool isHighlighted(const QTextBlock &block);
+
+protected:
+    void highlightBlock(const QString &text) Q_DECL_OVERRIDE;
+
+private:
+    QTextCharFormat formats[TokenKindCount];
+    QVector<Token> tokens;
+    bool deferred;
 };
 //! [0]
 
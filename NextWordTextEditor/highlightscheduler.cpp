@@ -0,0 +1,96 @@
+/*
+ * HighlightScheduler Class
+ * Highlight the visible blocks first and the rest of the document when idle
+*/
+#include "highlightscheduler.h"
+#include "highlighter.h"
+
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextEdit>
+
+//! [0]
+//! main function
+//! follow the scroll position of the editor
+HighlightScheduler::HighlightScheduler(Highlighter *highlighter, QTextEdit *editor)
+    : QObject(editor), highlighter(highlighter), editor(editor), nextBlock(0)
+{
+    //a zero interval timer fires whenever the event loop is idle
+    idle.setInterval(0);
+    connect(&idle, SIGNAL(timeout()), this, SLOT(highlightSlice()));
+    connect(editor->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(highlightVisible()));
+    connect(editor->verticalScrollBar(), SIGNAL(rangeChanged(int,int)), this, SLOT(highlightVisible()));
+}
+//! [0]
+
+//! [1]
+//! function: beginLoad()
+//! called before the text is replaced, blocks added from now on stay plain
+void HighlightScheduler::beginLoad()
+{
+    idle.stop();
+    highlighter->setDeferred(true);
+}
+//! [1]
+
+//! [2]
+//! function: endLoad()
+//! called once the text is in place: highlight what is visible now,
+//! then walk the document from the start in idle slices
+//! the walk is pending before the viewport is highlighted, which does
+//! nothing otherwise
+void HighlightScheduler::endLoad()
+{
+    highlighter->setDeferred(false);
+    nextBlock = 0;
+    idle.start();
+    highlightVisible();
+}
+
+bool HighlightScheduler::isPending() const
+{
+    return idle.isActive();
+}
+//! [2]
+
+//! [3]
+//! function: highlightVisible()
+//! highlight the blocks shown in the viewport that are still plain
+void HighlightScheduler::highlightVisible()
+{
+    if (!isPending() || highlighter->isDeferred())
+        return;
+    const QRect area = editor->viewport()->rect();
+    QTextBlock block = editor->cursorForPosition(area.topLeft()).block();
+    const QTextBlock last = editor->cursorForPosition(area.bottomRight()).block();
+    while (block.isValid() && block.blockNumber() <= last.blockNumber()) {
+        if (!Highlighter::isHighlighted(block))
+            highlighter->rehighlightBlock(block);
+        block = block.next();
+    }
+}
+//! [3]
+
+//! [4]
+//! function: highlightSlice()
+//! highlight plain blocks in document order for at most SliceMs,
+//! stop once the end of the document is reached
+void HighlightScheduler::highlightSlice()
+{
+    QElapsedTimer slice;
+    slice.start();
+    QTextBlock block = editor->document()->findBlockByNumber(nextBlock);
+    while (block.isValid() && slice.elapsed() < SliceMs) {
+        if (!Highlighter::isHighlighted(block))
+            highlighter->rehighlightBlock(block);
+        block = block.next();
+    }
+    if (!block.isValid()) {
+        idle.stop();
+        return;
+    }
+    nextBlock = block.blockNumber();
+}
+//! [4]
@@ -0,0 +1,54 @@
+/*
+ * Header HighlightScheduler class
+ * Viewport-first, time-sliced highlighting of large documents
+*/
+
+#ifndef HIGHLIGHTSCHEDULER_H
+#define HIGHLIGHTSCHEDULER_H
+
+//import dependencies
+#include <QObject>
+#include <QTimer>
+
+QT_BEGIN_NAMESPACE
+class QTextEdit;
+QT_END_NAMESPACE
+class Highlighter;
+
+//! [0]
+//! While a document is loaded the highlighter is deferred: blocks only get
+//! the Normal state and no formats, so loading costs nothing per block.
+//! Afterwards the visible blocks are highlighted at once and the rest of the
+//! document in slices of at most SliceMs from an idle timer. Highlighting a
+//! block with QSyntaxHighlighter::rehighlightBlock only continues into the
+//! following blocks while their /* */ state changes, so skipped blocks
+//! left in the Normal state are not touched again for nothing.
+class HighlightScheduler : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const int SliceMs = 8;
+
+        HighlightScheduler(Highlighter *highlighter, QTextEdit *editor);
+
+        void beginLoad();
+        void endLoad();
+        bool isPending() const;
+
+    //set private slots methods
+    private slots:
+        void highlightVisible();
+        void highlightSlice();
+
+    //set private methods & variables
+    private:
+        Highlighter *highlighter;
+        QTextEdit *editor;
+        QTimer idle;
+        int nextBlock;
+};
+//! [0]
+
+#endif // HIGHLIGHTSCHEDULER_H
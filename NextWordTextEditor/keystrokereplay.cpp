@@ -0,0 +1,207 @@
+/*
+ * KeystrokeReplay Class
+ * Send the keys of a trace to the editor and time them until painted
+*/
+#include "keystrokereplay.h"
+#include "textedit.h"
+
+#include <QAbstractEventDispatcher>
+#include <QAbstractItemView>
+#include <QApplication>
+#include <QCompleter>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QKeyEvent>
+
+namespace {
+
+//a key is given up on when nothing was painted after this long (ms)
+const int PaintTimeout = 1000;
+
+} // namespace
+
+//! [0]
+//! main function
+//! watch the paint events of the editor and of the popup
+KeystrokeReplay::KeystrokeReplay(TextEdit *editor, QCompleter *completer, QObject *parent)
+    : QObject(parent), editor(editor), completer(completer), editorPainted(false), popupPainted(false)
+{
+    editor->viewport()->installEventFilter(this);
+    completer->popup()->viewport()->installEventFilter(this);
+}
+//! [0]
+
+//! [1]
+//! function: loadTrace(param: string of file path)
+//! parse the keys of a trace, false with errorString() on a bad file
+bool KeystrokeReplay::loadTrace(const QString &fileName)
+{
+    keystrokes.clear();
+    traceName = fileName;
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        error = file.errorString();
+        return false;
+    }
+    const QString trace = QString::fromUtf8(file.readAll());
+
+    for (int i = 0; i < trace.size(); ++i) {
+        const QChar c = trace.at(i);
+        Keystroke keystroke;
+        keystroke.modifiers = Qt::NoModifier;
+        if (c == QLatin1Char('{') && i + 1 < trace.size() && trace.at(i + 1) != QLatin1Char('{')) {
+            const int end = trace.indexOf(QLatin1Char('}'), i);
+            if (end < 0 || !specialKey(trace.mid(i + 1, end - i - 1), &keystroke)) {
+                error = tr("unknown key at offset %1").arg(i);
+                return false;
+            }
+            i = end;
+        } else if (c == QLatin1Char('\n')) {
+            specialKey("Return", &keystroke);
+        } else {
+            if (c == QLatin1Char('{'))
+                ++i;
+            keystroke.key = c.toUpper().unicode();
+            keystroke.text = c;
+            if (c.isUpper())
+                keystroke.modifiers = Qt::ShiftModifier;
+        }
+        keystrokes.append(keystroke);
+    }
+    error.clear();
+    return true;
+}
+
+QString KeystrokeReplay::errorString() const
+{
+    return error;
+}
+//! [1]
+
+//! [2]
+//! function: specialKey(param: key name, out: keystroke)
+//! key code and text of a {Name} key
+bool KeystrokeReplay::specialKey(const QString &name, Keystroke *keystroke)
+{
+    static const struct { const char *name; int key; const char *text; } keys[] = {
+        { "Return", Qt::Key_Return, "\r" },
+        { "Enter", Qt::Key_Enter, "\r" },
+        { "Tab", Qt::Key_Tab, "\t" },
+        { "Backtab", Qt::Key_Backtab, "" },
+        { "Escape", Qt::Key_Escape, "\x1b" },
+        { "Backspace", Qt::Key_Backspace, "\b" },
+        { "Delete", Qt::Key_Delete, "\x7f" },
+        { "Up", Qt::Key_Up, "" },
+        { "Down", Qt::Key_Down, "" },
+        { "Left", Qt::Key_Left, "" },
+        { "Right", Qt::Key_Right, "" },
+        { "Home", Qt::Key_Home, "" },
+        { "End", Qt::Key_End, "" }
+    };
+    for (unsigned i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+        if (name == QLatin1String(keys[i].name)) {
+            keystroke->key = keys[i].key;
+            keystroke->text = QLatin1String(keys[i].text);
+            keystroke->modifiers = keys[i].key == Qt::Key_Backtab ? Qt::ShiftModifier : Qt::NoModifier;
+            return true;
+        }
+    }
+    return false;
+}
+//! [2]
+
+//! [3]
+//! function: run()
+//! replay the whole trace, the histograms keep adding up over runs
+void KeystrokeReplay::run()
+{
+    editor->setFocus();
+    foreach (const Keystroke &keystroke, keystrokes) {
+        bool popupShown = false;
+        const qint64 latency = replay(keystroke, &popupShown);
+        all.record(latency);
+        if (popupShown)
+            popup.record(latency);
+        else
+            typing.record(latency);
+    }
+}
+//! [3]
+
+//! [4]
+//! function: replay(param: keystroke, out: popup open afterwards)
+//! press and release one key, return the ns until its result was painted
+qint64 KeystrokeReplay::replay(const Keystroke &keystroke, bool *popupShown)
+{
+    QWidget *target = QApplication::activePopupWidget();
+    if (!target)
+        target = editor;
+    QKeyEvent press(QEvent::KeyPress, keystroke.key, keystroke.modifiers, keystroke.text);
+    QKeyEvent release(QEvent::KeyRelease, keystroke.key, keystroke.modifiers, keystroke.text);
+
+    editorPainted = false;
+    popupPainted = false;
+    QElapsedTimer timer;
+    timer.start();
+    QApplication::sendEvent(target, &press);
+
+    //the popup is updated from the completion timer or from the answer of
+    //the worker, wait for both before looking at it; a key that leaves the
+    //popup open is done once the popup is painted, stop early when no paint
+    //is pending at all
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+    for (;;) {
+        QCoreApplication::processEvents();
+        if (timer.elapsed() > PaintTimeout)
+            break;
+        if (editor->isCompleting())
+            continue;
+        *popupShown = completer->popup()->isVisible();
+        const bool painted = *popupShown ? popupPainted : (editorPainted || popupPainted);
+        if (painted || !dispatcher->hasPendingEvents())
+            break;
+    }
+    *popupShown = completer->popup()->isVisible();
+    const qint64 latency = timer.nsecsElapsed();
+
+    QApplication::sendEvent(QApplication::activePopupWidget() ? QApplication::activePopupWidget() : editor,
+                            &release);
+    return latency;
+}
+//! [4]
+
+//! [5]
+//! function: eventFilter(param: watched viewport, event)
+//! note the paint events of the watched viewports
+//! the popup only counts once it shows the rows of the key's query
+bool KeystrokeReplay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint) {
+        if (watched == editor->viewport())
+            editorPainted = true;
+        else if (!editor->isCompleting())
+            popupPainted = true;
+    }
+    return QObject::eventFilter(watched, event);
+}
+//! [5]
+
+//! [6]
+//! function: allLatency(), report()
+//! histograms of the replayed keys as JSON
+const LatencyHistogram &KeystrokeReplay::allLatency() const
+{
+    return all;
+}
+
+QJsonObject KeystrokeReplay::report() const
+{
+    QJsonObject json;
+    json["trace"] = traceName;
+    json["keystrokes"] = keystrokes.size();
+    json["all"] = all.toJson();
+    json["popup"] = popup.toJson();
+    json["typing"] = typing.toJson();
+    return json;
+}
+//! [6]
@@ -0,0 +1,75 @@
+/*
+ * Header KeystrokeReplay class
+ * Replay a keystroke trace against the editor and measure typing latency
+*/
+
+#ifndef KEYSTROKEREPLAY_H
+#define KEYSTROKEREPLAY_H
+
+//import dependencies
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "latencyhistogram.h"
+
+QT_BEGIN_NAMESPACE
+class QCompleter;
+QT_END_NAMESPACE
+class TextEdit;
+
+//! [0]
+//! A trace is text typed key by key. A line break is Return and {Name}
+//! is a special key: Return, Enter, Tab, Backtab, Escape, Backspace,
+//! Delete, Up, Down, Left, Right, Home, End; {{ is a literal brace.
+//! Every key press is sent where a user's would go (the completer popup
+//! while it is open) and timed until its coalesced completion query has
+//! been answered, on the worker thread too, and then the popup, or else the
+//! editor, has been painted. Popup paints during the query do not count.
+//! The popup histogram holds the keys that left the popup open, the typing
+//! histogram all others.
+class KeystrokeReplay : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        KeystrokeReplay(TextEdit *editor, QCompleter *completer, QObject *parent = 0);
+
+        bool loadTrace(const QString &fileName);
+        QString errorString() const;
+        void run();
+
+        const LatencyHistogram &allLatency() const;
+        QJsonObject report() const;
+
+    //set protected methods & variables
+    protected:
+        bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
+
+    //set private methods & variables
+    private:
+        struct Keystroke
+        {
+            int key;
+            Qt::KeyboardModifiers modifiers;
+            QString text;
+        };
+
+        static bool specialKey(const QString &name, Keystroke *keystroke);
+        qint64 replay(const Keystroke &keystroke, bool *popupShown);
+
+        TextEdit *editor;
+        QCompleter *completer;
+        QVector<Keystroke> keystrokes;
+        QString traceName;
+        QString error;
+        bool editorPainted;
+        bool popupPainted;
+        LatencyHistogram all;
+        LatencyHistogram popup;
+        LatencyHistogram typing;
+};
+//! [0]
+
+#endif // KEYSTROKEREPLAY_H
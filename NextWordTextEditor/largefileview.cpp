@@ -0,0 +1,962 @@
+/*
+ * LargeFileView Class
+ * Show and edit a memory-mapped file, laying out only the visible lines
+*/
+#include "largefileview.h"
+#include "completionmodel.h"
+#include "latexcompletion.h"
+#include "perfprobe.h"
+
+#include <QAbstractItemView>
+#include <QCompleter>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QSaveFile>
+#include <QScrollBar>
+#include <QtConcurrent>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+//left margin of the text, in pixels
+const int Margin = 4;
+
+//quiet time after an edit before the matches of a query are found again
+const int SearchDelayMs = 200;
+
+//UTF-16 length of UTF-8 bytes, a four byte sequence is a surrogate pair
+int utf16Length(const char *p, const char *end)
+{
+    int length = 0;
+    for (; p < end; ++p) {
+        const uchar c = uchar(*p);
+        if ((c & 0xc0) != 0x80)
+            length += c >= 0xf0 ? 2 : 1;
+    }
+    return length;
+}
+
+//word of letters and digits ending at end of a line
+QString wordBefore(const QString &line, int end)
+{
+    int start = end;
+    while (start > 0 && line.at(start - 1).isLetterOrNumber())
+        --start;
+    return line.mid(start, end - start);
+}
+
+//the word before the one ending at end, if only spaces separate them
+QString previousWord(const QString &line, int end)
+{
+    int wordEnd = end - wordBefore(line, end).length();
+    if (wordEnd == 0 || !line.at(wordEnd - 1).isSpace())
+        return QString();
+    while (wordEnd > 0 && line.at(wordEnd - 1).isSpace())
+        --wordEnd;
+    return wordBefore(line, wordEnd);
+}
+
+//counts the newlines of one block of the mapped file
+struct NewlineCounter
+{
+    typedef qint64 result_type;
+
+    const uchar *data;
+    qint64 size;
+
+    qint64 operator()(qint64 block) const
+    {
+        const uchar *p = data + block * LargeFileView::BlockSize;
+        const uchar *end = data + qMin(size, (block + 1) * LargeFileView::BlockSize);
+        qint64 count = 0;
+        while (p < end && (p = static_cast<const uchar *>(std::memchr(p, '\n', end - p))) != 0) {
+            ++count;
+            ++p;
+        }
+        return count;
+    }
+};
+
+} // namespace
+
+//! [0]
+//! main function
+//! the highlighter is only used for its tokenizer and formats
+LargeFileView::LargeFileView(QWidget *parent)
+    : QAbstractScrollArea(parent), data(0), size(0), editable(false), cursor(0), anchor(-1),
+      highlighter(new Highlighter(0)), widest(0), c(0), completionForced(false), awaitingMatches(false)
+{
+    QFont font;
+    font.setFamily("Arial");
+    font.setFixedPitch(true);
+    font.setPointSize(12);
+    setFont(font);
+    tokens.reserve(64);
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+
+    connect(&indexer, SIGNAL(progressValueChanged(int)), this, SLOT(indexProgressChanged(int)));
+    connect(&indexer, SIGNAL(finished()), this, SLOT(indexFinished()));
+
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(SearchDelayMs);
+    connect(&searchTimer, SIGNAL(timeout()), this, SLOT(runSearch()));
+}
+
+LargeFileView::~LargeFileView()
+{
+    close();
+}
+//! [0]
+
+//! [1]
+//! function: open(param: string of file path)
+//! map the file and start indexing its lines in the background
+bool LargeFileView::open(const QString &fileName)
+{
+    close();
+    file.setFileName(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    size = file.size();
+    if (size > 0) {
+        data = file.map(0, size);
+        if (!data) {
+            error = file.errorString();
+            file.close();
+            size = 0;
+            return false;
+        }
+    }
+
+    QVector<qint64> blocks;
+    const qint64 blockCount = (size + BlockSize - 1) / BlockSize;
+    blocks.reserve(int(blockCount));
+    for (qint64 i = 0; i < blockCount; ++i)
+        blocks.append(i);
+    NewlineCounter counter;
+    counter.data = data;
+    counter.size = size;
+    indexer.setFuture(QtConcurrent::mapped(blocks, counter));
+
+    updateScrollBars();
+    viewport()->update();
+    return true;
+}
+//! [1]
+
+//! [2]
+//! function: close()
+//! stop indexing and unmap the file
+void LargeFileView::close()
+{
+    indexer.cancel();
+    indexer.waitForFinished();
+    clearFind();
+    table.clear();
+    editable = false;
+    cursor = 0;
+    if (data)
+        file.unmap(const_cast<uchar *>(data));
+    if (file.isOpen())
+        file.close();
+    data = 0;
+    size = 0;
+    widest = 0;
+    error.clear();
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateScrollBars();
+    viewport()->update();
+}
+//! [2]
+
+//! [3]
+//! function: fileName(), errorString(), isIndexed(), lineCount()
+//! state of the viewed file, lineCount() is 0 until the index is ready
+QString LargeFileView::fileName() const
+{
+    return file.isOpen() ? file.fileName() : QString();
+}
+
+QString LargeFileView::errorString() const
+{
+    return error;
+}
+
+bool LargeFileView::isIndexed() const
+{
+    return editable;
+}
+
+qint64 LargeFileView::lineCount() const
+{
+    return editable ? table.lineCount() : 0;
+}
+//! [3]
+
+//! [4]
+//! function: indexProgressChanged(param: blocks counted), indexFinished()
+//! turn the newline counts per block into prefix sums, the index of the
+//! piece table over the mapped file
+void LargeFileView::indexProgressChanged(int blocks)
+{
+    const int total = indexer.progressMaximum();
+    emit indexProgress(total > 0 ? int(qint64(blocks) * 100 / total) : 100);
+}
+
+void LargeFileView::indexFinished()
+{
+    if (indexer.isCanceled() || !file.isOpen())
+        return;
+    const QFuture<qint64> counts = indexer.future();
+    const int blockCount = counts.resultCount();
+    QVector<qint64> blockLines(blockCount + 1);
+    blockLines[0] = 0;
+    for (int i = 0; i < blockCount; ++i)
+        blockLines[i + 1] = blockLines.at(i) + counts.resultAt(i);
+    indexer.setFuture(QFuture<qint64>());
+    table.setText(reinterpret_cast<const char *>(data), size, blockLines);
+    editable = true;
+
+    updateScrollBars();
+    viewport()->update();
+    emit indexed();
+    //a query typed while indexing found nothing yet
+    if (!search.pattern().isEmpty()) {
+        search.invalidate();
+        runSearch();
+    }
+}
+//! [4]
+
+//! [5]
+//! function: lineStart(param: line number)
+//! byte offset of a line, looked up in the piece table; before the index
+//! is ready the newlines are counted from the top of the file
+qint64 LargeFileView::lineStart(qint64 line) const
+{
+    if (editable)
+        return table.lineStart(line);
+    if (line <= 0 || !data)
+        return 0;
+    qint64 remaining = line;
+    const uchar *p = data;
+    const uchar *end = data + size;
+    while (p < end && (p = static_cast<const uchar *>(std::memchr(p, '\n', end - p))) != 0) {
+        ++p;
+        if (--remaining == 0)
+            return p - data;
+    }
+    return size;
+}
+
+qint64 LargeFileView::lineEnd(qint64 start) const
+{
+    if (editable) {
+        const qint64 line = table.lineAt(start);
+        return line + 1 < table.lineCount() ? table.lineStart(line + 1) - 1 : table.size();
+    }
+    if (start >= size)
+        return size;
+    const void *newline = std::memchr(data + start, '\n', size - start);
+    return newline ? static_cast<const uchar *>(newline) - data : size;
+}
+//! [5]
+
+//! [6]
+//! function: lineText(param: byte range of a line)
+//! decode at most MaxLineLength bytes of the line
+QString LargeFileView::lineText(qint64 start, qint64 end) const
+{
+    const qint64 length = qMin(end - start, qint64(MaxLineLength));
+    QByteArray bytes = editable ? table.text(start, length)
+                                : QByteArray::fromRawData(reinterpret_cast<const char *>(data + start), int(length));
+    if (bytes.endsWith('\r'))
+        bytes.chop(1);
+    return QString::fromUtf8(bytes);
+}
+
+//! function: lineFormats(param: text of a line, comment state before it)
+//! highlighter formats of the tokens of a line, the state is advanced
+QVector<QTextLayout::FormatRange> LargeFileView::lineFormats(const QString &text, int *state)
+{
+    tokens.resize(0);
+    *state = Highlighter::tokenize(text, *state, &tokens);
+    QVector<QTextLayout::FormatRange> ranges;
+    ranges.reserve(tokens.size());
+    foreach (const Highlighter::Token &token, tokens) {
+        QTextLayout::FormatRange range;
+        range.start = token.start;
+        range.length = token.length;
+        range.format = highlighter->tokenFormat(token.kind);
+        ranges.append(range);
+    }
+    return ranges;
+}
+
+//! function: addMatchFormats(param: byte range of a line, formats)
+//! highlight the matches in the shown part of a line, the selected one stronger;
+//! byte offsets become columns in one pass over the line
+void LargeFileView::addMatchFormats(qint64 start, qint64 end, QVector<QTextLayout::FormatRange> *ranges) const
+{
+    const QVector<TextMatch> &matches = search.matches();
+    if (!editable || search.isStale() || matches.isEmpty())
+        return;
+    const qint64 shownEnd = start + qMin(end - start, qint64(MaxLineLength));
+    const QByteArray bytes = table.text(start, shownEnd - start);
+    qint64 counted = 0;
+    int column = 0;
+    //a match may start on an earlier line
+    for (int index = qMax(0, search.matchAfter(start) - 1);
+         index < matches.size() && matches.at(index).position < shownEnd; ++index) {
+        const TextMatch &match = matches.at(index);
+        const qint64 from = qMax(match.position, start) - start;
+        const qint64 to = qMin(match.position + match.length, shownEnd) - start;
+        if (from >= to)
+            continue;
+        QTextLayout::FormatRange range;
+        column += utf16Length(bytes.constData() + counted, bytes.constData() + from);
+        range.start = column;
+        column += utf16Length(bytes.constData() + from, bytes.constData() + to);
+        range.length = column - range.start;
+        counted = to;
+        range.format.setBackground(match.position == anchor ? QColor(255, 160, 60) : QColor(255, 230, 120));
+        ranges->append(range);
+    }
+}
+//! [6]
+
+//! [7]
+//! function: paintEvent(param: QPaintEvent)
+//! lay out and draw the lines of the viewport, the comment state starts
+//! as Normal at the first visible line; the cursor is drawn in its line
+void LargeFileView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().base());
+    if (!file.isOpen())
+        return;
+
+    const int lineHeight = fontMetrics().lineSpacing();
+    const int x = Margin - horizontalScrollBar()->value();
+    const qint64 textSize = editable ? table.size() : size;
+    qint64 start = lineStart(verticalScrollBar()->value());
+    int state = Highlighter::Normal;
+    int wider = widest;
+    for (int y = 0; y < viewport()->height(); y += lineHeight) {
+        const qint64 end = lineEnd(start);
+        const QString text = lineText(start, end);
+
+        QTextLayout layout(text, font(), viewport());
+        QVector<QTextLayout::FormatRange> formats = lineFormats(text, &state);
+        addMatchFormats(start, end, &formats);
+        layout.setFormats(formats);
+        layout.beginLayout();
+        QTextLine line = layout.createLine();
+        layout.endLayout();
+        layout.draw(&painter, QPointF(x, y));
+        wider = qMax(wider, int(line.naturalTextWidth()));
+        if (editable && cursor >= start && cursor <= end)
+            layout.drawCursor(&painter, QPointF(x, y), qMin(text.size(), lineText(start, cursor).size()));
+
+        if (end >= textSize)
+            break;
+        start = end + 1;
+    }
+
+    if (wider > widest) {
+        widest = wider;
+        updateScrollBars();
+    }
+}
+//! [7]
+
+//! [8]
+//! function: resizeEvent(param: QResizeEvent), scrollContentsBy(param: scroll)
+//! the scroll bars count lines and pixels, every scroll repaints
+void LargeFileView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void LargeFileView::scrollContentsBy(int, int)
+{
+    viewport()->update();
+}
+//! [8]
+
+//! [9]
+//! function: visibleLines(), updateScrollBars()
+//! fit the scroll ranges to the index and the widest line seen so far
+int LargeFileView::visibleLines() const
+{
+    return qMax(1, viewport()->height() / fontMetrics().lineSpacing());
+}
+
+void LargeFileView::updateScrollBars()
+{
+    const int page = visibleLines();
+    //a scroll bar holds an int, files beyond INT_MAX lines stop there
+    const qint64 lines = qMin(lineCount(), qint64(INT_MAX));
+    verticalScrollBar()->setPageStep(page);
+    verticalScrollBar()->setRange(0, int(qMax(qint64(0), lines - page)));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, widest + 8 - viewport()->width()));
+}
+//! [9]
+
+//! [10]
+//! function: isModified(), save(param: string of file path)
+//! stream the text, or the untouched mapping, to the file through a QSaveFile
+bool LargeFileView::isModified() const
+{
+    return editable && table.isModified();
+}
+
+bool LargeFileView::save(const QString &fileName)
+{
+    QSaveFile out(fileName);
+    if (!out.open(QIODevice::WriteOnly)) {
+        error = out.errorString();
+        return false;
+    }
+    const bool written = editable ? table.write(&out)
+                                  : out.write(reinterpret_cast<const char *>(data), size) == size;
+    if (!written || !out.commit()) {
+        error = out.errorString();
+        return false;
+    }
+    table.setModified(false);
+    return true;
+}
+//! [10]
+
+//! [11]
+//! function: keyPressEvent(param: QKeyEvent)
+//! edit the text at the cursor, then complete the word being typed
+void LargeFileView::keyPressEvent(QKeyEvent *event)
+{
+    PerfProbe probe(PerfProbe::KeyPress);
+    if (c && c->popup()->isVisible()) {
+        //the completer accepts or dismisses its popup itself
+        switch (event->key()) {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Escape:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+            event->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
+    const bool isShortcut = (event->modifiers() & Qt::ControlModifier) && event->key() == Qt::Key_E; // CTRL+E
+    if (!editable || (!isShortcut && !editKey(event))) {
+        QAbstractScrollArea::keyPressEvent(event);
+        return;
+    }
+    if (!c)
+        return;
+
+    static QString eow("~!@#$%^&*()_+{}|:\"<>?,./;'[]\\-="); // end of word
+    const QString typed = event->text();
+    const bool hasModifier = event->modifiers() & (Qt::ControlModifier | Qt::AltModifier);
+    if (typed == " ")
+        learnFinishedWord();
+    QString markupPrefix;
+    const bool markup = LatexCompletion::context(textBeforeCursor(), &markupPrefix) != LatexCompletion::Text;
+    if (!isShortcut && (hasModifier || typed.isEmpty() || typed.at(0).isSpace()
+                        || (!markup && eow.contains(typed.right(1))))) {
+        completionForced = false;
+        awaitingMatches = false;
+        c->popup()->hide();
+        if (typed != " ")
+            return;
+    }
+    updateCompletion(isShortcut);
+}
+
+//! function: editKey(param: QKeyEvent)
+//! apply an editing or cursor key, false for keys left to the scroll area
+bool LargeFileView::editKey(QKeyEvent *event)
+{
+    qint64 position;
+    if (event->matches(QKeySequence::Undo)) {
+        if ((position = table.undo()) >= 0) {
+            edited();
+            setCursorPosition(position);
+        }
+        return true;
+    }
+    if (event->matches(QKeySequence::Redo)) {
+        if ((position = table.redo()) >= 0) {
+            edited();
+            setCursorPosition(position);
+        }
+        return true;
+    }
+
+    const bool control = event->modifiers() & Qt::ControlModifier;
+    switch (event->key()) {
+    case Qt::Key_Left:
+        setCursorPosition(previousCharacter(cursor));
+        return true;
+    case Qt::Key_Right:
+        setCursorPosition(nextCharacter(cursor));
+        return true;
+    case Qt::Key_Up:
+        setCursorPosition(lineMoved(-1));
+        return true;
+    case Qt::Key_Down:
+        setCursorPosition(lineMoved(1));
+        return true;
+    case Qt::Key_PageUp:
+        setCursorPosition(lineMoved(-visibleLines()));
+        return true;
+    case Qt::Key_PageDown:
+        setCursorPosition(lineMoved(visibleLines()));
+        return true;
+    case Qt::Key_Home:
+        setCursorPosition(control ? 0 : lineStart(table.lineAt(cursor)));
+        return true;
+    case Qt::Key_End:
+        setCursorPosition(control ? table.size() : lineEnd(cursor));
+        return true;
+    case Qt::Key_Backspace:
+        removeText(previousCharacter(cursor), cursor);
+        return true;
+    case Qt::Key_Delete:
+        removeText(cursor, nextCharacter(cursor));
+        return true;
+    case Qt::Key_Enter:
+    case Qt::Key_Return:
+        insertText("\n");
+        return true;
+    default:
+        break;
+    }
+
+    const QString typed = event->text();
+    if (control || typed.isEmpty() || !(typed.at(0).isPrint() || typed.at(0) == QLatin1Char('\t')))
+        return false;
+    insertText(typed.toUtf8());
+    return true;
+}
+//! [11]
+
+//! [12]
+//! function: insertText(param: UTF-8 bytes), removeText(param: byte range)
+//! edit the piece table at the cursor and repaint
+void LargeFileView::insertText(const QByteArray &text)
+{
+    table.insert(cursor, text);
+    edited();
+    setCursorPosition(cursor + text.size());
+}
+
+void LargeFileView::removeText(qint64 start, qint64 end)
+{
+    if (start >= end)
+        return;
+    table.remove(start, end - start);
+    edited();
+    setCursorPosition(start);
+}
+
+//! function: edited()
+//! called after every change of the table: the matches are found again
+//! once typing pauses, and are not highlighted until then
+void LargeFileView::edited()
+{
+    updateScrollBars();
+    if (search.pattern().isEmpty())
+        return;
+    search.invalidate();
+    searchTimer.start();
+}
+
+//! function: setCursorPosition(param: byte position)
+//! move the cursor, dropping the selected match, and scroll it into view
+void LargeFileView::setCursorPosition(qint64 position)
+{
+    anchor = -1;
+    cursor = qBound(qint64(0), position, table.size());
+    ensureCursorVisible();
+    viewport()->update();
+}
+//! [12]
+
+//! [13]
+//! function: previousCharacter(param: position), nextCharacter(param: position)
+//! step over a whole UTF-8 sequence, and over CR LF as one line break
+qint64 LargeFileView::previousCharacter(qint64 position) const
+{
+    if (position <= 0)
+        return 0;
+    const qint64 from = qMax(qint64(0), position - 4);
+    const QByteArray bytes = table.text(from, position - from);
+    int i = bytes.size() - 1;
+    if (bytes.at(i) == '\n' && i > 0 && bytes.at(i - 1) == '\r')
+        return from + i - 1;
+    while (i > 0 && (quint8(bytes.at(i)) & 0xc0) == 0x80)
+        --i;
+    return from + i;
+}
+
+qint64 LargeFileView::nextCharacter(qint64 position) const
+{
+    const QByteArray bytes = table.text(position, 4);
+    if (bytes.isEmpty())
+        return position;
+    if (bytes.startsWith("\r\n"))
+        return position + 2;
+    int i = 1;
+    while (i < bytes.size() && (quint8(bytes.at(i)) & 0xc0) == 0x80)
+        ++i;
+    return position + i;
+}
+
+//! function: lineMoved(param: lines, negative upwards)
+//! the cursor position as many lines away, in the same character column
+qint64 LargeFileView::lineMoved(qint64 lines) const
+{
+    const qint64 line = table.lineAt(cursor);
+    const qint64 target = qBound(qint64(0), line + lines, table.lineCount() - 1);
+    const int column = textBeforeCursor().size();
+    const qint64 start = lineStart(target);
+    const QString text = lineText(start, lineEnd(start));
+    return start + text.left(column).toUtf8().size();
+}
+
+//! function: textBeforeCursor()
+//! text of the cursor line up to the cursor
+QString LargeFileView::textBeforeCursor() const
+{
+    return lineText(lineStart(table.lineAt(cursor)), cursor);
+}
+//! [13]
+
+//! [14]
+//! function: cursorRect(), ensureCursorVisible()
+//! viewport rectangle of the cursor, and scrolling it into view
+QRect LargeFileView::cursorRect() const
+{
+    const int lineHeight = fontMetrics().lineSpacing();
+    const qint64 line = table.lineAt(cursor) - verticalScrollBar()->value();
+    const int x = Margin - horizontalScrollBar()->value() + fontMetrics().width(textBeforeCursor());
+    return QRect(x, int(line) * lineHeight, 1, lineHeight);
+}
+
+void LargeFileView::ensureCursorVisible()
+{
+    const qint64 line = table.lineAt(cursor);
+    QScrollBar *vertical = verticalScrollBar();
+    if (line < vertical->value())
+        vertical->setValue(int(line));
+    else if (line >= vertical->value() + visibleLines())
+        vertical->setValue(int(line - visibleLines() + 1));
+
+    const int x = cursorRect().x() + horizontalScrollBar()->value();
+    if (x + Margin > widest) {
+        widest = x + Margin;
+        updateScrollBars();
+    }
+    QScrollBar *horizontal = horizontalScrollBar();
+    if (x - Margin < horizontal->value())
+        horizontal->setValue(x - Margin);
+    else if (x + Margin > horizontal->value() + viewport()->width())
+        horizontal->setValue(x + Margin - viewport()->width());
+}
+//! [14]
+
+//! [15]
+//! function: mousePressEvent(param: QMouseEvent), focusInEvent(param: QFocusEvent)
+//! place the cursor at the clicked character; take the completer along
+void LargeFileView::mousePressEvent(QMouseEvent *event)
+{
+    if (!editable || event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    if (c)
+        c->popup()->hide();
+    const qint64 line = qMin(verticalScrollBar()->value() + qint64(event->pos().y() / fontMetrics().lineSpacing()),
+                             table.lineCount() - 1);
+    const qint64 start = lineStart(line);
+    const QString text = lineText(start, lineEnd(start));
+    //the comment state of the line is not known here, words keep their width
+    int state = Highlighter::Normal;
+    QTextLayout layout(text, font());
+    layout.setFormats(lineFormats(text, &state));
+    layout.beginLayout();
+    QTextLine textLine = layout.createLine();
+    layout.endLayout();
+    const int column = textLine.xToCursor(event->pos().x() - Margin + horizontalScrollBar()->value());
+    setCursorPosition(start + text.left(column).toUtf8().size());
+}
+
+void LargeFileView::focusInEvent(QFocusEvent *event)
+{
+    if (c)
+        c->setWidget(this);
+    QAbstractScrollArea::focusInEvent(event);
+}
+//! [15]
+
+//! [16]
+//! function: setCompleter(param: QCompleter)
+//! share the completer of the text editor, it is attached on focus
+void LargeFileView::setCompleter(QCompleter *completer)
+{
+    if (c)
+        QObject::disconnect(c, 0, this, 0);
+    if (CompletionModel *model = completionModel())
+        QObject::disconnect(model, 0, this, 0);
+
+    c = completer;
+    if (!c)
+        return;
+    QObject::connect(c, SIGNAL(activated(QString)), this, SLOT(insertCompletion(QString)));
+    if (CompletionModel *model = completionModel())
+        QObject::connect(model, SIGNAL(matchesReady()), this, SLOT(matchesReady()));
+}
+
+//! function: completionModel()
+//! the indexed model behind the completer, null for other models
+CompletionModel *LargeFileView::completionModel() const
+{
+    return c ? qobject_cast<CompletionModel *>(c->model()) : 0;
+}
+
+//! function: insertCompletion(param: string)
+//! complete the typed prefix, words are learned as in the text editor
+void LargeFileView::insertCompletion(const QString &completion)
+{
+    if (c->widget() != this)
+        return;
+    awaitingMatches = false;
+    CompletionModel *model = completionModel();
+    if (model && model->latexContext() == LatexCompletion::Text)
+        model->recordCompletion(completion);
+    insertText(completion.right(completion.length() - c->completionPrefix().length()).toUtf8());
+}
+
+//! function: learnFinishedWord()
+//! called after a space was typed: learn the word before it and its bigram
+void LargeFileView::learnFinishedWord()
+{
+    CompletionModel *model = completionModel();
+    const QString line = textBeforeCursor();
+    const int end = line.size() - 1;
+    if (!model || end < 1 || !line.at(end - 1).isLetterOrNumber())
+        return;
+    model->recordTypedWord(previousWord(line, end), wordBefore(line, end));
+}
+//! [16]
+
+//! [17]
+//! function: updateCompletion(param: bool, CTRL+E)
+//! query the model with the word at the cursor and the word before it
+void LargeFileView::updateCompletion(bool forced)
+{
+    PerfProbe completion(PerfProbe::Completion);
+    CompletionModel *model = completionModel();
+    completionForced = completionForced || forced;
+    const QString line = textBeforeCursor();
+
+    //commands, labels and citation keys are completed from their own index
+    QString prefix;
+    const LatexCompletion::Context markup = LatexCompletion::context(line, &prefix);
+    if (model && markup != LatexCompletion::Text) {
+        model->setLatexQuery(markup, prefix);
+        showMatches();
+        return;
+    }
+    if (model) {
+        model->setQuery(previousWord(line, line.size()), wordBefore(line, line.size()));
+        if (model->isPending()) {
+            awaitingMatches = true;
+            return;
+        }
+    }
+    showMatches();
+}
+
+//! function: showMatches()
+//! show the popup below the cursor for the rows of the last query, or hide it
+void LargeFileView::showMatches()
+{
+    const bool forced = completionForced;
+    completionForced = false;
+    awaitingMatches = false;
+
+    CompletionModel *model = completionModel();
+    const QString prefix = model ? model->completionPrefix() : QString();
+    const bool markup = model && model->latexContext() != LatexCompletion::Text;
+    const bool predicting = model && model->predictionCount() > 0;
+    if ((markup && model->rowCount() == 0) || (!markup && !forced && !predicting && prefix.length() < 2)) {
+        c->popup()->hide();
+        return;
+    }
+    if (prefix != c->completionPrefix())
+        c->setCompletionPrefix(prefix);
+    c->popup()->setCurrentIndex(c->completionModel()->index(0, 0));
+    QRect cr = cursorRect();
+    cr.setWidth(c->popup()->sizeHintForColumn(0) + c->popup()->verticalScrollBar()->sizeHint().width());
+    c->complete(cr);
+}
+
+//! function: matchesReady()
+//! a background query was answered, shown if the view still waits for it
+void LargeFileView::matchesReady()
+{
+    if (awaitingMatches && c)
+        showMatches();
+}
+//! [17]
+
+//! [18]
+//! function: find(param: string pattern, options)
+//! find the matches of a query and select the first one from the selected
+//! match or the cursor, so that the selected match grows with the query
+//! Return the number of matches, 0 until the file is indexed
+int LargeFileView::find(const QString &pattern, TextSearch::Options options)
+{
+    search.setQuery(pattern, options);
+    runSearch();
+    const int index = search.matchAfter(anchor >= 0 ? anchor : cursor);
+    selectMatch(index < search.matches().size() ? index : 0);
+    return search.matches().size();
+}
+
+//! function: findNext(param: bool, search backward)
+//! select the next or the previous match, around the end of the file
+bool LargeFileView::findNext(bool backward)
+{
+    if (search.isStale())
+        runSearch();
+    const int count = search.matches().size();
+    if (count == 0)
+        return false;
+    int index;
+    if (backward) {
+        index = search.matchAfter(anchor >= 0 ? anchor : cursor) - 1;
+        if (index < 0)
+            index = count - 1;
+    } else {
+        index = search.matchAfter(cursor);
+        if (index == count)
+            index = 0;
+    }
+    selectMatch(index);
+    return true;
+}
+
+//! function: selectMatch(param: index of a match)
+//! put the cursor after a match and mark it as selected
+void LargeFileView::selectMatch(int index)
+{
+    if (index < 0 || index >= search.matches().size())
+        return;
+    const TextMatch &match = search.matches().at(index);
+    setCursorPosition(match.position + match.length);
+    anchor = match.position;
+}
+//! [18]
+
+//! [19]
+//! function: replace(param: string), replaceAll(param: string)
+//! replace the selected match and select the next one, or replace every
+//! match in one edit and one undo step of the piece table
+//! Return the number of replaced matches
+bool LargeFileView::replace(const QString &replacement)
+{
+    if (search.isStale())
+        runSearch();
+    const QVector<TextMatch> &matches = search.matches();
+    const int index = search.matchAfter(anchor);
+    if (anchor >= 0 && index < matches.size() && matches.at(index).position == anchor
+            && matches.at(index).position + matches.at(index).length == cursor) {
+        const QByteArray bytes = replacement.toUtf8();
+        const qint64 start = anchor;
+        table.replaceAll(QVector<TextMatch>() << matches.at(index), bytes);
+        edited();
+        setCursorPosition(start + bytes.size());
+        runSearch();
+    }
+    return findNext(false);
+}
+
+int LargeFileView::replaceAll(const QString &replacement)
+{
+    if (!editable || !search.isActive())
+        return 0;
+    const QVector<TextMatch> matches = search.findAll(table.spans(), INT_MAX);
+    if (matches.isEmpty())
+        return 0;
+    const QByteArray bytes = replacement.toUtf8();
+    table.replaceAll(matches, bytes);
+
+    //the cursor keeps its place in the text around it
+    qint64 position = cursor;
+    foreach (const TextMatch &match, matches) {
+        if (match.position >= cursor)
+            break;
+        if (match.position + match.length > cursor) {
+            position += match.position - cursor + bytes.size();
+            break;
+        }
+        position += bytes.size() - match.length;
+    }
+    edited();
+    setCursorPosition(position);
+    runSearch();
+    return matches.size();
+}
+//! [19]
+
+//! [20]
+//! function: clearFind(), textSearch(), runSearch()
+//! drop the query and its highlights, read its matches, or find them in the
+//! pieces of the table
+void LargeFileView::clearFind()
+{
+    search.clear();
+    searchTimer.stop();
+    anchor = -1;
+    viewport()->update();
+}
+
+const TextSearch &LargeFileView::textSearch() const
+{
+    return search;
+}
+
+void LargeFileView::runSearch()
+{
+    PerfProbe probe(PerfProbe::Search);
+    searchTimer.stop();
+    search.search(editable ? table.spans() : QVector<TextSearch::Span>());
+    viewport()->update();
+    emit matchesChanged();
+}
+//! [20]
+
+//! [21]
+//! function: goToLine(param: line number, from 0)
+//! put the cursor at the start of a line and scroll it into view,
+//! once the file is indexed
+void LargeFileView::goToLine(qint64 line)
+{
+    if (!editable)
+        return;
+    setCursorPosition(table.lineStart(qBound(qint64(0), line, table.lineCount() - 1)));
+}
+//! [21]
@@ -0,0 +1,144 @@
+/*
+ * Header LargeFileView class
+ * Memory-mapped editor for files too large for the text editor
+*/
+
+#ifndef LARGEFILEVIEW_H
+#define LARGEFILEVIEW_H
+
+//import dependencies
+#include <QAbstractScrollArea>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QScopedPointer>
+#include <QTextLayout>
+#include <QTimer>
+#include <QVector>
+#include "highlighter.h"
+#include "piecetable.h"
+#include "textsearch.h"
+
+QT_BEGIN_NAMESPACE
+class QCompleter;
+QT_END_NAMESPACE
+class CompletionModel;
+
+//! [0]
+//! The file is mapped with QFile::map and never copied. A background pass
+//! counts the newlines of every BlockSize bytes of the file in parallel,
+//! the prefix sums locate any line by a binary search and a scan of at most
+//! one block, so the index takes 8 bytes per BlockSize bytes of file.
+//! Once indexed the file is edited through a PieceTable over the mapped
+//! bytes: typing, deleting and undo touch a few pieces whatever the file
+//! size, and saving streams the pieces to a QSaveFile, which replaces the
+//! file by a rename so the mapped original stays valid.
+//! Only the lines in the viewport are decoded and laid out on paint, with
+//! the token formats of the Highlighter. Until the index is ready the view
+//! shows the top of the file without scrolling or editing.
+//! The completer of the text editor is shared: it follows the focus, and
+//! words, predictions and LaTeX markup are completed as in TextEdit.
+//! Find scans the pieces in place; matches are highlighted as the lines of
+//! the viewport are laid out and replace-all is a single piece table edit.
+class LargeFileView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const qint64 BlockSize = PieceTable::BlockSize;
+        static const int MaxLineLength = 4096;  // bytes shown of a line
+
+        LargeFileView(QWidget *parent = 0);
+        ~LargeFileView();
+
+        bool open(const QString &fileName);
+        void close();
+        QString fileName() const;
+        QString errorString() const;
+        bool isIndexed() const;
+        qint64 lineCount() const;
+        bool isModified() const;
+        bool save(const QString &fileName);
+
+        void setCompleter(QCompleter *completer);
+
+        int find(const QString &pattern, TextSearch::Options options);
+        bool findNext(bool backward);
+        bool replace(const QString &replacement);
+        int replaceAll(const QString &replacement);
+        void clearFind();
+        const TextSearch &textSearch() const;
+        void goToLine(qint64 line);
+
+    //set signals
+    signals:
+        void indexProgress(int percent);
+        void indexed();
+        void matchesChanged();
+
+    //set protected methods & variables
+    protected:
+        void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+        void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
+        void scrollContentsBy(int dx, int dy) Q_DECL_OVERRIDE;
+        void keyPressEvent(QKeyEvent *event) Q_DECL_OVERRIDE;
+        void mousePressEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+        void focusInEvent(QFocusEvent *event) Q_DECL_OVERRIDE;
+
+    //set private slots methods
+    private slots:
+        void indexProgressChanged(int blocks);
+        void indexFinished();
+        void insertCompletion(const QString &completion);
+        void matchesReady();
+        void runSearch();
+
+    //set private methods & variables
+    private:
+        qint64 lineStart(qint64 line) const;
+        qint64 lineEnd(qint64 start) const;
+        QString lineText(qint64 start, qint64 end) const;
+        QVector<QTextLayout::FormatRange> lineFormats(const QString &text, int *state);
+        void addMatchFormats(qint64 start, qint64 end, QVector<QTextLayout::FormatRange> *ranges) const;
+        int visibleLines() const;
+        void updateScrollBars();
+
+        bool editKey(QKeyEvent *event);
+        void insertText(const QByteArray &text);
+        void removeText(qint64 start, qint64 end);
+        void setCursorPosition(qint64 position);
+        void edited();
+        void selectMatch(int index);
+        qint64 previousCharacter(qint64 position) const;
+        qint64 nextCharacter(qint64 position) const;
+        qint64 lineMoved(qint64 lines) const;
+        QString textBeforeCursor() const;
+        QRect cursorRect() const;
+        void ensureCursorVisible();
+
+        void learnFinishedWord();
+        void updateCompletion(bool forced);
+        void showMatches();
+        CompletionModel *completionModel() const;
+
+        QFile file;
+        const uchar *data;
+        qint64 size;
+        QFutureWatcher<qint64> indexer;
+        PieceTable table;               // the text once the file is indexed
+        bool editable;
+        qint64 cursor;                  // byte position in the table
+        qint64 anchor;                  // start of the selected match, -1 if none
+        QScopedPointer<Highlighter> highlighter;
+        QVector<Highlighter::Token> tokens;
+        int widest;
+        QString error;
+        QCompleter *c;
+        bool completionForced;          // CTRL+E, shown whatever the prefix
+        bool awaitingMatches;           // a background query of the view is out
+        TextSearch search;
+        QTimer searchTimer;
+};
+//! [0]
+
+#endif // LARGEFILEVIEW_H
@@ -0,0 +1,132 @@
+/*
+ * LatencyHistogram Class
+ * Count durations in log-linear buckets and report percentiles
+*/
+#include "latencyhistogram.h"
+
+#include <QJsonArray>
+#include <cstring>
+
+//! [0]
+//! main function
+//! create an empty histogram
+LatencyHistogram::LatencyHistogram()
+{
+    clear();
+}
+//! [0]
+
+//! [1]
+//! function: record(param: duration in ns)
+//! count one duration
+void LatencyHistogram::record(qint64 nanoseconds)
+{
+    const qint64 microseconds = qMax(qint64(0), nanoseconds / 1000);
+    ++buckets[bucketOf(microseconds)];
+    ++total;
+    largest = qMax(largest, microseconds);
+}
+//! [1]
+
+//! [2]
+//! function: merge(param: histogram), add(param: bucket, count, maximum in us), clear()
+//! add the counts of another histogram, or drop all counts
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < BucketCount; ++i)
+        buckets[i] += other.buckets[i];
+    total += other.total;
+    largest = qMax(largest, other.largest);
+}
+
+//! counts kept elsewhere, e.g. in atomic counters, are added per bucket
+void LatencyHistogram::add(int bucket, quint64 count, qint64 maximum)
+{
+    buckets[bucket] += count;
+    total += count;
+    largest = qMax(largest, maximum);
+}
+
+void LatencyHistogram::clear()
+{
+    std::memset(buckets, 0, sizeof(buckets));
+    total = 0;
+    largest = 0;
+}
+//! [2]
+
+//! [3]
+//! function: count(), percentile(param: fraction 0..1), maximum()
+//! percentiles are the upper bound of their bucket in us, never above the maximum
+quint64 LatencyHistogram::count() const
+{
+    return total;
+}
+
+qint64 LatencyHistogram::percentile(double fraction) const
+{
+    if (total == 0)
+        return 0;
+    const quint64 rank = qMax(quint64(1), quint64(fraction * total + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return qMin(largest, bucketStart(i + 1) - 1);
+    }
+    return largest;
+}
+
+qint64 LatencyHistogram::maximum() const
+{
+    return largest;
+}
+//! [3]
+
+//! [4]
+//! function: toJson()
+//! summary and the non-empty buckets as [start us, count] pairs
+QJsonObject LatencyHistogram::toJson() const
+{
+    QJsonArray counts;
+    for (int i = 0; i < BucketCount; ++i) {
+        if (buckets[i] == 0)
+            continue;
+        QJsonArray bucket;
+        bucket.append(double(bucketStart(i)));
+        bucket.append(double(buckets[i]));
+        counts.append(bucket);
+    }
+    QJsonObject json;
+    json["count"] = double(total);
+    json["p50_us"] = double(percentile(0.50));
+    json["p90_us"] = double(percentile(0.90));
+    json["p99_us"] = double(percentile(0.99));
+    json["max_us"] = double(largest);
+    json["buckets"] = counts;
+    return json;
+}
+//! [4]
+
+//! [5]
+//! function: bucketOf(param: duration in us), bucketStart(param: bucket)
+//! 8 linear buckets for every power of two from 8 us on
+int LatencyHistogram::bucketOf(qint64 microseconds)
+{
+    if (microseconds < SubBuckets)
+        return int(microseconds);
+    int exponent = 63;
+    while (!(quint64(microseconds) >> exponent))
+        --exponent;
+    const int sub = int((microseconds >> (exponent - 3)) & (SubBuckets - 1));
+    return (exponent - 2) * SubBuckets + sub;
+}
+
+qint64 LatencyHistogram::bucketStart(int bucket)
+{
+    if (bucket < SubBuckets)
+        return bucket;
+    const int exponent = bucket / SubBuckets + 2;
+    return qint64(SubBuckets + bucket % SubBuckets) << (exponent - 3);
+}
+//! [5]
@@ -0,0 +1,49 @@
+/*
+ * Header LatencyHistogram class
+ * Log-linear histogram of durations
+*/
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+//import dependencies
+#include <QJsonObject>
+#include <QtGlobal>
+
+//! [0]
+//! Durations are counted in microsecond buckets: exact below 8 us, then
+//! 8 buckets per power of two, so a percentile is off by at most 12.5%
+//! while recording is a few instructions and no allocation. Histograms of
+//! the same kind merge by adding their buckets.
+class LatencyHistogram
+{
+    //set public methods & variables
+    public:
+        static const int SubBuckets = 8;
+        static const int BucketCount = 64 * SubBuckets;
+
+        LatencyHistogram();
+
+        void record(qint64 nanoseconds);
+        void merge(const LatencyHistogram &other);
+        void add(int bucket, quint64 count, qint64 maximum);
+        void clear();
+
+        quint64 count() const;
+        qint64 percentile(double fraction) const;
+        qint64 maximum() const;
+        QJsonObject toJson() const;
+
+        static int bucketOf(qint64 microseconds);
+
+    //set private methods & variables
+    private:
+        static qint64 bucketStart(int bucket);
+
+        quint64 buckets[BucketCount];
+        quint64 total;
+        qint64 largest;
+};
+//! [0]
+
+#endif // LATENCYHISTOGRAM_H
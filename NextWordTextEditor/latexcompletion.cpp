@@ -0,0 +1,215 @@
+/*
+ * LatexCompletion Class
+ * Find the completion context before the cursor and look up command names
+*/
+#include "latexcompletion.h"
+
+#include <QByteArray>
+#include <algorithm>
+
+namespace {
+
+//generated from resources/keywords.txt and the common LaTeX commands,
+//sorted case-insensitively and without duplicates for the binary search
+const char * const Commands[] = {
+    "Abstract", "abstract", "acceptabledates", "Acqu", "additionaltime", "AddNights",
+    "address", "AdminUSPI", "AdonisInfo", "affil", "afternextparallel", "afternextprimary",
+    "alpha", "aperture", "appendix", "author", "autoref", "AwardedNights", "backupprogram",
+    "BackUpProgramme", "begin", "BeginAbstract", "BeginConstraints",
+    "BeginDescribeObservations", "BeginJustifyConstraints", "BeginObjectTable",
+    "BeginPreviousTime", "BeginRequirementsBlurb", "BeginSciJustification", "BeginSummary",
+    "BeginUFOEexposureTable", "beta", "bibitem", "bibliography", "bibliographystyle", "cable",
+    "camera", "caption", "CCD", "cdots", "centering", "chapter", "cite", "citep", "citet",
+    "clearpage", "cline", "CoIemail", "CoIfirstname", "CoIinstitutions", "CoIlastname",
+    "CoINameOne", "CoInames", "CoINameTwo", "Collaborative", "Comm", "Configuration",
+    "configuration", "consumables", "CoudeOBS", "country", "cref", "Datareduction", "date",
+    "Dates", "datesjustification", "dec", "delta", "Desc", "describeobservations", "Detector",
+    "detector", "documentclass", "duplications", "E", "EarliestLST", "email", "emailaddress",
+    "emph", "end", "EndAbstract", "EndConstraints", "EndDescribeObservations", "EndEquipment",
+    "EndJustifyConstraints", "EndObjectTable", "EndPreviousTime", "EndRequirementsBlurb",
+    "EndSciJustification", "EndSummary", "EndUFOEexposureTable", "epoch", "epsilon", "eqref",
+    "ESAmember", "expdesign", "exptime", "fax", "filter", "Filters", "flags", "Focal",
+    "FocalInst", "focalstation", "Focus", "footnote", "footnotesize", "frac", "gamma",
+    "grating", "gratingsandfilters", "Grisms", "hline", "honorific", "href", "hspace",
+    "ImmediateObjective", "impossdates", "include", "includegraphics", "infty", "input",
+    "INSconfig", "institution", "Instrument", "instrument", "int", "Interf", "invstatus",
+    "item", "Justification", "justification", "label", "lambda", "Large", "large",
+    "LastObservation", "LastObservationRemark", "LastProgramme", "LatestLST", "ldots", "left",
+    "lim", "Link", "listoffigures", "listoftables", "Lunar", "lunardays", "magnitude",
+    "maketitle", "mathbf", "mathcal", "mathit", "mathrm", "MaxAgeMoon", "minuseful", "mode",
+    "ModeJustification", "moondays", "MovingTarget", "MovingTargets", "mu", "multicolumn",
+    "name", "Needs", "newcommand", "newenvironment", "newline", "newpage", "nexposures",
+    "nextcycleparallel", "nextcycleprimary", "nocite", "normalsize", "numnights", "object",
+    "objid", "obscomment", "Observer", "ObservingMode", "ObservingRun", "obstargets", "omega",
+    "optimaldates", "OptimumLST", "order", "Other", "OtherAgency", "otherapplications",
+    "OtherConstraints", "OtherObservations", "othertimeconstraints", "pageref", "paragraph",
+    "part", "phone", "pi", "PIE", "PIemail", "PIfirstname", "PIinstitution", "PIlastname",
+    "PIname", "PINameInst", "Pixelsize", "postalcode", "prefdates", "previous", "PrevRuns",
+    "prod", "Publications", "QE", "ra", "Readnoise", "RecAlloc", "ref", "References",
+    "relatedprograms", "renewcommand", "RequiredDays", "RequiredNights", "resolution", "right",
+    "RunSplitting", "sciencecase", "ScientificRationale", "ScJustI", "section", "Seeing",
+    "seeing", "SESTLST", "SESTperiod", "sigma", "signal", "SkyBrightness", "skycond",
+    "SkyTransparency", "small", "Softw", "Software", "SpecFilt", "SpecialCalibrations",
+    "SpecialRemarks", "specialreq", "SpecialRequirements", "spectralelements", "sqrt",
+    "Strategy", "street", "subparagraph", "subsection", "subsubsection", "suffix", "sum",
+    "Summary", "sundries", "Suppl", "supporteverynight", "supportfirstnight", "supportingobs",
+    "supportnone", "tableofcontents", "target", "targetinfo", "TargetNotes",
+    "TargetOpportunity", "telephone", "telescope", "TelescopeJustification", "textbf",
+    "textit", "textrm", "textsc", "textsf", "texttt", "thepast", "theta", "thiscycleparallel",
+    "thiscycleprimary", "TimeCritical", "timerequested", "tiny", "title", "TotalNights",
+    "TotalNightsRequested", "totalorbits", "totaltargets", "TotalTimeRequested", "town",
+    "TwoKformat", "UnacceptableDates", "underline", "UnsuitableTimes", "unusabledates", "url",
+    "usepackage", "USstate", "UVresp", "vspace", "wend", "Wfocus", "whyctio", "WhyLunarPhase",
+    "WhyNights", "wstart", "WV"
+};
+const int CommandCount = int(sizeof(Commands) / sizeof(Commands[0]));
+
+//commands whose braces hold labels, resp. citation keys
+const char * const LabelCommands[] = {
+    "Cref", "autoref", "cref", "eqref", "label", "nameref", "pageref", "ref", "vref"
+};
+const char * const CitationCommands[] = {
+    "autocite", "bibitem", "cite", "citealp", "citeauthor", "citep", "citet", "citeyear",
+    "nocite", "parencite", "textcite"
+};
+
+//a key argument is not searched further back than this
+const int MaxArgumentLength = 256;
+
+bool foldedLess(const char *a, const char *b)
+{
+    return qstricmp(a, b) < 0;
+}
+
+inline bool isCommandLetter(QChar c)
+{
+    return (c >= QLatin1Char('a') && c <= QLatin1Char('z'))
+            || (c >= QLatin1Char('A') && c <= QLatin1Char('Z'));
+}
+
+//the backslash at position starts a command unless it is escaped by another one
+bool startsCommand(const QString &text, int position)
+{
+    int backslashes = 0;
+    while (position >= 0 && text.at(position) == QLatin1Char('\\')) {
+        ++backslashes;
+        --position;
+    }
+    return backslashes % 2 == 1;
+}
+
+template <int N>
+bool isOneOf(const QString &name, const char * const (&names)[N])
+{
+    for (int i = 0; i < N; ++i) {
+        if (name == QLatin1String(names[i]))
+            return true;
+    }
+    return false;
+}
+
+//name of the command taking the argument opened at brace, empty if none;
+//an optional [..] argument and a * between them are skipped
+QString commandBefore(const QString &text, int brace)
+{
+    int end = brace;
+    if (end > 0 && text.at(end - 1) == QLatin1Char(']')) {
+        const int open = text.lastIndexOf(QLatin1Char('['), end - 1);
+        if (open < 0)
+            return QString();
+        end = open;
+    }
+    if (end > 0 && text.at(end - 1) == QLatin1Char('*'))
+        --end;
+    int start = end;
+    while (start > 0 && isCommandLetter(text.at(start - 1)))
+        --start;
+    if (start == end || start == 0 || !startsCommand(text, start - 1))
+        return QString();
+    return text.mid(start, end - start);
+}
+
+} // namespace
+
+//! [0]
+//! function: context(param: text of the line before the cursor, returned prefix)
+//! find what is being completed and the part of it already typed
+LatexCompletion::Context LatexCompletion::context(const QString &textBeforeCursor, QString *prefix)
+{
+    const int length = textBeforeCursor.size();
+
+    //a command name, possibly still empty right after the backslash
+    int start = length;
+    while (start > 0 && isCommandLetter(textBeforeCursor.at(start - 1)))
+        --start;
+    if (start > 0 && startsCommand(textBeforeCursor, start - 1)) {
+        *prefix = textBeforeCursor.mid(start);
+        return Command;
+    }
+
+    //a key in the unclosed braces of a referencing command, after the last comma
+    int keyStart = length;
+    int brace = length - 1;
+    while (brace >= 0 && length - brace <= MaxArgumentLength) {
+        const QChar c = textBeforeCursor.at(brace);
+        if (c == QLatin1Char('{') || c == QLatin1Char('}'))
+            break;
+        if (c == QLatin1Char(',') && keyStart == length)
+            keyStart = brace + 1;
+        --brace;
+    }
+    if (brace < 0 || textBeforeCursor.at(brace) != QLatin1Char('{'))
+        return Text;
+    if (keyStart == length)
+        keyStart = brace + 1;
+    while (keyStart < length && textBeforeCursor.at(keyStart).isSpace())
+        ++keyStart;
+
+    const Context found = argumentContext(commandBefore(textBeforeCursor, brace));
+    if (found != Text)
+        *prefix = textBeforeCursor.mid(keyStart);
+    return found;
+}
+//! [0]
+
+//! [1]
+//! function: commandCount(), command(param: command id)
+//! size of the command table, name of a command without the backslash
+int LatexCompletion::commandCount()
+{
+    return CommandCount;
+}
+
+QString LatexCompletion::command(int id)
+{
+    return QLatin1String(Commands[id]);
+}
+//! [1]
+
+//! [2]
+//! function: commands(param: typed part of the name, max number of results)
+//! ids of the commands starting with prefix, ignoring case, in table order
+QVector<int> LatexCompletion::commands(const QString &prefix, int limit)
+{
+    const QByteArray key = prefix.toLatin1();
+    const char * const *end = Commands + CommandCount;
+    QVector<int> ids;
+    for (const char * const *it = std::lower_bound(Commands, end, key.constData(), foldedLess);
+         it != end && ids.size() < limit && qstrnicmp(*it, key.constData(), key.size()) == 0; ++it)
+        ids.append(int(it - Commands));
+    return ids;
+}
+//! [2]
+
+//! [3]
+//! function: argumentContext(param: command name without the backslash)
+//! what the braces of the command hold, Text for anything but keys
+LatexCompletion::Context LatexCompletion::argumentContext(const QString &command)
+{
+    if (isOneOf(command, LabelCommands))
+        return Label;
+    if (isOneOf(command, CitationCommands))
+        return Citation;
+    return Text;
+}
+//! [3]
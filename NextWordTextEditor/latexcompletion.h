@@ -0,0 +1,37 @@
+/*
+ * Header LatexCompletion class
+ * Completion context and command table for LaTeX markup
+*/
+
+#ifndef LATEXCOMPLETION_H
+#define LATEXCOMPLETION_H
+
+//import dependencies
+#include <QString>
+#include <QVector>
+
+//! [0]
+//! The text before the cursor decides what is completed: after a backslash
+//! the command names, inside the braces of \label, \ref and friends the
+//! labels of the document, inside those of \bibitem, \cite and friends its
+//! citation keys, anywhere else ordinary words. Each context has its own
+//! small index, the word list is never filtered for markup.
+//! Command names live in a sorted table compiled into the binary (taken
+//! from resources/keywords.txt plus the common LaTeX commands) and are
+//! looked up by binary search on the case-folded prefix.
+class LatexCompletion
+{
+    //set public methods & variables
+    public:
+        enum Context { Text, Command, Label, Citation };
+
+        static Context context(const QString &textBeforeCursor, QString *prefix);
+        static Context argumentContext(const QString &command);
+
+        static int commandCount();
+        static QString command(int id);
+        static QVector<int> commands(const QString &prefix, int limit);
+};
+//! [0]
+
+#endif // LATEXCOMPLETION_H
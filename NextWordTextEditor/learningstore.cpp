@@ -0,0 +1,373 @@
+/*
+ * LearningStore Class
+ * Learn accepted completions and typed bigrams, persisted in an append-only log
+*/
+#include "learningstore.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+//pending records are written at most this often (ms)
+const int FlushInterval = 2000;
+//the log is compacted once it holds this many records more than twice the entries
+const int CompactionSlack = 1024;
+
+bool learnedMoreThan(const LearningStore::Learned &a, const LearningStore::Learned &b)
+{
+    return a.count > b.count;
+}
+
+//words are tab separated fields of one line, reject anything else
+bool isRecordable(const QString &word)
+{
+    return !word.isEmpty() && !word.contains(QLatin1Char('\t')) && !word.contains(QLatin1Char('\n'))
+            && !word.contains(QLatin1Char('\r'));
+}
+
+//17 significant digits read back as the same double, arg(double) keeps 6
+QString weightText(double weight)
+{
+    return QString::number(weight, 'g', 17);
+}
+
+void addCount(QMap<QString, LearningStore::Learned> *map, const QString &word, double weight)
+{
+    LearningStore::Learned &learned = (*map)[word.toCaseFolded()];
+    if (learned.word.isEmpty())
+        learned.word = word;
+    learned.count += weight;
+}
+
+} // namespace
+
+//! [0]
+//! main function
+//! set up the batching timer and the single writer thread
+LearningStore::LearningStore(const QString &fileName, QObject *parent)
+    : QObject(parent), logFileName(fileName), pendingRecords(0), recordsOnDisk(0), isReady(false)
+{
+    //one writer keeps appends and compactions in order
+    writer.setMaxThreadCount(1);
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(FlushInterval);
+    connect(&flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+    connect(&reader, SIGNAL(finished()), this, SLOT(logRead()));
+}
+
+LearningStore::~LearningStore()
+{
+    reader.waitForFinished();
+    flush();
+    writer.waitForDone();
+}
+//! [0]
+
+//! [1]
+//! function: defaultFileName()
+//! per-user log location, empty if there is none (nothing is persisted)
+QString LearningStore::defaultFileName()
+{
+    const QString location = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (location.isEmpty())
+        return QString();
+    return location + QLatin1String("/learned.log");
+}
+//! [1]
+
+//! [2]
+//! function: load()
+//! read the log on a worker thread, loaded() is emitted when merged
+void LearningStore::load()
+{
+    reader.setFuture(QtConcurrent::run(&LearningStore::readLog, logFileName));
+}
+
+bool LearningStore::isLoaded() const
+{
+    return isReady;
+}
+//! [2]
+
+//! [3]
+//! function: logRead()
+//! merge what was learned while the log was read into the log contents
+void LearningStore::logRead()
+{
+    Counts disk = reader.result();
+    mergeInto(&disk, learned);
+    recordsOnDisk = disk.records;
+    learned = disk;
+    isReady = true;
+    emit loaded();
+}
+//! [3]
+
+//! [4]
+//! function: recordWord(param: word, weight)
+//! learn a word, the record is written with the next batch
+void LearningStore::recordWord(const QString &word, double weight)
+{
+    const QString trimmed = word.trimmed();
+    if (!isRecordable(trimmed))
+        return;
+    addCount(&learned.words, trimmed, weight);
+    append(QString("W\t%1\t%2").arg(weightText(weight), trimmed));
+}
+//! [4]
+
+//! [5]
+//! function: recordBigram(param: previous word, word, weight)
+//! learn that word followed previousWord
+void LearningStore::recordBigram(const QString &previousWord, const QString &word, double weight)
+{
+    const QString head = previousWord.trimmed();
+    const QString tail = word.trimmed();
+    if (!isRecordable(head) || !isRecordable(tail))
+        return;
+    addCount(&learned.bigrams[head.toCaseFolded()], tail, weight);
+    append(QString("B\t%1\t%2\t%3").arg(weightText(weight), head, tail));
+}
+//! [5]
+
+//! [6]
+//! function: completeWords(param: prefix, max results)
+//! learned words starting with prefix, most used first
+QVector<LearningStore::Learned> LearningStore::completeWords(const QString &prefix, int limit) const
+{
+    return completeWords(learned, prefix, limit);
+}
+
+QVector<LearningStore::Learned> LearningStore::completeWords(const Counts &counts, const QString &prefix, int limit)
+{
+    QVector<Learned> result;
+    const QString folded = prefix.toCaseFolded();
+    for (QMap<QString, Learned>::const_iterator it = counts.words.lowerBound(folded);
+         it != counts.words.constEnd() && it.key().startsWith(folded); ++it)
+        result.append(it.value());
+    std::sort(result.begin(), result.end(), learnedMoreThan);
+    if (result.size() > limit)
+        result.resize(limit);
+    return result;
+}
+//! [6]
+
+//! [7]
+//! function: predict(param: previous word, prefix, max results)
+//! learned successors of previousWord starting with prefix, most used first
+QVector<LearningStore::Learned> LearningStore::predict(const QString &previousWord, const QString &prefix, int limit) const
+{
+    return predict(learned, previousWord, prefix, limit);
+}
+
+QVector<LearningStore::Learned> LearningStore::predict(const Counts &counts, const QString &previousWord,
+                                                      const QString &prefix, int limit)
+{
+    QVector<Learned> result;
+    QHash<QString, QMap<QString, Learned> >::const_iterator head
+        = counts.bigrams.constFind(previousWord.toCaseFolded());
+    if (head == counts.bigrams.constEnd())
+        return result;
+    const QString folded = prefix.toCaseFolded();
+    for (QMap<QString, Learned>::const_iterator it = head.value().lowerBound(folded);
+         it != head.value().constEnd() && it.key().startsWith(folded); ++it)
+        result.append(it.value());
+    std::sort(result.begin(), result.end(), learnedMoreThan);
+    if (result.size() > limit)
+        result.resize(limit);
+    return result;
+}
+
+const LearningStore::Counts &LearningStore::counts() const
+{
+    return learned;
+}
+//! [7]
+
+//! [8]
+//! function: flush()
+//! hand the pending batch to the writer thread, compacting the log when
+//! it holds far more records than distinct entries
+void LearningStore::flush()
+{
+    flushTimer.stop();
+    //appending while the log is read back would count the batch twice
+    if (reader.isRunning()) {
+        flushTimer.start();
+        return;
+    }
+    if (logFileName.isEmpty() || pendingRecords == 0) {
+        pending.clear();
+        pendingRecords = 0;
+        return;
+    }
+
+    int entries = learned.words.size();
+    foreach (const QMap<QString, Learned> &tails, learned.bigrams)
+        entries += tails.size();
+
+    //the number of records on disk is only known once the log was read
+    if (isReady && recordsOnDisk + pendingRecords > 2 * entries + CompactionSlack) {
+        recordsOnDisk = entries;
+        QtConcurrent::run(&writer, &LearningStore::compactLog, logFileName, pending);
+    } else {
+        recordsOnDisk += pendingRecords;
+        QtConcurrent::run(&writer, &LearningStore::appendRecords, logFileName, pending);
+    }
+    pending.clear();
+    pendingRecords = 0;
+}
+//! [8]
+
+//! [9]
+//! function: append(param: record payload)
+//! queue a record and schedule the next batch
+void LearningStore::append(const QString &record)
+{
+    pending += encode(record);
+    ++pendingRecords;
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+//! [9]
+
+//! [10]
+//! function: mergeInto(param: target counts, source counts)
+//! add the counts of source to target
+void LearningStore::mergeInto(Counts *target, const Counts &source) const
+{
+    for (QMap<QString, Learned>::const_iterator it = source.words.constBegin();
+         it != source.words.constEnd(); ++it)
+        addCount(&target->words, it.value().word, it.value().count);
+    for (QHash<QString, QMap<QString, Learned> >::const_iterator head = source.bigrams.constBegin();
+         head != source.bigrams.constEnd(); ++head) {
+        QMap<QString, Learned> &tails = target->bigrams[head.key()];
+        for (QMap<QString, Learned>::const_iterator it = head.value().constBegin();
+             it != head.value().constEnd(); ++it)
+            addCount(&tails, it.value().word, it.value().count);
+    }
+}
+//! [10]
+
+//! [11]
+//! function: snapshot(param: counts)
+//! one weighted record per learned entry, the compacted log
+//! runs on the writer thread
+QByteArray LearningStore::snapshot(const Counts &counts)
+{
+    QByteArray records;
+    foreach (const Learned &word, counts.words)
+        records += encode(QString("W\t%1\t%2").arg(weightText(word.count), word.word));
+    for (QHash<QString, QMap<QString, Learned> >::const_iterator head = counts.bigrams.constBegin();
+         head != counts.bigrams.constEnd(); ++head) {
+        foreach (const Learned &tail, head.value())
+            records += encode(QString("B\t%1\t%2\t%3").arg(weightText(tail.count), head.key(), tail.word));
+    }
+    return records;
+}
+//! [11]
+
+//! [12]
+//! function: readLog(param: string of file path), parseLog(param: log contents)
+//! parse the log, skipping records whose checksum does not match
+//! runs on a worker thread
+LearningStore::Counts LearningStore::readLog(const QString &fileName)
+{
+    QFile file(fileName);
+    if (fileName.isEmpty() || !file.open(QFile::ReadOnly))
+        return Counts();
+    return parseLog(file.readAll());
+}
+
+LearningStore::Counts LearningStore::parseLog(const QByteArray &data)
+{
+    Counts counts;
+    foreach (const QByteArray &line, data.split('\n')) {
+        const int tab = line.lastIndexOf('\t');
+        if (tab <= 0)
+            continue;
+        const QByteArray payload = line.left(tab);
+        bool ok;
+        const quint16 checksum = line.mid(tab + 1).toUShort(&ok, 16);
+        if (!ok || checksum != qChecksum(payload.constData(), payload.size()))
+            continue;
+
+        const QStringList fields = QString::fromUtf8(payload).split(QLatin1Char('\t'));
+        const double weight = fields.value(1).toDouble(&ok);
+        if (!ok)
+            continue;
+        if (fields.size() == 3 && fields.at(0) == QLatin1String("W"))
+            addCount(&counts.words, fields.at(2), weight);
+        else if (fields.size() == 4 && fields.at(0) == QLatin1String("B"))
+            addCount(&counts.bigrams[fields.at(2).toCaseFolded()], fields.at(3), weight);
+        else
+            continue;
+        ++counts.records;
+    }
+    return counts;
+}
+//! [12]
+
+//! [13]
+//! function: encode(param: record payload)
+//! one log line: payload, tab, CRC-16 of the payload
+QByteArray LearningStore::encode(const QString &payload)
+{
+    const QByteArray bytes = payload.toUtf8();
+    return bytes + '\t' + QByteArray::number(qChecksum(bytes.constData(), bytes.size()), 16) + '\n';
+}
+//! [13]
+
+//! [14]
+//! function: appendRecords(param: log path, records), compactLog(param: log path, records)
+//! write a batch to the end of the log, or replace the log and the batch
+//! atomically by one record per entry; both hold the lock of the log, which
+//! other editors and the completion server may write too, and compacting
+//! reads the log under it, so their records are kept
+//! a line torn by a crash is closed first, so the batch is not glued onto it
+//! run on the writer thread
+bool LearningStore::appendRecords(const QString &fileName, const QByteArray &records)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QLockFile lock(fileName + QLatin1String(".lock"));
+    if (!lock.lock())
+        return false;
+    QFile file(fileName);
+    if (!file.open(QFile::ReadWrite | QFile::Append))
+        return false;
+    QByteArray batch = records;
+    char last;
+    if (file.size() > 0 && file.seek(file.size() - 1) && file.getChar(&last) && last != '\n')
+        batch.prepend('\n');
+    return file.write(batch) == batch.size();
+}
+
+bool LearningStore::compactLog(const QString &fileName, const QByteArray &records)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QLockFile lock(fileName + QLatin1String(".lock"));
+    if (!lock.lock())
+        return false;
+    QByteArray log;
+    QFile current(fileName);
+    if (current.open(QFile::ReadOnly))
+        log = current.readAll();
+    current.close();
+    if (!log.isEmpty() && !log.endsWith('\n'))
+        log += '\n';
+    log += records;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(snapshot(parseLog(log)));
+    return file.commit();
+}
+//! [14]
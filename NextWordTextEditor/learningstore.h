@@ -0,0 +1,107 @@
+/*
+ * Header LearningStore class
+ * Persistent per-user record of accepted completions and typed bigrams
+*/
+
+#ifndef LEARNINGSTORE_H
+#define LEARNINGSTORE_H
+
+//import dependencies
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+//! [0]
+//! Learned words and bigrams are kept in memory for lookup and persisted to
+//! an append-only log, one checksummed text record per line. Records are
+//! batched and appended by a single writer thread, a torn or corrupt line is
+//! skipped when the log is read back. When the log grows well beyond the
+//! number of distinct entries it is compacted into one weighted record per
+//! entry, written with QSaveFile so a crash keeps either the old or the new log.
+//! Editors without a completion server and the server itself write the same
+//! log, so appends and compactions hold a QLockFile next to it, and the
+//! writer thread compacts what is on disk plus the batch rather than the
+//! counts in memory: records of other processes are kept, and the GUI
+//! thread serialises nothing.
+class LearningStore : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        struct Learned
+        {
+            QString word;
+            double count;
+        };
+
+        struct Counts
+        {
+            Counts() : records(0) {}
+
+            QMap<QString, Learned> words;                   // folded word
+            QHash<QString, QMap<QString, Learned> > bigrams; // folded head, folded tail
+            int records;
+        };
+
+        LearningStore(const QString &fileName = defaultFileName(), QObject *parent = 0);
+        ~LearningStore();
+
+        static QString defaultFileName();
+
+        void load();
+        bool isLoaded() const;
+
+        void recordWord(const QString &word, double weight = 1.0);
+        void recordBigram(const QString &previousWord, const QString &word, double weight = 1.0);
+
+        QVector<Learned> completeWords(const QString &prefix, int limit) const;
+        QVector<Learned> predict(const QString &previousWord, const QString &prefix, int limit) const;
+        const Counts &counts() const;
+
+        //the same lookups on a copy of the counts, from any thread
+        static QVector<Learned> completeWords(const Counts &counts, const QString &prefix, int limit);
+        static QVector<Learned> predict(const Counts &counts, const QString &previousWord,
+                                        const QString &prefix, int limit);
+
+    //set public slots methods
+    public slots:
+        void flush();
+
+    //set signals
+    signals:
+        void loaded();
+
+    //set private slots methods
+    private slots:
+        void logRead();
+
+    //set private methods & variables
+    private:
+        void append(const QString &record);
+        void mergeInto(Counts *target, const Counts &source) const;
+
+        static Counts readLog(const QString &fileName);
+        static Counts parseLog(const QByteArray &data);
+        static QByteArray encode(const QString &payload);
+        static QByteArray snapshot(const Counts &counts);
+        static bool appendRecords(const QString &fileName, const QByteArray &records);
+        static bool compactLog(const QString &fileName, const QByteArray &records);
+
+        QString logFileName;
+        Counts learned;
+        QByteArray pending;
+        int pendingRecords;
+        int recordsOnDisk;
+        bool isReady;
+        QTimer flushTimer;
+        QThreadPool writer;
+        QFutureWatcher<Counts> reader;
+};
+//! [0]
+
+#endif // LEARNINGSTORE_H
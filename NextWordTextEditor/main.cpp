@@ -2,9 +2,184 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
+#include <QCompleter>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QtConcurrent>
 
 //include header for class mainwindow
 #include "mainwindow.h"
+#include "dictionary.h"
+#include "textedit.h"
+#include "completionmodel.h"
+#include "completionquery.h"
+#include "completionserver.h"
+#include "dictionarymanager.h"
+#include "keystrokereplay.h"
+
+//function createApplication
+//offline tools run without widgets, e.g. on build hosts without a display
+//a replay draws the editor on the offscreen platform unless one is chosen
+static QCoreApplication *createApplication(int &argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (!qstrncmp(argv[i], "--compile-dictionary", 20) || !qstrcmp(argv[i], "--complete")
+                || !qstrcmp(argv[i], "--serve"))
+            return new QCoreApplication(argc, argv);
+        if (!qstrncmp(argv[i], "--replay", 8) && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    return new QApplication(argc, argv);
+}
+
+//function replayTrace
+//type a recorded trace into an editor completing from the built-in list,
+//write the latency report and fail when the p99 latency exceeds the budget
+//nothing is learned persistently, the user's learned words stay untouched
+static int replayTrace(const QString &trace, double budgetMs, const QString &reportName)
+{
+    TextEdit editor;
+    QCompleter completer;
+    CompletionModel *model = new CompletionModel(&completer);
+    model->setDictionary(Dictionary::fromFiles(QStringList() << ":/resources/wordlist.txt"));
+    completer.setModel(model);
+    completer.setCaseSensitivity(Qt::CaseInsensitive);
+    completer.setWrapAround(false);
+    editor.setCompleter(&completer);
+    editor.resize(700, 555);
+    editor.show();
+    QCoreApplication::processEvents();
+
+    KeystrokeReplay replay(&editor, &completer);
+    if (!replay.loadTrace(trace)) {
+        QTextStream(stderr) << "cannot read trace " << trace << ": " << replay.errorString() << endl;
+        return 1;
+    }
+    replay.run();
+
+    const bool passed = budgetMs <= 0 || replay.allLatency().percentile(0.99) <= budgetMs * 1000;
+    QJsonObject report = replay.report();
+    report["budget_ms"] = budgetMs;
+    report["passed"] = passed;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    QFile out;
+    if (reportName.isEmpty())
+        out.open(stdout, QFile::WriteOnly);
+    else
+        out.setFileName(reportName);
+    if ((!out.isOpen() && !out.open(QFile::WriteOnly)) || out.write(json) != json.size()) {
+        QTextStream(stderr) << "cannot write " << reportName << ": " << out.errorString() << endl;
+        return 1;
+    }
+    return passed ? 0 : 2;
+}
+
+//lines of stdin answered together, large enough to keep every thread busy
+static const int CompleteBatchLines = 16384;
+
+//functor CompleteLine
+//answer one line of --complete: the last word is the prefix and the word
+//before it the context; after a trailing space the prefix is empty and
+//only the successors of the last word are predicted
+struct CompleteLine
+{
+    typedef QByteArray result_type;
+
+    CompleteLine(const CompletionSnapshot &snapshot, int limit, bool fuzzy)
+        : snapshot(snapshot), limit(limit), fuzzy(fuzzy) {}
+
+    QByteArray operator()(const QByteArray &line) const
+    {
+        const QString text = QString::fromUtf8(line);
+        const bool predictOnly = !text.isEmpty() && text.at(text.size() - 1).isSpace();
+        const QStringList words = text.simplified().split(QLatin1Char(' '), QString::SkipEmptyParts);
+        CompletionQuery query;
+        query.fuzzy = fuzzy;
+        if (predictOnly) {
+            if (!words.isEmpty())
+                query.contextWord = words.last();
+        } else if (!words.isEmpty()) {
+            query.prefix = words.last();
+            if (words.size() > 1)
+                query.contextWord = words.at(words.size() - 2);
+        }
+        QByteArray completions;
+        if (query.prefix.isEmpty() && query.contextWord.isEmpty())
+            return completions;
+        const CompletionMatches matches = query.run(snapshot);
+        for (int i = 0; i < matches.rows.size() && i < limit; ++i) {
+            if (i > 0)
+                completions += '\t';
+            completions += matches.text(matches.rows.at(i)).toUtf8();
+        }
+        return completions;
+    }
+
+    const CompletionSnapshot &snapshot;
+    int limit;
+    bool fuzzy;
+};
+
+//function completeLines
+//answer the lines of stdin with the completions of the given layers, one
+//line of tab-separated completions per line read, in the order read;
+//batches are answered on every thread, nothing learned is used so the
+//same input always gives the same output
+static int completeLines(const QStringList &layers, int limit, bool fuzzy)
+{
+    DictionaryManager *dictionaries = DictionaryManager::instance();
+    QStringList fileNames;
+    foreach (const QString &name, layers) {
+        if (!dictionaries->listNames().contains(name)) {
+            QTextStream(stderr) << "unknown word list " << name << endl;
+            return 1;
+        }
+        fileNames << dictionaries->listFiles(name);
+    }
+    CompletionSnapshot snapshot;
+    snapshot.words = Dictionary::fromFiles(fileNames);
+
+    QFile in;
+    QFile out;
+    if (!in.open(stdin, QFile::ReadOnly) || !out.open(stdout, QFile::WriteOnly)) {
+        QTextStream(stderr) << "cannot open standard input and output" << endl;
+        return 1;
+    }
+    const CompleteLine completeLine(snapshot, qBound(1, limit, int(CompletionQuery::MaxMatches)), fuzzy);
+    QVector<QByteArray> lines;
+    lines.reserve(CompleteBatchLines);
+    bool done = false;
+    while (!done) {
+        //stdin may be a pipe, read until a line comes back empty
+        while (lines.size() < CompleteBatchLines) {
+            QByteArray line = in.readLine();
+            if (line.isEmpty()) {
+                done = true;
+                break;
+            }
+            while (line.endsWith('\n') || line.endsWith('\r'))
+                line.chop(1);
+            lines.append(line);
+        }
+        if (lines.isEmpty())
+            break;
+        const QVector<QByteArray> answers = QtConcurrent::blockingMapped(lines, completeLine);
+        QByteArray block;
+        foreach (const QByteArray &answer, answers) {
+            block += answer;
+            block += '\n';
+        }
+        if (out.write(block) != block.size()) {
+            QTextStream(stderr) << "cannot write completions: " << out.errorString() << endl;
+            return 1;
+        }
+        out.flush();
+        lines.clear();
+    }
+    return 0;
+}
 
 //main function
 //set application, call main window
@@ -12,8 +187,7 @@ int main(int argc, char *argv[])
 {
     Q_INIT_RESOURCE(NextWordTextEditor);
 
-    QApplication app(argc, argv);
-    MainWindow window;
+    QScopedPointer<QCoreApplication> app(createApplication(argc, argv));
 
     QCoreApplication::setOrganizationName("QtProject");
     QCoreApplication::setApplicationName("Next Word Text Editor");
@@ -23,11 +197,74 @@ int main(int argc, char *argv[])
     parser.addHelpOption();
     parser.addVersionOption();
     parser.addPositionalArgument("file", "The file to open.");
-    parser.process(app);
+    QCommandLineOption compileOption("compile-dictionary",
+                                     "Compile the word lists given as files (default: the built-in list) "
+                                     "into the binary dictionary <image> and exit.",
+                                     "image");
+    parser.addOption(compileOption);
+    QCommandLineOption replayOption("replay",
+                                    "Type the keystrokes of <trace> into the editor offscreen and "
+                                    "report the latency until painted as JSON.",
+                                    "trace");
+    QCommandLineOption budgetOption("budget",
+                                    "With --replay, exit with status 2 when the p99 latency exceeds <ms>.",
+                                    "ms", "0");
+    QCommandLineOption reportOption("report",
+                                    "With --replay, write the report to <file> instead of stdout.",
+                                    "file");
+    parser.addOption(replayOption);
+    parser.addOption(budgetOption);
+    parser.addOption(reportOption);
+    QCommandLineOption completeOption("complete",
+                                      "Read a prefix, or a previous word and a prefix, per line of stdin "
+                                      "and write its completions tab-separated to stdout, without a window.");
+    QCommandLineOption layersOption("layers",
+                                    "With --complete, complete from the word lists <names>, comma-separated, "
+                                    "highest priority first.",
+                                    "names", DictionaryManager::instance()->defaultList());
+    QCommandLineOption limitOption("limit",
+                                   "With --complete, write at most <n> completions per line.",
+                                   "n", "10");
+    QCommandLineOption fuzzyOption("fuzzy",
+                                   "With --complete, also complete prefixes with typos.");
+    parser.addOption(completeOption);
+    parser.addOption(layersOption);
+    parser.addOption(limitOption);
+    parser.addOption(fuzzyOption);
+    QCommandLineOption serveOption("serve",
+                                   "Answer the completion queries of the editors started by this user, "
+                                   "which then load no dictionary of their own.");
+    parser.addOption(serveOption);
+    parser.process(*app);
+
+    if (parser.isSet(compileOption)) {
+        QStringList lists = parser.positionalArguments();
+        if (lists.isEmpty())
+            lists << ":/resources/wordlist.txt";
+        return Dictionary::compileFiles(lists, parser.value(compileOption)) ? 0 : 1;
+    }
+
+    if (parser.isSet(replayOption))
+        return replayTrace(parser.value(replayOption), parser.value(budgetOption).toDouble(),
+                           parser.value(reportOption));
 
+    if (parser.isSet(completeOption))
+        return completeLines(parser.value(layersOption).split(QLatin1Char(','), QString::SkipEmptyParts),
+                             parser.value(limitOption).toInt(), parser.isSet(fuzzyOption));
+
+    if (parser.isSet(serveOption)) {
+        CompletionServer server;
+        if (!server.listen()) {
+            QTextStream(stderr) << "cannot serve completions: " << server.errorString() << endl;
+            return 1;
+        }
+        return app->exec();
+    }
+
+    MainWindow window;
     if (!parser.positionalArguments().isEmpty())
         window.loadFile(parser.positionalArguments().first());
 
     window.show();
-    return app.exec();
+    return app->exec();
 }
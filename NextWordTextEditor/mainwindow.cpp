@@ -13,29 +13,126 @@
 #include <QtWidgets>
 #include "mainwindow.h"
 #include "textedit.h"
+#include "completionmodel.h"
+#include "completionclient.h"
+#include "dictionarymanager.h"
+#include "learningstore.h"
+#include "documentfile.h"
+#include "largefileview.h"
+#include "findbar.h"
+#include "perfoverlay.h"
+#include "perfprobe.h"
+#include "projectindex.h"
+#include "projectpanel.h"
+
+namespace {
+
+//files from this size on may be opened in the large file editor
+const qint64 LargeFileSize = 64 * 1024 * 1024;
+
+} // namespace
 
 //! [0]
 //! main function: setting up main window
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), completer(0)
+    : QMainWindow(parent), completer(0), saveAct(0), saveAsAct(0), domainMenu(0), generalMenu(0), domainGroup(0),
+      generalGroup(0), generalList(DictionaryManager::instance()->defaultList()), learning(0), documentFile(0),
+      loadProgress(0), cancelLoadButton(0), largeFileView(0), centralStack(0),
+      findBar(0), perfOverlay(0), projectIndex(0), projectPanel(0), projectDock(0), completionClient(0),
+      pendingLine(-1)
 {
+    //probe summary, shown from the Performance menu
+    perfOverlay = new PerfOverlay;
+    perfOverlay->hide();
+    statusBar()->addPermanentWidget(perfOverlay);
+
     //call function to create menu
     createMenu();
 
     //setting up text editor window
     completingTextEdit = new TextEdit;
 
+    //files are read in chunks, progress and cancel live in the status bar
+    documentFile = new DocumentFile(completingTextEdit->document(), this);
+    loadProgress = new QProgressBar;
+    loadProgress->setRange(0, 100);
+    loadProgress->setMaximumWidth(160);
+    loadProgress->hide();
+    cancelLoadButton = new QPushButton(tr("Cancel"));
+    cancelLoadButton->hide();
+    statusBar()->addPermanentWidget(loadProgress);
+    statusBar()->addPermanentWidget(cancelLoadButton);
+    connect(documentFile, SIGNAL(progress(int)), loadProgress, SLOT(setValue(int)));
+    connect(documentFile, SIGNAL(loaded(bool)), this, SLOT(fileLoaded(bool)));
+    connect(cancelLoadButton, SIGNAL(clicked()), documentFile, SLOT(cancel()));
+
+    //a completion server of the user ranks with its own dictionaries and
+    //learned words, they are only loaded here without one
+    completionClient = new CompletionClient(this);
+    completionClient->attach();
+    connect(completionClient, SIGNAL(detached()), this, SLOT(completionServerLost()));
+
+    //words learned in earlier sessions, read in the background
+    learning = new LearningStore(LearningStore::defaultFileName(), this);
+    if (!completionClient->isAttached())
+        learning->load();
+
+    //words and trigrams of the folder opened from the File menu
+    projectIndex = new ProjectIndex(this);
+
     //setting up QCompleter class
     completer = new QCompleter(this);
-    //set completer model from modelFromFile function
-    completer->setModel(modelFromFile(":/resources/wordlist.txt"));
+    //set completer model, filled once the selected dictionaries are loaded
+    completer->setModel(completionModel());
     completer->setCaseSensitivity(Qt::CaseInsensitive);
     completer->setWrapAround(false);
     //set completer to text editor
     completingTextEdit->setCompleter(completer);
 
-    //place text editor in the main window widget
-    setCentralWidget(completingTextEdit);
+    //dictionaries are shared with the other windows through the manager
+    DictionaryManager *dictionaries = DictionaryManager::instance();
+    connect(dictionaries, SIGNAL(loaded(QStringList)), this, SLOT(dictionaryLoaded(QStringList)));
+    connect(dictionaries, SIGNAL(listsChanged()), this, SLOT(updateDictionaryMenus()));
+    connect(dictionaries, SIGNAL(listChanged(QString)), this, SLOT(wordListChanged(QString)));
+    updateDictionaryMenus();
+    useDictionaries();
+
+    //place text editor and the large file editor in the main window widget
+    largeFileView = new LargeFileView;
+    largeFileView->setCompleter(completer);
+    connect(largeFileView, SIGNAL(indexProgress(int)), loadProgress, SLOT(setValue(int)));
+    connect(largeFileView, SIGNAL(indexed()), this, SLOT(viewIndexed()));
+    centralStack = new QStackedWidget;
+    centralStack->addWidget(completingTextEdit);
+    centralStack->addWidget(largeFileView);
+
+    //the find bar below the editors, searching the one shown
+    findBar = new FindBar;
+    findBar->hide();
+    connect(findBar, SIGNAL(queryChanged()), this, SLOT(findChanged()));
+    connect(findBar, SIGNAL(findNext()), this, SLOT(findNext()));
+    connect(findBar, SIGNAL(findPrevious()), this, SLOT(findPrevious()));
+    connect(findBar, SIGNAL(replace()), this, SLOT(replaceMatch()));
+    connect(findBar, SIGNAL(replaceAll()), this, SLOT(replaceAllMatches()));
+    connect(findBar, SIGNAL(closed()), this, SLOT(closeFind()));
+    connect(completingTextEdit, SIGNAL(matchesChanged()), this, SLOT(updateFindStatus()));
+    connect(largeFileView, SIGNAL(matchesChanged()), this, SLOT(updateFindStatus()));
+    QWidget *central = new QWidget;
+    QVBoxLayout *centralLayout = new QVBoxLayout(central);
+    centralLayout->setContentsMargins(0, 0, 0, 0);
+    centralLayout->setSpacing(0);
+    centralLayout->addWidget(centralStack);
+    centralLayout->addWidget(findBar);
+    setCentralWidget(central);
+
+    //the folder search docked beside the editors, shown once a folder is open
+    projectPanel = new ProjectPanel(projectIndex);
+    connect(projectPanel, SIGNAL(openMatch(QString,qint64)), this, SLOT(openProjectMatch(QString,qint64)));
+    projectDock = new QDockWidget(tr("Folder"), this);
+    projectDock->setObjectName("folder");
+    projectDock->setWidget(projectPanel);
+    addDockWidget(Qt::LeftDockWidgetArea, projectDock);
+    projectDock->hide();
     resize(700, 555);
     setWindowTitle(tr("Next Word Text Editor"));
 }
@@ -61,9 +158,10 @@ void MainWindow::createMenu()
     newFileAct->setShortcuts(QKeySequence::Close);
     QAction *openFileAct = new QAction(openIcon,tr("Open File"),this);
     openFileAct->setShortcuts(QKeySequence::Open);
-    QAction *saveAsAct = new QAction(saveIcon,tr("Save As"),this);
+    QAction *openFolderAct = new QAction(openIcon,tr("Open Folder..."),this);
+    saveAsAct = new QAction(saveIcon,tr("Save As"),this);
     saveAsAct->setShortcuts(QKeySequence::SaveAs);
-    QAction *saveAct = new QAction(saveIcon,tr("Save"),this);
+    saveAct = new QAction(saveIcon,tr("Save"),this);
     saveAct->setShortcuts(QKeySequence::Save);
 
     //connecting action
@@ -73,18 +171,75 @@ void MainWindow::createMenu()
     connect(newFileAct,SIGNAL(triggered()),this,SLOT(newFile()));
     connect(closeFileAct,SIGNAL(triggered()),this,SLOT(newFile()));
     connect(openFileAct,SIGNAL(triggered()),this,SLOT(openFile()));
+    connect(openFolderAct,SIGNAL(triggered()),this,SLOT(openFolder()));
     connect(saveAsAct,SIGNAL(triggered()),this,SLOT(saveAs()));
     connect(saveAct,SIGNAL(triggered()),this,SLOT(save()));
 
+    QAction *findAct = new QAction(tr("Find..."), this);
+    findAct->setShortcuts(QKeySequence::Find);
+    QAction *findNextAct = new QAction(tr("Find Next"), this);
+    findNextAct->setShortcuts(QKeySequence::FindNext);
+    QAction *findPreviousAct = new QAction(tr("Find Previous"), this);
+    findPreviousAct->setShortcuts(QKeySequence::FindPrevious);
+    QAction *replaceAct = new QAction(tr("Replace..."), this);
+    replaceAct->setShortcuts(QKeySequence::Replace);
+    QAction *findInFolderAct = new QAction(tr("Find in Folder..."), this);
+    findInFolderAct->setShortcut(QKeySequence(tr("Ctrl+Shift+F")));
+    connect(findAct, SIGNAL(triggered()), this, SLOT(showFind()));
+    connect(findNextAct, SIGNAL(triggered()), this, SLOT(findNext()));
+    connect(findPreviousAct, SIGNAL(triggered()), this, SLOT(findPrevious()));
+    connect(replaceAct, SIGNAL(triggered()), this, SLOT(showFind()));
+    connect(findInFolderAct, SIGNAL(triggered()), this, SLOT(findInFolder()));
+
     //add actions to the menu
     QMenu* fileMenu = menuBar()->addMenu(tr("File"));
     fileMenu->addAction(exitAction);
     fileMenu->addAction(newFileAct);
     fileMenu->addAction(openFileAct);
+    fileMenu->addAction(openFolderAct);
     fileMenu->addAction(saveAsAct);
     fileMenu->addAction(saveAct);
     fileMenu->addAction(closeFileAct);
 
+    QMenu* editMenu = menuBar()->addMenu(tr("Edit"));
+    editMenu->addAction(findAct);
+    editMenu->addAction(findNextAct);
+    editMenu->addAction(findPreviousAct);
+    editMenu->addAction(replaceAct);
+    editMenu->addSeparator();
+    editMenu->addAction(findInFolderAct);
+
+    QAction *overlayAct = new QAction(tr("Show Timings"), this);
+    overlayAct->setCheckable(true);
+    QAction *saveTimingsAct = new QAction(tr("Save Timings..."), this);
+    connect(overlayAct, SIGNAL(toggled(bool)), perfOverlay, SLOT(setVisible(bool)));
+    connect(saveTimingsAct, SIGNAL(triggered()), this, SLOT(saveTimings()));
+
+    QAction *fuzzyAct = new QAction(tr("Tolerate Typos"), this);
+    fuzzyAct->setCheckable(true);
+    connect(fuzzyAct, SIGNAL(toggled(bool)), this, SLOT(setFuzzyCompletion(bool)));
+
+    QMenu* completionMenu = menuBar()->addMenu(tr("Completion"));
+    completionMenu->addAction(fuzzyAct);
+
+    //the dictionary layers, filled by updateDictionaryMenus()
+    QAction *addListAct = new QAction(tr("Add Word List..."), this);
+    connect(addListAct, SIGNAL(triggered()), this, SLOT(addWordList()));
+    domainGroup = new QActionGroup(this);
+    generalGroup = new QActionGroup(this);
+    connect(domainGroup, SIGNAL(triggered(QAction*)), this, SLOT(dictionarySelected()));
+    connect(generalGroup, SIGNAL(triggered(QAction*)), this, SLOT(dictionarySelected()));
+
+    QMenu* dictionaryMenu = menuBar()->addMenu(tr("Dictionaries"));
+    domainMenu = dictionaryMenu->addMenu(tr("Domain"));
+    generalMenu = dictionaryMenu->addMenu(tr("General"));
+    dictionaryMenu->addSeparator();
+    dictionaryMenu->addAction(addListAct);
+
+    QMenu* perfMenu = menuBar()->addMenu(tr("Performance"));
+    perfMenu->addAction(overlayAct);
+    perfMenu->addAction(saveTimingsAct);
+
     QMenu* helpMenu = menuBar()->addMenu(tr("About"));
     helpMenu->addAction(aboutAct);
     helpMenu->addAction(aboutQtAct);
@@ -99,34 +254,20 @@ void MainWindow::createMenu()
 //! [1]
 
 //! [2]
-//! function: modelFromFile()
-//! get list of words sugestions from resource file
-//! read the file, assign content as QCompleter model
-//! Return QStringListModel
-//! Parameter: string of file path
-QAbstractItemModel *MainWindow::modelFromFile(const QString& fileName)
-{
-    //open source file
-    QFile file(fileName);
-    if (!file.open(QFile::ReadOnly))
-        return new QStringListModel(completer);
-    #ifndef QT_NO_CURSOR
-        QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-    #endif
-
-    //read & save content as list of string
-    QStringList words;
-    while (!file.atEnd()) {
-        QByteArray line = file.readLine();
-        if (!line.isEmpty())
-            words << line.trimmed();
-    }
-
-    //return list of words as completer model
-    #ifndef QT_NO_CURSOR
-        QApplication::restoreOverrideCursor();
-    #endif
-        return new QStringListModel(words, completer);
+//! function: completionModel()
+//! get the model of the words suggestions
+//! the model stays empty until dictionaryLoaded() hands it the dictionary
+//! of the selected lists, loaded by the DictionaryManager
+//! Return CompletionModel indexing the words for prefix lookup
+QAbstractItemModel *MainWindow::completionModel()
+{
+    CompletionModel *model = new CompletionModel(completer);
+    model->setLearningStore(learning);
+    model->setProjectIndex(projectIndex);
+    model->setCompletionClient(completionClient);
+    //ranking and fuzzy matching stay off the GUI thread
+    model->setBackgroundQueries(true);
+    return model;
 }
 //! [2]
 
@@ -148,6 +289,7 @@ void MainWindow::about()
 void MainWindow::newFile()
 {
     if (maybeSave()) {
+        closeView();
         completingTextEdit->clear();
         setCurrentFile(QString());
     }
@@ -174,6 +316,8 @@ void MainWindow::openFile()
 //! Open dialog to save current text as new file
 bool MainWindow::saveAs()
 {
+    if (documentFile->isLoading())
+        return false;
     QFileDialog dialog(this);
     dialog.setWindowModality(Qt::WindowModal);
     dialog.setAcceptMode(QFileDialog::AcceptSave);
@@ -187,9 +331,12 @@ bool MainWindow::saveAs()
 //! Function: save()
 //! check if current text is an opened file
 //! open dialog save as new file if current text is not saved
-//! save text as file
+//! save text as file; nothing is saved while a file is being loaded,
+//! curFile still names the file opened before it
 bool MainWindow::save()
 {
+    if (documentFile->isLoading())
+        return false;
     if (curFile.isEmpty()) {
         return saveAs();
     } else {
@@ -221,7 +368,14 @@ void MainWindow::setCurrentFile(const QString &fileName)
 //! Called when open file, create new file and close file
 bool MainWindow::maybeSave()
 {
-    if (!completingTextEdit->document()->isModified())
+    //a file still being loaded has no edits, drop it
+    if (documentFile->isLoading()) {
+        documentFile->cancel();
+        return true;
+    }
+    const bool modified = isViewing() ? largeFileView->isModified()
+                                      : completingTextEdit->document()->isModified();
+    if (!modified)
         return true;
     const QMessageBox::StandardButton ret
         = QMessageBox::warning(this, tr("Application"),
@@ -243,56 +397,69 @@ bool MainWindow::maybeSave()
 //! [10]
 //! Function saveFile(param: string, file path)
 //! check if file is writeable
-//! save current text to the file
+//! save current text to the file, streamed block by block
+//! or piece by piece from the large file editor
 //! called in save & save as function
 bool MainWindow::saveFile(const QString &fileName)
 {
-    QFile file(fileName);
-    if (!file.open(QFile::WriteOnly | QFile::Text)) {
-        QMessageBox::warning(this, tr("Application"),
-                             tr("Cannot write file %1:\n%2.")
-                             .arg(QDir::toNativeSeparators(fileName),
-                                  file.errorString()));
-        return false;
-    }
-
-    QTextStream out(&file);
     #ifndef QT_NO_CURSOR
         QApplication::setOverrideCursor(Qt::WaitCursor);
     #endif
-        out << completingTextEdit->toPlainText();
+        const bool saved = isViewing() ? largeFileView->save(fileName) : documentFile->save(fileName);
     #ifndef QT_NO_CURSOR
         QApplication::restoreOverrideCursor();
     #endif
+    if (!saved) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(QDir::toNativeSeparators(fileName),
+                                  isViewing() ? largeFileView->errorString() : documentFile->errorString()));
+        return false;
+    }
 
     setCurrentFile(fileName);
+    projectIndex->updateFile(fileName);
     statusBar()->showMessage(tr("File saved"), 2000);
     return true;
 }
 //! [10]
 
 //! [11]
-//! Function loadFile(param: string, file path)
-//! load existing text file
-void MainWindow::loadFile(const QString &fileName)
+//! Function loadFile(param: string, file path, line to show or -1)
+//! load existing text file, chunk by chunk from the event loop
+//! fileLoaded() is called once the whole file is in the editor
+//! large files may be edited in the large file editor instead
+void MainWindow::loadFile(const QString &fileName, qint64 line)
 {
-    QFile file(fileName);
-    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    if (documentFile->isLoading())
+        documentFile->cancel();
+    pendingLine = line;
+    const qint64 fileSize = QFileInfo(fileName).size();
+    if (fileSize >= LargeFileSize
+            && QMessageBox::question(this, tr("Application"),
+                                     tr("%1 is %2 MB large.\n"
+                                        "Open it in the large file editor?")
+                                     .arg(QDir::toNativeSeparators(fileName))
+                                     .arg(fileSize / (1024 * 1024))) == QMessageBox::Yes) {
+        viewFile(fileName);
+        return;
+    }
+    closeView();
+    completingTextEdit->beginLoad();
+    if (!documentFile->startLoading(fileName)) {
+        completingTextEdit->endLoad();
         QMessageBox::warning(this, tr("Application"),
                              tr("Cannot read file %1:\n%2.")
-                             .arg(QDir::toNativeSeparators(fileName), file.errorString()));
+                             .arg(QDir::toNativeSeparators(fileName), documentFile->errorString()));
         return;
     }
-    QTextStream in(&file);
-    #ifndef QT_NO_CURSOR
-        QApplication::setOverrideCursor(Qt::WaitCursor);
-    #endif
-        completingTextEdit->setPlainText(in.readAll());
-    #ifndef QT_NO_CURSOR
-        QApplication::restoreOverrideCursor();
-    #endif
-    setCurrentFile(fileName);
-    statusBar()->showMessage(tr("File loaded"), 2000);
+    loadingFile = fileName;
+    saveAct->setEnabled(false);
+    saveAsAct->setEnabled(false);
+    loadProgress->setValue(0);
+    loadProgress->show();
+    cancelLoadButton->show();
+    statusBar()->showMessage(tr("Loading %1...").arg(QDir::toNativeSeparators(fileName)));
 }
 //! [11]
 
@@ -307,3 +474,393 @@ void MainWindow::closeEvent (QCloseEvent *event)
     }
 }
 //![12]
+
+//! [13]
+//! function: dictionaryLoaded(param: files of the loaded layers)
+//! switch to the dictionary once it is built, if it is still the selected one
+void MainWindow::dictionaryLoaded(const QStringList &fileNames)
+{
+    DictionaryManager *dictionaries = DictionaryManager::instance();
+    if (fileNames != dictionaries->layerFiles(selectedLayers()))
+        return;
+    const QSharedPointer<Dictionary> dictionary = dictionaries->filesDictionary(fileNames);
+    //a list changed on disk while it was read, read it again
+    if (!dictionary) {
+        dictionaries->loadFiles(fileNames);
+        return;
+    }
+    CompletionModel *model = qobject_cast<CompletionModel *>(completer->model());
+    if (model && model->dictionary() != dictionary)
+        model->setDictionary(dictionary);
+    statusBar()->showMessage(tr("Word suggestions ready"), 2000);
+}
+//! [13]
+
+//! [14]
+//! function: fileLoaded(param: bool, whole file read)
+//! a cancelled or failed load leaves an empty, untitled document
+void MainWindow::fileLoaded(bool complete)
+{
+    loadProgress->hide();
+    cancelLoadButton->hide();
+    saveAct->setEnabled(true);
+    saveAsAct->setEnabled(true);
+    completingTextEdit->endLoad();
+    if (complete) {
+        setCurrentFile(loadingFile);
+        if (pendingLine >= 0)
+            completingTextEdit->goToLine(int(pendingLine));
+        pendingLine = -1;
+        statusBar()->showMessage(tr("File loaded"), 2000);
+        return;
+    }
+    pendingLine = -1;
+
+    const QString error = documentFile->errorString();
+    completingTextEdit->clear();
+    setCurrentFile(QString());
+    if (error.isEmpty()) {
+        statusBar()->showMessage(tr("Loading cancelled"), 2000);
+    } else {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot read file %1:\n%2.")
+                             .arg(QDir::toNativeSeparators(loadingFile), error));
+    }
+}
+//! [14]
+
+//! [15]
+//! function: viewFile(param: string, file path)
+//! show a file in the memory-mapped editor, lines are indexed in the background
+//! and the file can be edited once they are
+void MainWindow::viewFile(const QString &fileName)
+{
+    if (!largeFileView->open(fileName)) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot read file %1:\n%2.")
+                             .arg(QDir::toNativeSeparators(fileName), largeFileView->errorString()));
+        return;
+    }
+    closeFind();
+    completingTextEdit->clear();
+    centralStack->setCurrentWidget(largeFileView);
+    largeFileView->setFocus();
+    setCurrentFile(fileName);
+    loadProgress->setValue(0);
+    loadProgress->show();
+    statusBar()->showMessage(tr("Indexing lines..."));
+}
+//! [15]
+
+//! [16]
+//! function: closeView(), isViewing()
+//! go back from the large file editor to the text editor
+void MainWindow::closeView()
+{
+    if (!isViewing())
+        return;
+    closeFind();
+    largeFileView->close();
+    loadProgress->hide();
+    centralStack->setCurrentWidget(completingTextEdit);
+}
+
+bool MainWindow::isViewing() const
+{
+    return centralStack->currentWidget() == largeFileView;
+}
+//! [16]
+
+//! [17]
+//! function: viewIndexed()
+//! the large file editor can scroll through and edit the whole file,
+//! and shows the line asked for when it was opened
+void MainWindow::viewIndexed()
+{
+    loadProgress->hide();
+    if (pendingLine >= 0)
+        largeFileView->goToLine(pendingLine);
+    pendingLine = -1;
+    statusBar()->showMessage(tr("%1 lines").arg(largeFileView->lineCount()), 2000);
+}
+//! [17]
+
+//! [18]
+//! function: saveTimings()
+//! write the histograms of all timing probes to a JSON file
+void MainWindow::saveTimings()
+{
+    const QString fileName = QFileDialog::getSaveFileName(this, tr("Save Timings"), "timings.json",
+                                                          "JSON Files (*.json)");
+    if (fileName.isEmpty())
+        return;
+    QSaveFile file(fileName);
+    const QByteArray json = QJsonDocument(PerfProbe::toJson()).toJson();
+    if (!file.open(QFile::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(QDir::toNativeSeparators(fileName), file.errorString()));
+        return;
+    }
+    statusBar()->showMessage(tr("Timings saved"), 2000);
+}
+//! [18]
+
+//! [19]
+//! function: setFuzzyCompletion(param: bool)
+//! switch typo tolerant completion on or off
+void MainWindow::setFuzzyCompletion(bool enabled)
+{
+    CompletionModel *model = qobject_cast<CompletionModel *>(completer->model());
+    if (model)
+        model->setFuzzy(enabled);
+}
+//! [19]
+
+//! [20]
+//! function: selectedLayers(), useDictionaries()
+//! the chosen lists, domain over general; switch to their dictionary now
+//! if another window loaded it already, or as soon as it is loaded
+QStringList MainWindow::selectedLayers() const
+{
+    QStringList layers;
+    if (!domainList.isEmpty())
+        layers << domainList;
+    layers << generalList;
+    return layers;
+}
+
+void MainWindow::useDictionaries()
+{
+    DictionaryManager *dictionaries = DictionaryManager::instance();
+    const QStringList layers = selectedLayers();
+    if (completionClient->isAttached()) {
+        completionClient->setLayers(layers);
+        return;
+    }
+    if (dictionaries->dictionary(layers)) {
+        dictionaryLoaded(dictionaries->layerFiles(layers));
+        return;
+    }
+    dictionaries->load(layers);
+    statusBar()->showMessage(tr("Loading word suggestions..."));
+}
+//! [20]
+
+//! [21]
+//! function: updateDictionaryMenus()
+//! one checkable entry per registered list in the Domain and General menus
+void MainWindow::updateDictionaryMenus()
+{
+    domainMenu->clear();
+    generalMenu->clear();
+
+    QAction *noneAct = domainMenu->addAction(tr("None"));
+    noneAct->setCheckable(true);
+    noneAct->setChecked(domainList.isEmpty());
+    domainGroup->addAction(noneAct);
+    domainMenu->addSeparator();
+    foreach (const QString &name, DictionaryManager::instance()->listNames()) {
+        QAction *domainAct = domainMenu->addAction(name);
+        domainAct->setData(name);
+        domainAct->setCheckable(true);
+        domainAct->setChecked(name == domainList);
+        domainGroup->addAction(domainAct);
+
+        QAction *generalAct = generalMenu->addAction(name);
+        generalAct->setData(name);
+        generalAct->setCheckable(true);
+        generalAct->setChecked(name == generalList);
+        generalGroup->addAction(generalAct);
+    }
+}
+
+//! function: wordListChanged(param: name of the list)
+//! the files of a list were replaced, reload it if this window uses it
+void MainWindow::wordListChanged(const QString &name)
+{
+    if (selectedLayers().contains(name))
+        useDictionaries();
+}
+
+//! function: dictionarySelected()
+//! called when a list was chosen in one of the menus
+void MainWindow::dictionarySelected()
+{
+    domainList = domainGroup->checkedAction() ? domainGroup->checkedAction()->data().toString() : QString();
+    if (generalGroup->checkedAction())
+        generalList = generalGroup->checkedAction()->data().toString();
+    useDictionaries();
+}
+//! [21]
+
+//! [22]
+//! function: addWordList()
+//! register a word list from the file system, one word per line
+void MainWindow::addWordList()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Add Word List"));
+    if (fileName.isEmpty())
+        return;
+    DictionaryManager::instance()->addList(QFileInfo(fileName).completeBaseName(), QStringList() << fileName);
+    statusBar()->showMessage(tr("Word list added"), 2000);
+}
+//! [22]
+
+//! [23]
+//! function: showFind(), findChanged()
+//! open the find bar; every change of the query searches the editor shown
+void MainWindow::showFind()
+{
+    findBar->showFind();
+    findChanged();
+}
+
+void MainWindow::findChanged()
+{
+    if (isViewing())
+        largeFileView->find(findBar->pattern(), findBar->options());
+    else
+        completingTextEdit->find(findBar->pattern(), findBar->options());
+}
+//! [23]
+
+//! [24]
+//! function: findNext(), findPrevious()
+//! select the next or the previous match, the find bar is opened first
+void MainWindow::findNext()
+{
+    if (findBar->isHidden()) {
+        showFind();
+        return;
+    }
+    const bool found = isViewing() ? largeFileView->findNext(false) : completingTextEdit->findNext(false);
+    if (!found)
+        statusBar()->showMessage(tr("No matches"), 2000);
+}
+
+void MainWindow::findPrevious()
+{
+    if (findBar->isHidden()) {
+        showFind();
+        return;
+    }
+    const bool found = isViewing() ? largeFileView->findNext(true) : completingTextEdit->findNext(true);
+    if (!found)
+        statusBar()->showMessage(tr("No matches"), 2000);
+}
+//! [24]
+
+//! [25]
+//! function: replaceMatch(), replaceAllMatches()
+//! replace the selected match, or every match as one edit
+//! refused while a file is still being loaded, as saving is
+void MainWindow::replaceMatch()
+{
+    if (documentFile->isLoading())
+        return;
+    const QString replacement = findBar->replacement();
+    const bool found = isViewing() ? largeFileView->replace(replacement) : completingTextEdit->replace(replacement);
+    if (!found)
+        statusBar()->showMessage(tr("No matches"), 2000);
+}
+
+void MainWindow::replaceAllMatches()
+{
+    if (documentFile->isLoading())
+        return;
+    const QString replacement = findBar->replacement();
+    #ifndef QT_NO_CURSOR
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+    #endif
+        const int count = isViewing() ? largeFileView->replaceAll(replacement)
+                                      : completingTextEdit->replaceAll(replacement);
+    #ifndef QT_NO_CURSOR
+        QApplication::restoreOverrideCursor();
+    #endif
+    statusBar()->showMessage(tr("%n match(es) replaced", 0, count), 2000);
+}
+//! [25]
+
+//! [26]
+//! function: closeFind(), updateFindStatus()
+//! hide the find bar and drop the query of both editors; or show the
+//! number of matches of the editor shown
+void MainWindow::closeFind()
+{
+    const bool shown = findBar->isVisible();
+    findBar->hide();
+    completingTextEdit->clearFind();
+    largeFileView->clearFind();
+    if (shown)
+        centralStack->currentWidget()->setFocus();
+}
+
+void MainWindow::updateFindStatus()
+{
+    findBar->setMatches(isViewing() ? largeFileView->textSearch() : completingTextEdit->textSearch());
+}
+//! [26]
+
+//! [27]
+//! function: openFolder(), findInFolder()
+//! index the files of a folder for search and completion, and search it
+//! from the dock; without a folder one is asked for first
+void MainWindow::openFolder()
+{
+    const QString directory = QFileDialog::getExistingDirectory(this, tr("Open Folder"), projectIndex->directory());
+    if (directory.isEmpty())
+        return;
+    projectIndex->open(directory);
+    projectDock->setWindowTitle(QDir::toNativeSeparators(directory));
+    projectDock->show();
+    projectPanel->showFind();
+}
+
+void MainWindow::findInFolder()
+{
+    if (projectIndex->directory().isEmpty()) {
+        openFolder();
+        return;
+    }
+    projectDock->show();
+    projectDock->raise();
+    projectPanel->showFind();
+}
+//! [27]
+
+//! [28]
+//! function: openProjectMatch(param: string file path, line number)
+//! show a line found in the folder, opening its file unless it is the
+//! current one; the line is shown once the file is loaded or indexed
+void MainWindow::openProjectMatch(const QString &fileName, qint64 line)
+{
+    if (fileName != curFile || documentFile->isLoading()) {
+        if (maybeSave())
+            loadFile(fileName, line);
+        return;
+    }
+    if (isViewing()) {
+        pendingLine = largeFileView->isIndexed() ? -1 : line;
+        largeFileView->goToLine(line);
+        largeFileView->setFocus();
+    } else {
+        completingTextEdit->goToLine(int(line));
+        completingTextEdit->setFocus();
+    }
+}
+//! [28]
+
+//! [29]
+//! function: completionServerLost()
+//! the completion server went away, load what it was serving
+void MainWindow::completionServerLost()
+{
+    CompletionModel *model = qobject_cast<CompletionModel *>(completer->model());
+    if (model)
+        model->setCompletionClient(0);
+    learning->load();
+    useDictionaries();
+}
+//! [29]
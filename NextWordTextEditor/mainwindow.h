@@ -7,16 +7,31 @@
 
 //import dependencies
 #include <QMainWindow>
+#include <QStringList>
 
 QT_BEGIN_NAMESPACE
 class QAbstractItemModel;
+class QAction;
+class QActionGroup;
 class QComboBox;
 class QCompleter;
+class QDockWidget;
 class QLabel;
 class QLineEdit;
+class QMenu;
 class QProgressBar;
+class QPushButton;
+class QStackedWidget;
 QT_END_NAMESPACE
 class TextEdit;
+class LearningStore;
+class DocumentFile;
+class LargeFileView;
+class FindBar;
+class PerfOverlay;
+class ProjectIndex;
+class ProjectPanel;
+class CompletionClient;
 
 //! [0]
 class MainWindow : public QMainWindow
@@ -26,7 +41,7 @@ class MainWindow : public QMainWindow
 //set public methods &variables
     public:
         MainWindow(QWidget *parent = 0);
-        void loadFile(const QString &fileName);
+        void loadFile(const QString &fileName, qint64 line = -1);
 
 //set private slot methods & variables
     private slots:
@@ -35,6 +50,27 @@ class MainWindow : public QMainWindow
         void openFile();
         bool saveAs();
         bool save();
+        void dictionaryLoaded(const QStringList &fileNames);
+        void fileLoaded(bool complete);
+        void viewIndexed();
+        void saveTimings();
+        void setFuzzyCompletion(bool enabled);
+        void updateDictionaryMenus();
+        void wordListChanged(const QString &name);
+        void dictionarySelected();
+        void addWordList();
+        void showFind();
+        void findChanged();
+        void findNext();
+        void findPrevious();
+        void replaceMatch();
+        void replaceAllMatches();
+        void closeFind();
+        void updateFindStatus();
+        void openFolder();
+        void findInFolder();
+        void openProjectMatch(const QString &fileName, qint64 line);
+        void completionServerLost();
 
 //set private methods
     private:
@@ -43,10 +79,37 @@ class MainWindow : public QMainWindow
         void setCurrentFile(const QString &fileName);
         bool saveFile(const QString &fileName);
         void closeEvent (QCloseEvent *event);
-        QAbstractItemModel *modelFromFile(const QString& fileName);
+        QAbstractItemModel *completionModel();
+        QStringList selectedLayers() const;
+        void useDictionaries();
+        void viewFile(const QString &fileName);
+        void closeView();
+        bool isViewing() const;
 
         QCompleter *completer;
+        QAction *saveAct;           // disabled while a file is being loaded
+        QAction *saveAsAct;
+        QMenu *domainMenu;
+        QMenu *generalMenu;
+        QActionGroup *domainGroup;
+        QActionGroup *generalGroup;
+        QString domainList;         // empty for none
+        QString generalList;
+        LearningStore *learning;
         TextEdit *completingTextEdit;
+        DocumentFile *documentFile;
+        QProgressBar *loadProgress;
+        QPushButton *cancelLoadButton;
+        LargeFileView *largeFileView;
+        QStackedWidget *centralStack;
+        FindBar *findBar;
+        PerfOverlay *perfOverlay;
+        ProjectIndex *projectIndex;
+        ProjectPanel *projectPanel;
+        QDockWidget *projectDock;
+        CompletionClient *completionClient;
+        QString loadingFile;
+        qint64 pendingLine;         // line to show once the loading file is shown, -1 for none
         QString curFile;
 };
 //! [0]
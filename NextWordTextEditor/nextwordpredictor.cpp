@@ -0,0 +1,142 @@
+/*
+ * NextWordPredictor Class
+ * Rank the continuations of the previous word from the bigram lines
+*/
+#include "nextwordpredictor.h"
+#include "dictionaryimage.h"
+
+#include <QSet>
+
+//! [0]
+//! main function
+//! create an empty predictor
+NextWordPredictor::NextWordPredictor()
+{
+    clear();
+}
+//! [0]
+
+//! [1]
+//! function: compile(param: interned lines of the word list best ranked first, output image)
+//! group the successors of every bigram line by head token and store the
+//! tables as sections of the image, the tokens themselves are written by
+//! the pool
+void NextWordPredictor::compile(const TokenPool::Builder &tokens, DictionaryImage *image)
+{
+    QVector<qint32> heads;
+    QVector<qint32> tails;
+    QSet<quint64> seen;
+    for (int line = 0; line < tokens.lineCount(); ++line) {
+        int length;
+        const qint32 *ids = tokens.lineTokens(line, &length);
+        if (length != 2)
+            continue;
+        const quint64 pair = (quint64(quint32(ids[0])) << 32) | quint32(ids[1]);
+        if (seen.contains(pair))
+            continue;
+        seen.insert(pair);
+        heads.append(ids[0]);
+        tails.append(ids[1]);
+    }
+
+    //counting sort by head keeps the source order among the successors
+    const int tokenCount = tokens.tokenCount();
+    QVector<qint32> offsets(tokenCount + 1, 0);
+    foreach (qint32 head, heads)
+        ++offsets[head + 1];
+    for (int i = 0; i < tokenCount; ++i)
+        offsets[i + 1] += offsets.at(i);
+    QVector<qint32> next = offsets;
+    QVector<qint32> successorTable(tails.size());
+    for (int i = 0; i < heads.size(); ++i)
+        successorTable[next[heads.at(i)]++] = tails.at(i);
+
+    image->setSection(DictionaryImage::SuccessorOffsets, offsets);
+    image->setSection(DictionaryImage::Successors, successorTable);
+}
+//! [1]
+
+//! [2]
+//! function: attach(param: compiled image)
+//! point the predictor at the tables of the image, which must outlive it
+bool NextWordPredictor::attach(const DictionaryImage &image)
+{
+    clear();
+    if (!tokens.attach(image))
+        return false;
+
+    int offsetCount;
+    successorOffsets = image.section<qint32>(DictionaryImage::SuccessorOffsets, &offsetCount);
+    successors = image.section<qint32>(DictionaryImage::Successors, &bigrams);
+
+    //every offset and token id must stay inside its section
+    if (offsetCount != tokens.size() + 1
+            || !DictionaryImage::validOffsets(successorOffsets, offsetCount, bigrams)
+            || !DictionaryImage::validIds(successors, bigrams, 0, tokens.size())) {
+        clear();
+        return false;
+    }
+    return true;
+}
+//! [2]
+
+//! [3]
+//! function: clear()
+//! detach from the image
+void NextWordPredictor::clear()
+{
+    tokens.clear();
+    bigrams = 0;
+    successorOffsets = 0;
+    successors = 0;
+}
+//! [3]
+
+//! [4]
+//! function: tokenCount(), bigramCount()
+//! number of distinct tokens and of stored bigrams
+int NextWordPredictor::tokenCount() const
+{
+    return tokens.size();
+}
+
+int NextWordPredictor::bigramCount() const
+{
+    return bigrams;
+}
+//! [4]
+
+//! [5]
+//! function: tokenId(param: string), token(param: token id)
+//! map between a word (case-insensitive) and its token id, -1 if missing
+int NextWordPredictor::tokenId(const QString &word) const
+{
+    return tokens.find(word);
+}
+
+QString NextWordPredictor::token(int id) const
+{
+    return tokens.word(id);
+}
+//! [5]
+
+//! [6]
+//! function: predict(param: previous word, typed prefix, max results)
+//! return ids of the tokens following previousWord that start with prefix
+QVector<int> NextWordPredictor::predict(const QString &previousWord, const QString &prefix, int limit) const
+{
+    QVector<int> result;
+    const int head = tokenId(previousWord);
+    if (head < 0 || limit <= 0)
+        return result;
+
+    const QByteArray folded = prefix.toCaseFolded().toUtf8();
+    const int end = successorOffsets[head + 1];
+    for (int i = successorOffsets[head]; i < end && result.size() < limit; ++i) {
+        const qint32 tail = successors[i];
+        if (folded.isEmpty() || tokens.keyStartsWith(tail, folded))
+            result.append(tail);
+    }
+    return result;
+}
+//! [6]
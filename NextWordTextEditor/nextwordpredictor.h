@@ -0,0 +1,48 @@
+/*
+ * Header NextWordPredictor class
+ * Bigram table predicting the words following a given word
+*/
+
+#ifndef NEXTWORDPREDICTOR_H
+#define NEXTWORDPREDICTOR_H
+
+//import dependencies
+#include <QString>
+#include <QVector>
+#include "tokenpool.h"
+
+class DictionaryImage;
+
+//! [0]
+//! Built from the "word nextword" lines of the word lists. Tokens are the
+//! ids of the shared TokenPool, the successor ids of a token are stored
+//! contiguously (ordered by their rank in the source list), so a bigram
+//! costs four bytes and a prediction one hash lookup plus the number of
+//! successors.
+//! All tables are read in place from a DictionaryImage.
+class NextWordPredictor
+{
+    //set public methods & variables
+    public:
+        NextWordPredictor();
+
+        static void compile(const TokenPool::Builder &tokens, DictionaryImage *image);
+        bool attach(const DictionaryImage &image);
+        void clear();
+
+        int tokenCount() const;
+        int bigramCount() const;
+        int tokenId(const QString &word) const;
+        QString token(int id) const;
+        QVector<int> predict(const QString &previousWord, const QString &prefix, int limit) const;
+
+    //set private methods & variables
+    private:
+        TokenPool tokens;
+        int bigrams;
+        const qint32 *successorOffsets;
+        const qint32 *successors;
+};
+//! [0]
+
+#endif // NEXTWORDPREDICTOR_H
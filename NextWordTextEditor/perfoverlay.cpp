@@ -0,0 +1,57 @@
+/*
+ * PerfOverlay Class
+ * Refresh a one-line summary of the probe histograms
+*/
+#include "perfoverlay.h"
+#include "perfprobe.h"
+
+//! [0]
+//! main function
+//! refresh on a timer that only runs while the overlay is shown
+PerfOverlay::PerfOverlay(QWidget *parent)
+    : QLabel(parent)
+{
+    refreshTimer.setInterval(RefreshInterval);
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+//! [0]
+
+//! [1]
+//! function: showEvent(param: QShowEvent), hideEvent(param: QHideEvent)
+//! start and stop refreshing
+void PerfOverlay::showEvent(QShowEvent *event)
+{
+    refresh();
+    refreshTimer.start();
+    QLabel::showEvent(event);
+}
+
+void PerfOverlay::hideEvent(QHideEvent *event)
+{
+    refreshTimer.stop();
+    QLabel::hideEvent(event);
+}
+//! [1]
+
+//! [2]
+//! function: refresh()
+//! p99 / max in ms of every interactive stage that recorded something
+void PerfOverlay::refresh()
+{
+    static const PerfProbe::Stage stages[] = {
+        PerfProbe::KeyPress, PerfProbe::Completion, PerfProbe::ModelUpdate, PerfProbe::HighlightBlock,
+        PerfProbe::Search
+    };
+    QStringList parts;
+    for (unsigned i = 0; i < sizeof(stages) / sizeof(stages[0]); ++i) {
+        const LatencyHistogram histogram = PerfProbe::histogram(stages[i]);
+        if (histogram.count() == 0)
+            continue;
+        parts << tr("%1 %2/%3 ms")
+                 .arg(PerfProbe::stageName(stages[i]))
+                 .arg(histogram.percentile(0.99) / 1000.0, 0, 'f', 2)
+                 .arg(histogram.maximum() / 1000.0, 0, 'f', 2);
+    }
+    setText(parts.isEmpty() ? tr("no timings yet") : tr("p99/max: ") + parts.join(QLatin1String("  ")));
+}
+//! [2]
@@ -0,0 +1,41 @@
+/*
+ * Header PerfOverlay class
+ * Status bar summary of the timing probes
+*/
+
+#ifndef PERFOVERLAY_H
+#define PERFOVERLAY_H
+
+//import dependencies
+#include <QLabel>
+#include <QTimer>
+
+//! [0]
+//! Shows the p99 and maximum of the interactive stages, refreshed every
+//! RefreshInterval ms while visible.
+class PerfOverlay : public QLabel
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const int RefreshInterval = 500;
+
+        PerfOverlay(QWidget *parent = 0);
+
+    //set protected methods & variables
+    protected:
+        void showEvent(QShowEvent *event) Q_DECL_OVERRIDE;
+        void hideEvent(QHideEvent *event) Q_DECL_OVERRIDE;
+
+    //set private slots methods
+    private slots:
+        void refresh();
+
+    //set private methods & variables
+    private:
+        QTimer refreshTimer;
+};
+//! [0]
+
+#endif // PERFOVERLAY_H
@@ -0,0 +1,125 @@
+/*
+ * PerfProbe Class
+ * Count probe durations in per-thread atomic histograms
+*/
+#include "perfprobe.h"
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QVector>
+
+namespace {
+
+//buckets of one thread, written by that thread only
+struct ThreadCounters
+{
+    QAtomicInteger<quint64> buckets[PerfProbe::StageCount][LatencyHistogram::BucketCount];
+    QAtomicInteger<qint64> maxima[PerfProbe::StageCount];
+};
+
+//counters of every thread that recorded, kept after the thread ends
+QMutex registryMutex;
+QVector<ThreadCounters *> registry;
+
+ThreadCounters *threadCounters()
+{
+    static thread_local ThreadCounters *counters = 0;
+    if (!counters) {
+        counters = new ThreadCounters;
+        QMutexLocker locker(&registryMutex);
+        registry.append(counters);
+    }
+    return counters;
+}
+
+} // namespace
+
+//! [0]
+//! main function
+//! start timing a stage until the probe goes out of scope
+PerfProbe::PerfProbe(Stage stage)
+    : stage(stage)
+{
+    timer.start();
+}
+
+PerfProbe::~PerfProbe()
+{
+    record(stage, timer.nsecsElapsed());
+}
+//! [0]
+
+//! [1]
+//! function: record(param: stage, duration in ns)
+//! count a duration in the buckets of the calling thread
+void PerfProbe::record(Stage stage, qint64 nanoseconds)
+{
+    ThreadCounters *counters = threadCounters();
+    const qint64 microseconds = qMax(qint64(0), nanoseconds / 1000);
+    counters->buckets[stage][LatencyHistogram::bucketOf(microseconds)].fetchAndAddRelaxed(1);
+    //only this thread raises its maximum, a plain compare is enough
+    if (microseconds > counters->maxima[stage].load())
+        counters->maxima[stage].store(microseconds);
+}
+//! [1]
+
+//! [2]
+//! function: histogram(param: stage)
+//! merge the buckets of all threads, counts still being added may be missed
+LatencyHistogram PerfProbe::histogram(Stage stage)
+{
+    LatencyHistogram merged;
+    QMutexLocker locker(&registryMutex);
+    foreach (const ThreadCounters *counters, registry) {
+        const qint64 maximum = counters->maxima[stage].load();
+        for (int i = 0; i < LatencyHistogram::BucketCount; ++i) {
+            const quint64 count = counters->buckets[stage][i].load();
+            if (count)
+                merged.add(i, count, maximum);
+        }
+    }
+    return merged;
+}
+//! [2]
+
+//! [3]
+//! function: stageName(param: stage)
+//! name of a stage in reports
+QString PerfProbe::stageName(Stage stage)
+{
+    static const char *const names[StageCount] = {
+        "key_press", "completion", "model_update", "highlight_block", "load_chunk", "save_file", "search"
+    };
+    return QLatin1String(names[stage]);
+}
+//! [3]
+
+//! [4]
+//! function: toJson(), reset()
+//! histograms of all stages, or start counting from zero
+QJsonObject PerfProbe::toJson()
+{
+    QJsonObject stages;
+    for (int stage = 0; stage < StageCount; ++stage)
+        stages[stageName(Stage(stage))] = histogram(Stage(stage)).toJson();
+    QJsonObject json;
+    {
+        QMutexLocker locker(&registryMutex);
+        json["threads"] = registry.size();
+    }
+    json["stages"] = stages;
+    return json;
+}
+
+void PerfProbe::reset()
+{
+    QMutexLocker locker(&registryMutex);
+    foreach (ThreadCounters *counters, registry) {
+        for (int stage = 0; stage < StageCount; ++stage) {
+            for (int i = 0; i < LatencyHistogram::BucketCount; ++i)
+                counters->buckets[stage][i].store(0);
+            counters->maxima[stage].store(0);
+        }
+    }
+}
+//! [4]
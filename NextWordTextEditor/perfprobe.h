@@ -0,0 +1,53 @@
+/*
+ * Header PerfProbe class
+ * Always-on timing probes of the editor hot paths
+*/
+
+#ifndef PERFPROBE_H
+#define PERFPROBE_H
+
+//import dependencies
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include "latencyhistogram.h"
+
+//! [0]
+//! A probe times its scope and counts the duration in the histogram of its
+//! stage. Every thread records into its own relaxed atomic buckets, so a
+//! probe costs two clock reads and two uncontended atomic adds; the only
+//! lock is taken once per thread to register its buckets. Snapshots merge
+//! the buckets of all threads that ever recorded.
+class PerfProbe
+{
+    //set public methods & variables
+    public:
+        enum Stage {
+            KeyPress,       // TextEdit::keyPressEvent
+            Completion,     // query, prefix and popup of one keystroke
+            ModelUpdate,    // learning an accepted completion
+            HighlightBlock, // Highlighter::highlightBlock
+            LoadChunk,      // one chunk appended by DocumentFile
+            SaveFile,       // DocumentFile::save
+            Search,         // one scan of the text for a find query
+            StageCount
+        };
+
+        explicit PerfProbe(Stage stage);
+        ~PerfProbe();
+
+        static void record(Stage stage, qint64 nanoseconds);
+        static LatencyHistogram histogram(Stage stage);
+        static QString stageName(Stage stage);
+        static QJsonObject toJson();
+        static void reset();
+
+    //set private methods & variables
+    private:
+        Q_DISABLE_COPY(PerfProbe)
+
+        Stage stage;
+        QElapsedTimer timer;
+};
+//! [0]
+
+#endif // PERFPROBE_H
@@ -0,0 +1,624 @@
+/*
+ * PieceTable Class
+ * Insert, remove, undo and look up lines over pieces of two buffers
+*/
+#include "piecetable.h"
+
+#include <QIODevice>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+//newlines in a byte range of a buffer
+qint64 countNewlines(const char *p, const char *end)
+{
+    qint64 count = 0;
+    while (p < end && (p = static_cast<const char *>(std::memchr(p, '\n', end - p))) != 0) {
+        ++count;
+        ++p;
+    }
+    return count;
+}
+
+} // namespace
+
+//! [0]
+//! function: append(param: bytes), newlinesBefore(param: buffer position)
+//! grow the added buffer, recounting the block it ended in
+void PieceTable::Buffer::append(const QByteArray &text)
+{
+    const qint64 first = size / BlockSize;
+    bytes.append(text);
+    data = bytes.constData();
+    size = bytes.size();
+    blockLines.resize(int(first) + 1);
+    for (qint64 block = first; block * BlockSize < size; ++block) {
+        const char *begin = data + block * BlockSize;
+        const char *end = data + qMin(size, (block + 1) * BlockSize);
+        blockLines.append(blockLines.at(int(block)) + countNewlines(begin, end));
+    }
+}
+
+qint64 PieceTable::Buffer::newlinesBefore(qint64 position) const
+{
+    const qint64 block = position / BlockSize;
+    return blockLines.at(int(block)) + countNewlines(data + block * BlockSize, data + position);
+}
+//! [0]
+
+//! [1]
+//! function: newlines(param: buffer range), findNewline(param: buffer position, count)
+//! count newlines, or find the count-th newline from start (which exists),
+//! through the block index so that no more than a block is scanned
+qint64 PieceTable::Buffer::newlines(qint64 start, qint64 length) const
+{
+    if (length <= BlockSize)
+        return countNewlines(data + start, data + start + length);
+    return newlinesBefore(start + length) - newlinesBefore(start);
+}
+
+qint64 PieceTable::Buffer::findNewline(qint64 start, qint64 count) const
+{
+    const qint64 target = newlinesBefore(start) + count;
+    //the block holding the newline is the last one with fewer before it
+    const qint64 block = qint64(std::lower_bound(blockLines.constBegin(), blockLines.constEnd(), target)
+                                - blockLines.constBegin()) - 1;
+    qint64 position = start;
+    qint64 seen = target - count;
+    if (block * BlockSize > start) {
+        position = block * BlockSize;
+        seen = blockLines.at(int(block));
+    }
+    for (;;) {
+        const char *p = static_cast<const char *>(std::memchr(data + position, '\n', size - position));
+        position = p - data;
+        if (++seen == target)
+            return position;
+        ++position;
+    }
+}
+//! [1]
+
+//! [2]
+//! main function
+//! create an empty text
+PieceTable::PieceTable()
+    : root(-1), seed(0x9e3779b9u), cleanDepth(0)
+{
+    clear();
+}
+//! [2]
+
+//! [3]
+//! function: setText(param: original bytes, size, newlines before every BlockSize bytes)
+//! start over with one piece spanning the original, which must outlive the table
+void PieceTable::setText(const char *original, qint64 size, const QVector<qint64> &blockLines)
+{
+    clear();
+    buffers[Original].data = original;
+    buffers[Original].size = size;
+    buffers[Original].blockLines = blockLines;
+    if (size > 0)
+        root = newNode(Original, 0, size, blockLines.last());
+}
+
+//! function: clear()
+//! drop the text, the added bytes and the history
+void PieceTable::clear()
+{
+    for (int i = 0; i < 2; ++i) {
+        buffers[i].data = 0;
+        buffers[i].size = 0;
+        buffers[i].bytes.clear();
+        buffers[i].blockLines = QVector<qint64>(1, 0);
+    }
+    nodes.clear();
+    root = -1;
+    undoStack.clear();
+    redoStack.clear();
+    cleanDepth = 0;
+}
+//! [3]
+
+//! [4]
+//! function: size(), lineCount()
+//! bytes and lines of the text, the last line has no newline
+qint64 PieceTable::size() const
+{
+    return totalLength(root);
+}
+
+qint64 PieceTable::lineCount() const
+{
+    return totalNewlines(root) + 1;
+}
+//! [4]
+
+//! [5]
+//! function: lineStart(param: line number)
+//! position after the line-th newline, the size past the last line
+qint64 PieceTable::lineStart(qint64 line) const
+{
+    if (line <= 0)
+        return 0;
+    qint64 offset = 0;
+    qint32 node = root;
+    while (node != -1) {
+        const Node &n = nodes.at(node);
+        const qint64 leftNewlines = totalNewlines(n.left);
+        if (line <= leftNewlines) {
+            node = n.left;
+            continue;
+        }
+        offset += totalLength(n.left);
+        line -= leftNewlines;
+        if (line <= n.newlines)
+            return offset + buffers[n.buffer].findNewline(n.start, line) - n.start + 1;
+        offset += n.length;
+        line -= n.newlines;
+        node = n.right;
+    }
+    return offset;
+}
+
+//! function: lineAt(param: position)
+//! line number of a position, the number of newlines before it
+qint64 PieceTable::lineAt(qint64 position) const
+{
+    qint64 line = 0;
+    qint32 node = root;
+    while (node != -1) {
+        const Node &n = nodes.at(node);
+        const qint64 leftLength = totalLength(n.left);
+        if (position < leftLength) {
+            node = n.left;
+            continue;
+        }
+        line += totalNewlines(n.left);
+        position -= leftLength;
+        if (position < n.length)
+            return line + buffers[n.buffer].newlines(n.start, position);
+        line += n.newlines;
+        position -= n.length;
+        node = n.right;
+    }
+    return line;
+}
+//! [5]
+
+//! [6]
+//! function: text(param: position, length)
+//! copy a range of the text, only the pieces overlapping it are visited
+QByteArray PieceTable::text(qint64 position, qint64 length) const
+{
+    QByteArray out;
+    position = qBound(qint64(0), position, size());
+    length = qBound(qint64(0), length, size() - position);
+    out.reserve(int(length));
+    collect(root, position, position + length, &out);
+    return out;
+}
+
+void PieceTable::collect(qint32 node, qint64 from, qint64 to, QByteArray *out) const
+{
+    if (node == -1 || from >= to)
+        return;
+    const Node &n = nodes.at(node);
+    const qint64 leftLength = totalLength(n.left);
+    if (from < leftLength)
+        collect(n.left, from, qMin(to, leftLength), out);
+    const qint64 begin = qMax(from, leftLength);
+    const qint64 end = qMin(to, leftLength + n.length);
+    if (begin < end)
+        out->append(buffers[n.buffer].data + n.start + begin - leftLength, int(end - begin));
+    if (to > leftLength + n.length)
+        collect(n.right, qMax(qint64(0), from - leftLength - n.length), to - leftLength - n.length, out);
+}
+//! [6]
+
+//! [7]
+//! function: write(param: device)
+//! stream the pieces in order, without assembling the text
+bool PieceTable::write(QIODevice *device) const
+{
+    QVector<qint32> stack;
+    qint32 node = root;
+    while (node != -1 || !stack.isEmpty()) {
+        while (node != -1) {
+            stack.append(node);
+            node = nodes.at(node).left;
+        }
+        const Node &n = nodes.at(stack.last());
+        stack.removeLast();
+        if (device->write(buffers[n.buffer].data + n.start, n.length) != n.length)
+            return false;
+        node = n.right;
+    }
+    return true;
+}
+
+//! function: spans()
+//! the pieces in order, read in place until the next edit
+QVector<TextSearch::Span> PieceTable::spans() const
+{
+    QVector<TextSearch::Span> out;
+    QVector<qint32> stack;
+    qint32 node = root;
+    while (node != -1 || !stack.isEmpty()) {
+        while (node != -1) {
+            stack.append(node);
+            node = nodes.at(node).left;
+        }
+        const Node &n = nodes.at(stack.last());
+        stack.removeLast();
+        TextSearch::Span span;
+        span.data = buffers[n.buffer].data + n.start;
+        span.length = n.length;
+        out.append(span);
+        node = n.right;
+    }
+    return out;
+}
+//! [7]
+
+//! [8]
+//! function: insert(param: position, bytes)
+//! append the bytes to the added buffer and link them in as a piece;
+//! typing at the end of the last added piece only grows that piece
+//! consecutive typing is one undo step until a newline is typed
+void PieceTable::insert(qint64 position, const QByteArray &text)
+{
+    if (text.isEmpty())
+        return;
+    position = qBound(qint64(0), position, size());
+    Buffer &added = buffers[Added];
+    const qint64 start = added.size;
+    const qint64 newlines = countNewlines(text.constData(), text.constData() + text.size());
+    added.append(text);
+
+    qint32 left, right;
+    split(root, position, &left, &right);
+    if (!extendLast(left, text.size(), newlines))
+        left = merge(left, newNode(Added, start, text.size(), newlines));
+    root = merge(left, right);
+
+    Edit edit;
+    edit.position = position;
+    edit.removedLength = 0;
+    edit.insertedLength = text.size();
+    edit.removed = -1;
+    edit.inserted = -1;
+    if (canCoalesce() && newlines == 0) {
+        Edit &last = undoStack.last();
+        if (last.removedLength == 0 && last.position + last.insertedLength == position) {
+            last.insertedLength += text.size();
+            return;
+        }
+    }
+    pushEdit(edit);
+}
+
+//! function: remove(param: position, length)
+//! unlink the pieces of a range, keeping them for undo;
+//! consecutive deletes and backspaces are one undo step within a line
+void PieceTable::remove(qint64 position, qint64 length)
+{
+    position = qBound(qint64(0), position, size());
+    length = qBound(qint64(0), length, size() - position);
+    if (length == 0)
+        return;
+    const qint32 removed = extract(position, length);
+
+    if (canCoalesce() && totalNewlines(removed) == 0) {
+        Edit &last = undoStack.last();
+        if (last.insertedLength == 0 && totalNewlines(last.removed) == 0) {
+            if (position + length == last.position) {
+                last.removed = merge(removed, last.removed);
+                last.position = position;
+                last.removedLength += length;
+                return;
+            }
+            if (position == last.position) {
+                last.removed = merge(last.removed, removed);
+                last.removedLength += length;
+                return;
+            }
+        }
+    }
+    Edit edit;
+    edit.position = position;
+    edit.removedLength = length;
+    edit.insertedLength = 0;
+    edit.removed = removed;
+    edit.inserted = -1;
+    pushEdit(edit);
+}
+
+//! function: canCoalesce(), pushEdit(param: edit)
+//! an edit joins the last step unless that was undone or saved; a new step
+//! drops the redo steps, and the saved state if it was among them
+bool PieceTable::canCoalesce() const
+{
+    return !undoStack.isEmpty() && redoStack.isEmpty() && undoStack.size() != cleanDepth;
+}
+
+void PieceTable::pushEdit(const Edit &edit)
+{
+    if (cleanDepth > undoStack.size())
+        cleanDepth = -1;
+    redoStack.clear();
+    undoStack.append(edit);
+}
+//! [8]
+
+//! [9]
+//! function: undo(), redo()
+//! swap the inserted and the removed pieces of the last step;
+//! return the position after the restored text, -1 without a step
+qint64 PieceTable::undo()
+{
+    if (undoStack.isEmpty())
+        return -1;
+    Edit edit = undoStack.takeLast();
+    edit.inserted = extract(edit.position, edit.insertedLength);
+    place(edit.position, edit.removed);
+    edit.removed = -1;
+    redoStack.append(edit);
+    return edit.position + edit.removedLength;
+}
+
+qint64 PieceTable::redo()
+{
+    if (redoStack.isEmpty())
+        return -1;
+    Edit edit = redoStack.takeLast();
+    edit.removed = extract(edit.position, edit.removedLength);
+    place(edit.position, edit.inserted);
+    edit.inserted = -1;
+    undoStack.append(edit);
+    return edit.position + edit.insertedLength;
+}
+
+bool PieceTable::isUndoAvailable() const
+{
+    return !undoStack.isEmpty();
+}
+
+bool PieceTable::isRedoAvailable() const
+{
+    return !redoStack.isEmpty();
+}
+//! [9]
+
+//! [10]
+//! function: isModified(), setModified(param: bool)
+//! the text differs from the one last marked as saved
+bool PieceTable::isModified() const
+{
+    return undoStack.size() != cleanDepth;
+}
+
+void PieceTable::setModified(bool modified)
+{
+    cleanDepth = modified ? -1 : undoStack.size();
+}
+//! [10]
+
+//! [11]
+//! function: newNode(param: buffer, piece range, its newlines)
+//! append a single node tree for a piece
+qint32 PieceTable::newNode(qint32 buffer, qint64 start, qint64 length, qint64 newlines)
+{
+    //xorshift, priorities only need to be spread
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    Node node;
+    node.start = start;
+    node.length = length;
+    node.newlines = newlines;
+    node.totalLength = length;
+    node.totalNewlines = newlines;
+    node.left = -1;
+    node.right = -1;
+    node.priority = seed;
+    node.buffer = buffer;
+    nodes.append(node);
+    return nodes.size() - 1;
+}
+
+//! function: update(param: node), totalLength(param: node), totalNewlines(param: node)
+//! subtree totals, -1 is the empty tree
+void PieceTable::update(qint32 node)
+{
+    Node &n = nodes[node];
+    n.totalLength = totalLength(n.left) + n.length + totalLength(n.right);
+    n.totalNewlines = totalNewlines(n.left) + n.newlines + totalNewlines(n.right);
+}
+
+qint64 PieceTable::totalLength(qint32 node) const
+{
+    return node == -1 ? 0 : nodes.at(node).totalLength;
+}
+
+qint64 PieceTable::totalNewlines(qint32 node) const
+{
+    return node == -1 ? 0 : nodes.at(node).totalNewlines;
+}
+//! [11]
+
+//! [12]
+//! function: merge(param: left tree, right tree)
+//! concatenate two trees, the higher priority becomes the root
+qint32 PieceTable::merge(qint32 left, qint32 right)
+{
+    if (left == -1)
+        return right;
+    if (right == -1)
+        return left;
+    if (nodes.at(left).priority > nodes.at(right).priority) {
+        const qint32 merged = merge(nodes.at(left).right, right);
+        nodes[left].right = merged;
+        update(left);
+        return left;
+    }
+    const qint32 merged = merge(left, nodes.at(right).left);
+    nodes[right].left = merged;
+    update(right);
+    return right;
+}
+
+//! function: split(param: tree, position, out: trees before and from position)
+//! a piece spanning the position is cut in two, its tail becoming a new node
+void PieceTable::split(qint32 node, qint64 position, qint32 *left, qint32 *right)
+{
+    if (node == -1) {
+        *left = -1;
+        *right = -1;
+        return;
+    }
+    //nodes may move while the recursion appends, index them afresh
+    const qint64 leftLength = totalLength(nodes.at(node).left);
+    const qint64 length = nodes.at(node).length;
+    if (position <= leftLength) {
+        qint32 tail;
+        split(nodes.at(node).left, position, left, &tail);
+        nodes[node].left = tail;
+        update(node);
+        *right = node;
+        return;
+    }
+    if (position >= leftLength + length) {
+        qint32 head;
+        split(nodes.at(node).right, position - leftLength - length, &head, right);
+        nodes[node].right = head;
+        update(node);
+        *left = node;
+        return;
+    }
+
+    const qint64 cut = position - leftLength;
+    const Node piece = nodes.at(node);
+    const qint64 newlines = buffers[piece.buffer].newlines(piece.start, cut);
+    const qint32 tail = newNode(piece.buffer, piece.start + cut, piece.length - cut, piece.newlines - newlines);
+    nodes[node].length = cut;
+    nodes[node].newlines = newlines;
+    nodes[node].right = -1;
+    update(node);
+    *left = node;
+    *right = merge(tail, piece.right);
+}
+//! [12]
+
+//! [13]
+//! function: extract(param: position, length), place(param: position, subtree)
+//! take a range out of the document as a subtree, or put one back in
+qint32 PieceTable::extract(qint64 position, qint64 length)
+{
+    if (length == 0)
+        return -1;
+    qint32 left, middle, right;
+    split(root, position, &left, &right);
+    split(right, length, &middle, &right);
+    root = merge(left, right);
+    return middle;
+}
+
+void PieceTable::place(qint64 position, qint32 subtree)
+{
+    if (subtree == -1)
+        return;
+    qint32 left, right;
+    split(root, position, &left, &right);
+    root = merge(merge(left, subtree), right);
+}
+//! [13]
+
+//! [14]
+//! function: extendLast(param: tree, length, newlines)
+//! grow the last piece of the tree if the added buffer just ended with it
+bool PieceTable::extendLast(qint32 node, qint64 length, qint64 newlines)
+{
+    if (node == -1)
+        return false;
+    const qint32 right = nodes.at(node).right;
+    if (right != -1) {
+        if (!extendLast(right, length, newlines))
+            return false;
+        update(node);
+        return true;
+    }
+    Node &n = nodes[node];
+    if (n.buffer != Added || n.start + n.length != buffers[Added].size - length)
+        return false;
+    n.length += length;
+    n.newlines += newlines;
+    update(node);
+    return true;
+}
+//! [14]
+
+//! [15]
+//! function: replaceAll(param: sorted matches that do not overlap, bytes)
+//! replace every match in one undo step: the replacement is added once and
+//! every match becomes a piece of it, the text between the matches keeps
+//! its pieces; the range from the first to the last match is swapped for
+//! the new pieces like any other edit
+void PieceTable::replaceAll(const QVector<TextMatch> &matches, const QByteArray &text)
+{
+    if (matches.isEmpty())
+        return;
+    const qint64 first = matches.first().position;
+    const qint64 length = matches.last().position + matches.last().length - first;
+    Buffer &added = buffers[Added];
+    const qint64 start = added.size;
+    const qint64 newlines = countNewlines(text.constData(), text.constData() + text.size());
+    added.append(text);
+    const qint32 removed = extract(first, length);
+
+    //walk the removed pieces, keeping what lies between the matches
+    qint32 inserted = -1;
+    qint64 at = 0;
+    int next = 0;
+    QVector<qint32> stack;
+    qint32 node = removed;
+    while (node != -1 || !stack.isEmpty()) {
+        while (node != -1) {
+            stack.append(node);
+            node = nodes.at(node).left;
+        }
+        const Node piece = nodes.at(stack.last());
+        stack.removeLast();
+        const qint64 pieceEnd = at + piece.length;
+        while (at < pieceEnd && next < matches.size()) {
+            const qint64 matchStart = matches.at(next).position - first;
+            const qint64 matchEnd = matchStart + matches.at(next).length;
+            if (at < matchStart) {
+                const qint64 keep = qMin(matchStart, pieceEnd) - at;
+                const qint64 offset = piece.start + at - (pieceEnd - piece.length);
+                inserted = merge(inserted, newNode(piece.buffer, offset, keep,
+                                                   buffers[piece.buffer].newlines(offset, keep)));
+                at += keep;
+                continue;
+            }
+            at = qMin(matchEnd, pieceEnd);
+            if (at == matchEnd) {
+                if (!text.isEmpty())
+                    inserted = merge(inserted, newNode(Added, start, text.size(), newlines));
+                ++next;
+            }
+        }
+        at = pieceEnd;
+        node = piece.right;
+    }
+    Edit edit;
+    edit.position = first;
+    edit.removedLength = length;
+    edit.insertedLength = totalLength(inserted);
+    place(first, inserted);
+    edit.removed = removed;
+    edit.inserted = -1;
+    pushEdit(edit);
+}
+//! [15]
@@ -0,0 +1,124 @@
+/*
+ * Header PieceTable class
+ * Editable text over the bytes of a mapped file
+*/
+
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+//import dependencies
+#include <QByteArray>
+#include <QVector>
+#include "textsearch.h"
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+//! [0]
+//! The text is a sequence of pieces, each a byte range of either the
+//! original file (read in place, never copied) or of an append-only buffer
+//! holding everything typed since. The pieces are the nodes of a treap
+//! ordered by document position; every node carries the byte and newline
+//! totals of its subtree, so inserting, removing and finding a line or a
+//! position all cost O(log n) in the number of pieces.
+//! Both buffers keep the newline count before every BlockSize bytes, so a
+//! piece of any size is split or searched for a line by scanning at most a
+//! block. An edit only moves subtrees: undo and redo put the pieces an edit
+//! took out back in, no text is ever copied for the history. Nodes are not
+//! reused, a session allocates one or two per edit and two per replaced match.
+class PieceTable
+{
+    //set public methods & variables
+    public:
+        static const qint64 BlockSize = 64 * 1024;
+
+        PieceTable();
+
+        void setText(const char *original, qint64 size, const QVector<qint64> &blockLines);
+        void clear();
+
+        qint64 size() const;
+        qint64 lineCount() const;
+        qint64 lineStart(qint64 line) const;
+        qint64 lineAt(qint64 position) const;
+        QByteArray text(qint64 position, qint64 length) const;
+        bool write(QIODevice *device) const;
+        QVector<TextSearch::Span> spans() const;
+
+        void insert(qint64 position, const QByteArray &text);
+        void remove(qint64 position, qint64 length);
+        void replaceAll(const QVector<TextMatch> &matches, const QByteArray &text);
+        qint64 undo();
+        qint64 redo();
+        bool isUndoAvailable() const;
+        bool isRedoAvailable() const;
+        bool isModified() const;
+        void setModified(bool modified);
+
+    //set private methods & variables
+    private:
+        enum BufferId { Original, Added };
+
+        //a source of piece bytes with its newline index
+        struct Buffer
+        {
+            const char *data;
+            qint64 size;
+            QByteArray bytes;           // owned data of the added buffer
+            QVector<qint64> blockLines; // newlines before each block, block count + 1
+
+            void append(const QByteArray &text);
+            qint64 newlinesBefore(qint64 position) const;
+            qint64 newlines(qint64 start, qint64 length) const;
+            qint64 findNewline(qint64 start, qint64 count) const;
+        };
+
+        struct Node
+        {
+            qint64 start;           // piece in its buffer
+            qint64 length;
+            qint64 newlines;
+            qint64 totalLength;     // of the subtree
+            qint64 totalNewlines;
+            qint32 left;
+            qint32 right;
+            quint32 priority;
+            qint32 buffer;
+        };
+
+        //one undo step: removedLength bytes at position were replaced by
+        //insertedLength bytes; the side out of the document is kept as a subtree
+        struct Edit
+        {
+            qint64 position;
+            qint64 removedLength;
+            qint64 insertedLength;
+            qint32 removed;
+            qint32 inserted;
+        };
+
+        qint32 newNode(qint32 buffer, qint64 start, qint64 length, qint64 newlines);
+        void update(qint32 node);
+        qint32 merge(qint32 left, qint32 right);
+        void split(qint32 node, qint64 position, qint32 *left, qint32 *right);
+        qint32 extract(qint64 position, qint64 length);
+        void place(qint64 position, qint32 subtree);
+        bool extendLast(qint32 node, qint64 length, qint64 newlines);
+        void collect(qint32 node, qint64 from, qint64 to, QByteArray *out) const;
+        bool canCoalesce() const;
+        void pushEdit(const Edit &edit);
+        qint64 totalLength(qint32 node) const;
+        qint64 totalNewlines(qint32 node) const;
+
+        Buffer buffers[2];
+        QVector<Node> nodes;
+        qint32 root;
+        quint32 seed;
+        QVector<Edit> undoStack;
+        QVector<Edit> redoStack;
+        int cleanDepth;             // undo depth of the saved text, -1 if unreachable
+};
+//! [0]
+
+#endif // PIECETABLE_H
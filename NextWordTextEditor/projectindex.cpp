@@ -0,0 +1,595 @@
+/*
+ * ProjectIndex Class
+ * Crawl a folder on all cores, index its files and search them in parallel
+*/
+#include "projectindex.h"
+
+#include <QBitArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+
+//! [0]
+//! The state shared by the crawlers of one crawl, under its mutex
+struct ProjectIndex::Crawl
+{
+    QMutex mutex;
+    QThreadPool *pool;              // the crawl pool of the index
+    QStringList pending;            // directories and files not read yet
+    QVector<FileEntry> done;        // read files not taken by the GUI thread yet
+    int crawlers;                   // crawlers still running
+    bool posted;                    // a takeFiles() call is queued
+    bool cancelled;                 // no crawler touches the index any more
+};
+//! [0]
+
+namespace {
+
+//a trigram is 3 bytes, the last one lowest
+const quint32 TrigramMask = 0xffffff;
+
+inline uchar foldAscii(uchar c)
+{
+    return c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+}
+
+//words are read as in DocumentVocabulary
+inline bool isWordCharacter(QChar c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_');
+}
+
+inline bool isJoiner(QChar c)
+{
+    return c == QLatin1Char('-') || c == QLatin1Char(':');
+}
+
+struct Ranked
+{
+    QString word;
+    int count;
+};
+
+bool rankedMoreThan(const Ranked &a, const Ranked &b)
+{
+    return a.count > b.count;
+}
+
+bool shorterList(const QVector<int> *a, const QVector<int> *b)
+{
+    return a->size() < b->size();
+}
+
+//scan one file for a query, mapped by QtConcurrent over the candidate files
+struct FileSearch
+{
+    typedef ProjectIndex::FileMatches result_type;
+
+    FileSearch(const TextSearch &search)
+        : search(search)
+    {
+    }
+
+    ProjectIndex::FileMatches operator()(const QString &fileName) const
+    {
+        ProjectIndex::FileMatches found;
+        found.fileName = fileName;
+        QFile file(fileName);
+        if (!file.open(QFile::ReadOnly) || file.size() == 0)
+            return found;
+        qint64 size = file.size();
+        const char *data = reinterpret_cast<const char *>(file.map(0, size));
+        QByteArray bytes;
+        if (!data) {
+            bytes = file.readAll();
+            data = bytes.constData();
+            size = bytes.size();
+        }
+        const TextSearch::Span span = { data, size };
+        found.matches = search.findAll(QVector<TextSearch::Span>() << span, ProjectIndex::MaxFileMatches);
+
+        //matches are ascending, the newlines are counted once
+        qint64 line = 0;
+        const char *lineStart = data;
+        const char *scanned = data;
+        foreach (const TextMatch &match, found.matches) {
+            const char *end = data + match.position;
+            while (scanned < end && (scanned = static_cast<const char *>(std::memchr(scanned, '\n', end - scanned))) != 0) {
+                ++line;
+                lineStart = ++scanned;
+            }
+            scanned = end;
+            const void *newline = std::memchr(lineStart, '\n', data + size - lineStart);
+            const qint64 length = (newline ? static_cast<const char *>(newline) : data + size) - lineStart;
+            found.lines.append(line);
+            found.lineTexts.append(QString::fromUtf8(lineStart, int(qMin(length, qint64(ProjectIndex::MaxLineLength))))
+                                   .trimmed());
+        }
+        return found;
+    }
+
+    TextSearch search;
+};
+
+} // namespace
+
+//! [1]
+//! main function
+ProjectIndex::ProjectIndex(QObject *parent)
+    : QObject(parent), searcher(0)
+{
+}
+
+//! crawlers still running stop at their next file
+ProjectIndex::~ProjectIndex()
+{
+    close();
+}
+//! [1]
+
+//! [2]
+//! function: open(param: folder), close()
+//! index every .tex and .txt file below the folder, replacing the files of
+//! the folder opened before; progress() and indexed() follow the crawl
+void ProjectIndex::open(const QString &directory)
+{
+    close();
+    root = QDir(directory).absolutePath();
+    startCrawl(QStringList() << root);
+}
+
+void ProjectIndex::close()
+{
+    cancelFind();
+    if (running) {
+        QMutexLocker locker(&running->mutex);
+        running->cancelled = true;
+    }
+    running.clear();
+    root.clear();
+    files.clear();
+    fileIds.clear();
+    postings.clear();
+    terms.clear();
+    termIds.clear();
+    present.clear();
+}
+
+QString ProjectIndex::directory() const
+{
+    return root;
+}
+
+bool ProjectIndex::isIndexing() const
+{
+    return !running.isNull();
+}
+
+int ProjectIndex::fileCount() const
+{
+    return fileIds.size();
+}
+
+//! function: setMaxThreadCount(param: number of threads), maxThreadCount()
+//! the most crawlers that read files at once, the ideal thread count by default
+void ProjectIndex::setMaxThreadCount(int threads)
+{
+    crawlPool.setMaxThreadCount(qMax(1, threads));
+}
+
+int ProjectIndex::maxThreadCount() const
+{
+    return crawlPool.maxThreadCount();
+}
+//! [2]
+
+//! [3]
+//! function: updateFile(param: file name)
+//! read a file of the folder again, e.g. after it was saved; files outside
+//! of the folder are ignored
+void ProjectIndex::updateFile(const QString &fileName)
+{
+    const QString path = QFileInfo(fileName).absoluteFilePath();
+    const QString relative = root.isEmpty() ? QString() : QDir(root).relativeFilePath(path);
+    if (relative.isEmpty() || relative.startsWith(QLatin1String("../")) || QDir::isAbsolutePath(relative)
+            || !isTextFile(path))
+        return;
+    if (running) {
+        QMutexLocker locker(&running->mutex);
+        //a crawler still running will take it
+        if (running->crawlers > 0) {
+            running->pending << path;
+            startCrawlers(running, this);
+            return;
+        }
+    }
+    //merge the files of a crawl that just ended before starting another
+    takeFiles();
+    startCrawl(QStringList() << path);
+}
+//! [3]
+
+//! [4]
+//! function: startCrawl(param: paths to read)
+//! queue the paths and start crawlers for them on the crawl pool
+void ProjectIndex::startCrawl(const QStringList &paths)
+{
+    running = QSharedPointer<Crawl>(new Crawl);
+    running->pool = &crawlPool;
+    running->pending = paths;
+    running->crawlers = 0;
+    running->posted = false;
+    running->cancelled = false;
+    QMutexLocker locker(&running->mutex);
+    startCrawlers(running, this);
+}
+
+//! function: startCrawlers(param: shared crawl state, index to hand the files to)
+//! start another crawler per pending path while the pool has a thread for it
+//! called with the mutex of the crawl held
+void ProjectIndex::startCrawlers(const QSharedPointer<Crawl> &shared, ProjectIndex *index)
+{
+    const int wanted = qMin(shared->pool->maxThreadCount(), shared->crawlers + shared->pending.size());
+    for (; !shared->cancelled && shared->crawlers < wanted; ++shared->crawlers)
+        QtConcurrent::run(shared->pool, &ProjectIndex::crawl, shared, index);
+}
+
+//! function: crawl(param: shared crawl state, index to hand the files to)
+//! run by every crawler: take the last pending path until none is left,
+//! paths found meanwhile start crawlers of their own, so no crawler waits
+//! for another; the GUI thread is asked to take the read files with one
+//! queued call per batch
+void ProjectIndex::crawl(QSharedPointer<Crawl> shared, ProjectIndex *index)
+{
+    //trigrams seen in the current file, one bit each
+    QBitArray seen(int(TrigramMask) + 1);
+    QMutexLocker locker(&shared->mutex);
+    forever {
+        if (shared->pending.isEmpty() || shared->cancelled)
+            break;
+        const QString path = shared->pending.takeLast();
+        locker.unlock();
+
+        QStringList found;
+        FileEntry entry;
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            foreach (const QFileInfo &child, QDir(path).entryInfoList(QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot
+                                                                      | QDir::Readable)) {
+                //linked directories may lead back up the tree
+                if (child.isDir() ? !child.isSymLink() : (isTextFile(child.fileName()) && child.size() <= MaxFileSize))
+                    found << child.filePath();
+            }
+        } else {
+            entry = readFile(path, &seen);
+        }
+
+        locker.relock();
+        shared->pending << found;
+        startCrawlers(shared, index);
+        if (!entry.fileName.isEmpty() && !shared->cancelled) {
+            shared->done.append(entry);
+            if (!shared->posted) {
+                shared->posted = true;
+                QMetaObject::invokeMethod(index, "takeFiles", Qt::QueuedConnection);
+            }
+        }
+    }
+    //the last crawler out announces the end of the crawl
+    if (--shared->crawlers == 0 && !shared->cancelled && !shared->posted) {
+        shared->posted = true;
+        QMetaObject::invokeMethod(index, "takeFiles", Qt::QueuedConnection);
+    }
+}
+
+//! function: isTextFile(param: file name)
+//! the formats the editor opens
+bool ProjectIndex::isTextFile(const QString &fileName)
+{
+    return fileName.endsWith(QLatin1String(".tex"), Qt::CaseInsensitive)
+            || fileName.endsWith(QLatin1String(".txt"), Qt::CaseInsensitive);
+}
+//! [4]
+
+//! [5]
+//! function: readFile(param: file name, cleared bit per trigram)
+//! map a file and collect its distinct trigrams and words; the bits set
+//! are cleared again, so one array serves all files of a crawler
+//! Return an entry without file name if the file cannot be read
+ProjectIndex::FileEntry ProjectIndex::readFile(const QString &fileName, QBitArray *seen)
+{
+    FileEntry entry;
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return entry;
+    entry.fileName = fileName;
+    qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : 0;
+    QByteArray bytes;
+    if (!data) {
+        bytes = file.readAll();
+        data = reinterpret_cast<const uchar *>(bytes.constData());
+        size = bytes.size();
+    }
+
+    quint32 key = 0;
+    for (qint64 i = 0; i < size; ++i) {
+        key = ((key << 8) | foldAscii(data[i])) & TrigramMask;
+        if (i >= 2 && !seen->testBit(int(key))) {
+            seen->setBit(int(key));
+            entry.trigrams.append(key);
+        }
+    }
+    foreach (quint32 trigram, entry.trigrams)
+        seen->clearBit(int(trigram));
+    std::sort(entry.trigrams.begin(), entry.trigrams.end());
+
+    const QString text = QString::fromUtf8(reinterpret_cast<const char *>(data), int(size));
+    QHash<QString, int> wordIds;    // folded word, index in entry.words
+    const int length = text.length();
+    int i = 0;
+    while (i < length) {
+        if (!isWordCharacter(text.at(i))) {
+            ++i;
+            continue;
+        }
+        const int start = i;
+        while (i < length && (isWordCharacter(text.at(i))
+                              || (isJoiner(text.at(i)) && i + 1 < length && isWordCharacter(text.at(i + 1)))))
+            ++i;
+        if (i - start < MinimumLength || (start > 0 && text.at(start - 1) == QLatin1Char('\\')))
+            continue;
+        const QString word = text.mid(start, i - start);
+        const QString folded = word.toCaseFolded();
+        QHash<QString, int>::const_iterator it = wordIds.constFind(folded);
+        if (it == wordIds.constEnd()) {
+            wordIds.insert(folded, entry.words.size());
+            entry.words.append(qMakePair(word, 1));
+        } else {
+            ++entry.words[it.value()].second;
+        }
+    }
+    return entry;
+}
+//! [5]
+
+//! [6]
+//! function: takeFiles()
+//! queued by the crawlers: merge the files read so far, and announce the
+//! end of the crawl once every crawler is done
+void ProjectIndex::takeFiles()
+{
+    if (!running)
+        return;
+    QVector<FileEntry> entries;
+    bool finished;
+    {
+        QMutexLocker locker(&running->mutex);
+        entries.swap(running->done);
+        running->posted = false;
+        finished = running->crawlers == 0;
+    }
+    foreach (const FileEntry &entry, entries)
+        addFile(entry);
+    if (finished)
+        running.clear();
+    if (!entries.isEmpty())
+        emit progress(fileCount());
+    if (finished)
+        emit indexed();
+}
+
+//! function: addFile(param: read file), removeFile(param: file id)
+//! count the words of a file and list it under its trigrams; an entry read
+//! before of the same file is removed first
+void ProjectIndex::addFile(const FileEntry &entry)
+{
+    const int previous = fileIds.value(entry.fileName, -1);
+    if (previous >= 0)
+        removeFile(previous);
+
+    const int id = files.size();
+    File file;
+    file.fileName = entry.fileName;
+    file.removed = false;
+    file.terms.reserve(entry.words.size());
+    for (int i = 0; i < entry.words.size(); ++i) {
+        const QPair<QString, int> &word = entry.words.at(i);
+        const int term = intern(word.first);
+        if (terms.at(term).count == 0)
+            present.insert(terms.at(term).word.toCaseFolded(), term);
+        terms[term].count += word.second;
+        file.terms.append(qMakePair(term, word.second));
+    }
+    foreach (quint32 trigram, entry.trigrams)
+        postings[trigram].append(id);
+    files.append(file);
+    fileIds.insert(file.fileName, id);
+}
+
+void ProjectIndex::removeFile(int id)
+{
+    File &file = files[id];
+    for (int i = 0; i < file.terms.size(); ++i) {
+        Term &term = terms[file.terms.at(i).first];
+        term.count -= file.terms.at(i).second;
+        if (term.count == 0)
+            present.remove(term.word.toCaseFolded());
+    }
+    file.terms.clear();
+    file.removed = true;
+    fileIds.remove(file.fileName);
+}
+
+//! function: intern(param: word)
+//! id of a word, the spelling seen first is the one shown
+int ProjectIndex::intern(const QString &word)
+{
+    const QString folded = word.toCaseFolded();
+    QHash<QString, int>::const_iterator it = termIds.constFind(folded);
+    if (it != termIds.constEnd())
+        return it.value();
+    Term term;
+    term.word = word;
+    term.count = 0;
+    terms.append(term);
+    termIds.insert(folded, terms.size() - 1);
+    return terms.size() - 1;
+}
+//! [6]
+
+//! [7]
+//! function: termCount(), complete(param: prefix, max number of results)
+//! words of all files of the folder starting with prefix, most frequent
+//! first; the prefix itself is left out, it is usually the word being typed
+int ProjectIndex::termCount() const
+{
+    return present.size();
+}
+
+QStringList ProjectIndex::complete(const QString &prefix, int limit) const
+{
+    const QString folded = prefix.toCaseFolded();
+    QVector<Ranked> ranked;
+    for (QMap<QString, int>::const_iterator it = present.lowerBound(folded);
+         it != present.constEnd() && it.key().startsWith(folded); ++it) {
+        if (it.key().size() == folded.size())
+            continue;
+        const Term &term = terms.at(it.value());
+        Ranked r;
+        r.word = term.word;
+        r.count = term.count;
+        ranked.append(r);
+    }
+    if (ranked.size() > limit) {
+        std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(), rankedMoreThan);
+        ranked.resize(limit);
+    } else {
+        std::sort(ranked.begin(), ranked.end(), rankedMoreThan);
+    }
+    QStringList words;
+    foreach (const Ranked &r, ranked)
+        words << r.word;
+    return words;
+}
+//! [7]
+
+//! [8]
+//! function: candidates(param: pattern, options)
+//! ids of the files that may match: those listed under every trigram of a
+//! literal query; Unicode case folding may match other bytes, so ignoring
+//! the case of a query with non-ASCII characters scans every file
+QVector<int> ProjectIndex::candidates(const QString &pattern, TextSearch::Options options) const
+{
+    QVector<int> ids;
+    const QByteArray bytes = pattern.toUtf8();
+    bool literal = !(options & TextSearch::RegularExpression);
+    for (int i = 0; literal && !(options & TextSearch::CaseSensitive) && i < bytes.size(); ++i)
+        literal = uchar(bytes.at(i)) < 0x80;
+
+    QVector<const QVector<int> *> lists;
+    quint32 key = 0;
+    for (int i = 0; literal && i < bytes.size(); ++i) {
+        key = ((key << 8) | foldAscii(uchar(bytes.at(i)))) & TrigramMask;
+        if (i < 2)
+            continue;
+        QHash<quint32, QVector<int> >::const_iterator it = postings.constFind(key);
+        if (it == postings.constEnd())
+            return ids;
+        lists.append(&it.value());
+    }
+    if (lists.isEmpty()) {
+        for (int id = 0; id < files.size(); ++id) {
+            if (!files.at(id).removed)
+                ids.append(id);
+        }
+        return ids;
+    }
+
+    std::sort(lists.begin(), lists.end(), shorterList);
+    QVector<int> common = *lists.first();
+    for (int i = 1; i < lists.size() && !common.isEmpty(); ++i) {
+        QVector<int> kept;
+        std::set_intersection(common.constBegin(), common.constEnd(), lists.at(i)->constBegin(),
+                              lists.at(i)->constEnd(), std::back_inserter(kept));
+        common.swap(kept);
+    }
+    foreach (int id, common) {
+        if (!files.at(id).removed)
+            ids.append(id);
+    }
+    return ids;
+}
+//! [8]
+
+//! [9]
+//! function: find(param: pattern, options), cancelFind(), isSearching()
+//! scan the candidate files on the global thread pool, free of crawlers
+//! since they have their own; matchesFound() is
+//! emitted for every file with matches as soon as it is scanned, then
+//! searchFinished() with the number of files scanned
+void ProjectIndex::find(const QString &pattern, TextSearch::Options options)
+{
+    cancelFind();
+    TextSearch search;
+    search.setQuery(pattern, options);
+    error = search.errorString();
+    if (!search.isActive())
+        return;
+    QStringList fileNames;
+    foreach (int id, candidates(pattern, options))
+        fileNames << files.at(id).fileName;
+
+    searcher = new QFutureWatcher<FileMatches>(this);
+    connect(searcher, SIGNAL(resultReadyAt(int)), this, SLOT(searchResultReady(int)));
+    connect(searcher, SIGNAL(finished()), this, SLOT(searchDone()));
+    searcher->setFuture(QtConcurrent::mapped(fileNames, FileSearch(search)));
+}
+
+//! the files still queued are skipped, none of their matches is reported
+void ProjectIndex::cancelFind()
+{
+    if (!searcher)
+        return;
+    disconnect(searcher, 0, this, 0);
+    searcher->cancel();
+    searcher->deleteLater();
+    searcher = 0;
+}
+
+bool ProjectIndex::isSearching() const
+{
+    return searcher != 0;
+}
+
+//! function: errorString()
+//! why the last query cannot match, empty if it can
+QString ProjectIndex::errorString() const
+{
+    return error;
+}
+//! [9]
+
+//! [10]
+//! function: searchResultReady(param: index of the result), searchDone()
+//! report the matches of a file as they come in, and the end of the search
+void ProjectIndex::searchResultReady(int index)
+{
+    const FileMatches found = searcher->resultAt(index);
+    if (!found.matches.isEmpty())
+        emit matchesFound(found);
+}
+
+void ProjectIndex::searchDone()
+{
+    const int scanned = searcher->progressMaximum();
+    searcher->deleteLater();
+    searcher = 0;
+    emit searchFinished(scanned);
+}
+//! [10]
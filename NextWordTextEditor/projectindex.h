@@ -0,0 +1,146 @@
+/*
+ * Header ProjectIndex class
+ * Words and trigrams of the text files below a folder, for cross-file search
+*/
+
+#ifndef PROJECTINDEX_H
+#define PROJECTINDEX_H
+
+//import dependencies
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include "textsearch.h"
+
+QT_BEGIN_NAMESPACE
+class QBitArray;
+QT_END_NAMESPACE
+
+//! [0]
+//! Opening a folder starts crawlers on a thread pool of the index, sized by
+//! setMaxThreadCount(), so a crawl never holds the threads of the global
+//! pool that dictionaries, large files and searches run on. The crawlers
+//! share a stack of directories and files still to read: a crawler takes
+//! the next one, lists a directory onto the stack, or maps a file and
+//! collects its words and the set of its byte trigrams, ASCII letters
+//! lowered. Listed paths start more crawlers, up to one per thread of the
+//! pool, and a crawler ends once the stack is empty instead of waiting.
+//! Read files are handed to the GUI thread in batches and merged there, so
+//! search and completion see every file as soon as it is read. Each
+//! trigram lists the ids of the files containing it.
+//! A literal query is looked up by intersecting the lists of its trigrams,
+//! the candidate files are then mapped and scanned by TextSearch in
+//! parallel on the global pool, short jobs that share it with the rest of
+//! the editor, and the matches of each file are reported as it is done.
+//! Regular expressions and queries shorter than a trigram scan every file.
+//! A file saved again is read again; its old id stays in the lists but is
+//! marked removed. Words are counted as in DocumentVocabulary.
+class ProjectIndex : public QObject
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const int MinimumLength = 3;
+        static const qint64 MaxFileSize = 64 * 1024 * 1024;    // larger files are not read
+        static const int MaxFileMatches = 1000;                 // reported per file
+        static const int MaxLineLength = 200;                   // bytes shown of a matching line
+
+        //the matches of a query in one file, with their lines
+        struct FileMatches
+        {
+            QString fileName;
+            QVector<TextMatch> matches;     // in bytes of the file
+            QVector<qint64> lines;          // line of each match, from 0
+            QStringList lineTexts;          // text of each of these lines
+        };
+
+        ProjectIndex(QObject *parent = 0);
+        ~ProjectIndex();
+
+        void open(const QString &directory);
+        void close();
+        QString directory() const;
+        bool isIndexing() const;
+        int fileCount() const;
+        void setMaxThreadCount(int threads);
+        int maxThreadCount() const;
+        void updateFile(const QString &fileName);
+
+        int termCount() const;
+        QStringList complete(const QString &prefix, int limit) const;
+
+        void find(const QString &pattern, TextSearch::Options options);
+        void cancelFind();
+        bool isSearching() const;
+        QString errorString() const;
+
+    //set signals
+    signals:
+        void progress(int files);
+        void indexed();
+        void matchesFound(const ProjectIndex::FileMatches &matches);
+        void searchFinished(int files);
+
+    //set private slots methods
+    private slots:
+        void takeFiles();
+        void searchResultReady(int index);
+        void searchDone();
+
+    //set private methods & variables
+    private:
+        struct Crawl;
+
+        //the words and trigrams of one file, read by a crawler
+        struct FileEntry
+        {
+            QString fileName;
+            QVector<quint32> trigrams;                  // ascending
+            QVector<QPair<QString, int> > words;        // spelling seen first, occurrences
+        };
+
+        struct Term
+        {
+            QString word;
+            int count;
+        };
+
+        struct File
+        {
+            QString fileName;
+            QVector<QPair<int, int> > terms;            // term id, occurrences
+            bool removed;
+        };
+
+        static void crawl(QSharedPointer<Crawl> shared, ProjectIndex *index);
+        static void startCrawlers(const QSharedPointer<Crawl> &shared, ProjectIndex *index);
+        static FileEntry readFile(const QString &fileName, QBitArray *seen);
+        static bool isTextFile(const QString &fileName);
+        void startCrawl(const QStringList &paths);
+        void addFile(const FileEntry &entry);
+        void removeFile(int id);
+        int intern(const QString &word);
+        QVector<int> candidates(const QString &pattern, TextSearch::Options options) const;
+
+        QString root;
+        QVector<File> files;                            // by file id, ids are never reused
+        QHash<QString, int> fileIds;                    // file name, id of its current entry
+        QHash<quint32, QVector<int> > postings;         // trigram, ascending file ids
+        QVector<Term> terms;                            // by term id
+        QHash<QString, int> termIds;                    // folded word
+        QMap<QString, int> present;                     // folded word of counted terms, for prefixes
+        QSharedPointer<Crawl> running;                  // crawl still reading files
+        QThreadPool crawlPool;                          // threads of the crawlers
+        QFutureWatcher<FileMatches> *searcher;          // of the query being searched
+        QString error;                                  // of the last query
+};
+//! [0]
+
+#endif // PROJECTINDEX_H
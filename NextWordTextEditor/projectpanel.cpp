@@ -0,0 +1,171 @@
+/*
+ * ProjectPanel Class
+ * Edit the folder query and list the matches streamed in by the ProjectIndex
+*/
+#include "projectpanel.h"
+
+#include <QCheckBox>
+#include <QDir>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+//item data of the file and the line a row opens
+const int FileNameRole = Qt::UserRole;
+const int LineRole = Qt::UserRole + 1;
+
+} // namespace
+
+//! [0]
+//! main function
+//! query and options above the list of matches, follow the index
+ProjectPanel::ProjectPanel(ProjectIndex *index, QWidget *parent)
+    : QWidget(parent), index(index), matchCount(0)
+{
+    findEdit = new QLineEdit;
+    findEdit->setPlaceholderText(tr("Find in folder"));
+    caseBox = new QCheckBox(tr("Match case"));
+    regexBox = new QCheckBox(tr("Regular expression"));
+    results = new QTreeWidget;
+    results->setHeaderHidden(true);
+    results->setUniformRowHeights(true);
+    status = new QLabel;
+
+    QHBoxLayout *optionLayout = new QHBoxLayout;
+    optionLayout->addWidget(caseBox);
+    optionLayout->addWidget(regexBox);
+    optionLayout->addStretch();
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addWidget(findEdit);
+    layout->addLayout(optionLayout);
+    layout->addWidget(results, 1);
+    layout->addWidget(status);
+
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(SearchDelayMs);
+    connect(&searchTimer, SIGNAL(timeout()), this, SLOT(runSearch()));
+    connect(findEdit, SIGNAL(textChanged(QString)), this, SLOT(queryChanged()));
+    connect(findEdit, SIGNAL(returnPressed()), this, SLOT(runSearch()));
+    connect(caseBox, SIGNAL(toggled(bool)), this, SLOT(queryChanged()));
+    connect(regexBox, SIGNAL(toggled(bool)), this, SLOT(queryChanged()));
+    connect(results, SIGNAL(itemActivated(QTreeWidgetItem*,int)), this, SLOT(itemActivated(QTreeWidgetItem*)));
+    connect(index, SIGNAL(matchesFound(ProjectIndex::FileMatches)), this, SLOT(addMatches(ProjectIndex::FileMatches)));
+    connect(index, SIGNAL(searchFinished(int)), this, SLOT(searchFinished(int)));
+    connect(index, SIGNAL(progress(int)), this, SLOT(indexProgress(int)));
+    connect(index, SIGNAL(indexed()), this, SLOT(indexed()));
+}
+//! [0]
+
+//! [1]
+//! function: showFind(), options()
+//! focus the query, selected to be typed over; the options checked
+void ProjectPanel::showFind()
+{
+    findEdit->setFocus();
+    findEdit->selectAll();
+}
+
+TextSearch::Options ProjectPanel::options() const
+{
+    TextSearch::Options options;
+    if (caseBox->isChecked())
+        options |= TextSearch::CaseSensitive;
+    if (regexBox->isChecked())
+        options |= TextSearch::RegularExpression;
+    return options;
+}
+//! [1]
+
+//! [2]
+//! function: queryChanged(), runSearch()
+//! search the folder once the query rests, the list is filled as the files
+//! come in; an empty query only shows the state of the index
+void ProjectPanel::queryChanged()
+{
+    searchTimer.start();
+}
+
+void ProjectPanel::runSearch()
+{
+    searchTimer.stop();
+    results->clear();
+    matchCount = 0;
+    if (findEdit->text().isEmpty()) {
+        index->cancelFind();
+        indexProgress(index->fileCount());
+        return;
+    }
+    index->find(findEdit->text(), options());
+    if (!index->isSearching()) {
+        status->setText(tr("Invalid expression"));
+        status->setToolTip(index->errorString());
+        return;
+    }
+    status->setText(tr("Searching..."));
+    status->setToolTip(QString());
+}
+//! [2]
+
+//! [3]
+//! function: addMatches(param: matches of one file)
+//! one row per matching line, under a row of the file
+void ProjectPanel::addMatches(const ProjectIndex::FileMatches &found)
+{
+    QTreeWidgetItem *fileItem = new QTreeWidgetItem(results);
+    fileItem->setText(0, QDir(index->directory()).relativeFilePath(found.fileName));
+    fileItem->setData(0, FileNameRole, found.fileName);
+    fileItem->setData(0, LineRole, qint64(0));
+    for (int i = 0; i < found.lines.size(); ++i) {
+        if (i > 0 && found.lines.at(i) == found.lines.at(i - 1))
+            continue;
+        QTreeWidgetItem *lineItem = new QTreeWidgetItem(fileItem);
+        lineItem->setText(0, tr("%1: %2").arg(found.lines.at(i) + 1).arg(found.lineTexts.at(i)));
+        lineItem->setData(0, FileNameRole, found.fileName);
+        lineItem->setData(0, LineRole, found.lines.at(i));
+        ++matchCount;
+    }
+    fileItem->setExpanded(true);
+    status->setText(tr("Searching... %n line(s)", 0, matchCount));
+}
+
+//! function: searchFinished(param: number of files scanned)
+void ProjectPanel::searchFinished(int files)
+{
+    status->setText(tr("%1 lines in %n file(s) searched", 0, files).arg(matchCount));
+}
+//! [3]
+
+//! [4]
+//! function: indexProgress(param: number of files), indexed()
+//! the files read so far while there is no query; the query is searched
+//! again once every file is read
+void ProjectPanel::indexProgress(int files)
+{
+    if (!findEdit->text().isEmpty())
+        return;
+    status->setText(index->isIndexing() ? tr("Indexing... %n file(s)", 0, files)
+                                        : tr("%n file(s) indexed", 0, files));
+}
+
+void ProjectPanel::indexed()
+{
+    if (findEdit->text().isEmpty())
+        indexProgress(index->fileCount());
+    else
+        runSearch();
+}
+//! [4]
+
+//! [5]
+//! function: itemActivated(param: activated row)
+//! open the file of the row at its line
+void ProjectPanel::itemActivated(QTreeWidgetItem *item)
+{
+    emit openMatch(item->data(0, FileNameRole).toString(), item->data(0, LineRole).toLongLong());
+}
+//! [5]
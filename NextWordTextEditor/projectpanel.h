@@ -0,0 +1,68 @@
+/*
+ * Header ProjectPanel class
+ * Search the files of the open folder and list the matching lines
+*/
+
+#ifndef PROJECTPANEL_H
+#define PROJECTPANEL_H
+
+//import dependencies
+#include <QTimer>
+#include <QWidget>
+#include "projectindex.h"
+
+QT_BEGIN_NAMESPACE
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QTreeWidget;
+class QTreeWidgetItem;
+QT_END_NAMESPACE
+
+//! [0]
+//! The query is searched SearchDelayMs after the last edit, and again
+//! once the folder is indexed. Matches are listed under their file as the
+//! index reports each file, one row per matching line; activating a row
+//! asks for its file to be opened at that line.
+class ProjectPanel : public QWidget
+{
+    Q_OBJECT
+
+    //set public methods & variables
+    public:
+        static const int SearchDelayMs = 200;
+
+        ProjectPanel(ProjectIndex *index, QWidget *parent = 0);
+
+        void showFind();
+
+    //set signals
+    signals:
+        void openMatch(const QString &fileName, qint64 line);
+
+    //set private slots methods
+    private slots:
+        void queryChanged();
+        void runSearch();
+        void addMatches(const ProjectIndex::FileMatches &found);
+        void searchFinished(int files);
+        void indexProgress(int files);
+        void indexed();
+        void itemActivated(QTreeWidgetItem *item);
+
+    //set private methods & variables
+    private:
+        TextSearch::Options options() const;
+
+        ProjectIndex *index;
+        QLineEdit *findEdit;
+        QCheckBox *caseBox;
+        QCheckBox *regexBox;
+        QTreeWidget *results;
+        QLabel *status;
+        QTimer searchTimer;
+        int matchCount;             // lines listed for the query
+};
+//! [0]
+
+#endif // PROJECTPANEL_H
@@ -8,6 +8,11 @@
  * Implement QTextEdit
 */
 #include "textedit.h"
+#include "completionmodel.h"
+#include "highlightscheduler.h"
+#include "documentvocabulary.h"
+#include "latexcompletion.h"
+#include "perfprobe.h"
 
 #include <QtWidgets>
 
@@ -19,14 +24,25 @@
 #include <QModelIndex>
 #include <QAbstractItemModel>
 #include <QScrollBar>
+#include <climits>
 
 QString prevWord = "";
 
+namespace {
+
+//window in which keystrokes are coalesced into one completion query
+const int CompletionDelayMs = 10;
+
+//quiet time after an edit before the matches of a query are found again
+const int SearchDelayMs = 200;
+
+} // namespace
+
 //! [0]
 //! main function
 //! set text editor format & highlighter
 TextEdit::TextEdit(QWidget *parent)
-: QTextEdit(parent), c(0)
+: QTextEdit(parent), c(0), completionForced(false), awaitingMatches(false)
 {
     QFont font;
     font.setFamily("Arial");
@@ -35,7 +51,18 @@ TextEdit::TextEdit(QWidget *parent)
     this->setFont(font);
 
     highlighter = new Highlighter(this->document());
+    scheduler = new HighlightScheduler(highlighter, this);
+    vocabulary = new DocumentVocabulary(this->document(), this);
 
+    completionTimer.setSingleShot(true);
+    completionTimer.setInterval(CompletionDelayMs);
+    connect(&completionTimer, SIGNAL(timeout()), this, SLOT(updateCompletion()));
+
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(SearchDelayMs);
+    connect(&searchTimer, SIGNAL(timeout()), this, SLOT(runSearch()));
+    connect(this->document(), SIGNAL(contentsChanged()), this, SLOT(documentEdited()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(updateFindSelections()));
 }
 //! [0]
 
@@ -53,6 +80,8 @@ void TextEdit::setCompleter(QCompleter *completer)
 {
     if (c)
         QObject::disconnect(c, 0, this, 0);
+    if (CompletionModel *model = completionModel())
+        QObject::disconnect(model, 0, this, 0);
 
     c = completer;
 
@@ -60,10 +89,16 @@ void TextEdit::setCompleter(QCompleter *completer)
         return;
 
     c->setWidget(this);
-    c->setCompletionMode(QCompleter::PopupCompletion);
+    //the model only holds matches of the current prefix, no filtering needed
+    c->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
     c->setCaseSensitivity(Qt::CaseInsensitive);
     QObject::connect(c, SIGNAL(activated(QString)),
                      this, SLOT(insertCompletion(QString)));
+    //words already in the document are suggested as well
+    if (CompletionModel *model = completionModel()) {
+        model->setDocumentVocabulary(vocabulary);
+        QObject::connect(model, SIGNAL(matchesReady()), this, SLOT(matchesReady()));
+    }
 }
 //! [2]
 
@@ -82,13 +117,30 @@ void TextEdit::insertCompletion(const QString& completion)
 {
     if (c->widget() != this)
         return;
+    //keys typed before the completion was accepted are answered by it
+    completionTimer.stop();
+    awaitingMatches = false;
     QTextCursor tc = textCursor();
     int extra = completion.length() - c->completionPrefix().length();
-    c->setModel(modelUpdate(completion));
+    CompletionModel *model = completionModel();
+    const bool markup = model && model->latexContext() != LatexCompletion::Text;
+
+    //commands and keys are completed at the cursor, they are not learned as words
+    if (markup) {
+        tc.insertText(completion.right(extra));
+        setTextCursor(tc);
+        return;
+    }
+    modelUpdate(completion);
 
-    tc.movePosition(QTextCursor::Left);
-    tc.movePosition(QTextCursor::EndOfWord);
-    tc.insertText(completion.right(extra));
+    //a predicted next word is inserted at the cursor as a whole
+    if (c->completionPrefix().isEmpty()) {
+        tc.insertText(completion);
+    } else {
+        tc.movePosition(QTextCursor::Left);
+        tc.movePosition(QTextCursor::EndOfWord);
+        tc.insertText(completion.right(extra));
+    }
     setTextCursor(tc);
     prevWord = "";
 }
@@ -121,6 +173,7 @@ void TextEdit::focusInEvent(QFocusEvent *e)
 //! called when a key is triggered
 void TextEdit::keyPressEvent(QKeyEvent *e)
 {
+    PerfProbe probe(PerfProbe::KeyPress);
     if (c && c->popup()->isVisible()) {
         // The following keys are forwarded by the completer to the widget
        switch (e->key()) {
@@ -145,27 +198,29 @@ void TextEdit::keyPressEvent(QKeyEvent *e)
 
     static QString eow("~!@#$%^&*()_+{}|:\"<>?,./;'[]\\-="); // end of word
     bool hasModifier = (e->modifiers() != Qt::NoModifier) && !ctrlOrShift;
-    if (e->text() == " ")
-        prevWord = prevWord;
-    else
-        prevWord = textUnderCursor();
 
-    QString completionPrefix = prevWord;
+    //a space finishes the word, the next one starts with an empty prefix
+    if (e->text() == " ")
+        learnFinishedWord();
 
-    if (!isShortcut && ( hasModifier || e->text().isEmpty()|| completionPrefix.length() < 2
-                      || eow.contains(e->text().right(1)))) {
+    //after a backslash or inside \ref{ and \cite{ markup characters do not end the word
+    QString markupPrefix;
+    const bool markup = completionModel() && markupContext(&markupPrefix) != LatexCompletion::Text;
+    if (!isShortcut && (hasModifier || e->text().isEmpty()
+                        || (!markup && eow.contains(e->text().right(1))))) {
+        //a query still waiting for its window is stale now
+        completionTimer.stop();
+        completionForced = false;
+        awaitingMatches = false;
         c->popup()->hide();
         return;
     }
 
-    if (completionPrefix != c->completionPrefix()) {
-        c->setCompletionPrefix(completionPrefix);
-        c->popup()->setCurrentIndex(c->completionModel()->index(0, 0));
-    }
-    QRect cr = cursorRect();
-    cr.setWidth(c->popup()->sizeHintForColumn(0)
-                + c->popup()->verticalScrollBar()->sizeHint().width());
-    c->complete(cr); // popup it up!
+    //keystrokes within CompletionDelayMs are completed once, from the last state
+    completionKey = e->text();
+    completionForced = completionForced || isShortcut;
+    if (!completionTimer.isActive())
+        completionTimer.start();
 }
 //! [7]
 
@@ -174,21 +229,388 @@ void TextEdit::keyPressEvent(QKeyEvent *e)
 //! update suggestion model in QCompleter
 //! set used words to higher rank
 //! called in insertCompletion
-QAbstractItemModel *TextEdit::modelUpdate(const QString& completion)
+void TextEdit::modelUpdate(const QString& completion)
+{
+    PerfProbe probe(PerfProbe::ModelUpdate);
+    if (CompletionModel *model = completionModel())
+        model->recordCompletion(completion);
+}
+//! [8]
+
+//! [9]
+//! function: completionModel()
+//! get the indexed model behind the completer, null for other models
+CompletionModel *TextEdit::completionModel() const
 {
+    return c ? qobject_cast<CompletionModel *>(c->model()) : 0;
+}
+//! [9]
 
-    QStringListModel *mode = (QStringListModel*)(c->model());
+//! [10]
+//! function previousWord(param: length of the typed prefix)
+//! get the word before the prefix, on the same line and separated by spaces
+QString TextEdit::previousWord(int prefixLength) const
+{
+    QTextCursor tc = textCursor();
+    const QString line = tc.block().text().left(qMax(0, tc.positionInBlock() - prefixLength));
+    int end = line.size();
+    if (end == 0 || !line.at(end - 1).isSpace())
+        return QString();
+    while (end > 0 && line.at(end - 1).isSpace())
+        --end;
+    int start = end;
+    while (start > 0 && line.at(start - 1).isLetterOrNumber())
+        --start;
+    return line.mid(start, end - start);
+}
+//! [10]
 
-    QStringList words;
-    words = mode->stringList();
-    int row = words.indexOf(completion);
-    if (row != 0) {
-        words.removeAt(row);
-        words.insert(row-1,completion);}
+//! [11]
+//! function learnFinishedWord()
+//! called after a space was typed: learn the word before it and its bigram
+void TextEdit::learnFinishedWord()
+{
+    CompletionModel *model = completionModel();
+    QTextCursor tc = textCursor();
+    const int position = tc.positionInBlock();
+    //only the first space after a word finishes it
+    if (!model || position < 2 || !tc.block().text().at(position - 2).isLetterOrNumber())
+        return;
+    const QString word = previousWord(0);
+    if (!word.isEmpty())
+        model->recordTypedWord(previousWord(word.length() + 1), word);
+}
+//! [11]
 
-    #ifndef QT_NO_CURSOR
-        QApplication::restoreOverrideCursor();
-    #endif
-        return new QStringListModel(words, c);
+//! [12]
+//! function beginLoad(), endLoad()
+//! bracket the replacement of the text by a DocumentFile: the text is
+//! read-only and not highlighted or indexed block by block while it is
+//! appended, afterwards the visible part is highlighted first and the rest
+//! of the document highlighted and indexed when idle
+void TextEdit::beginLoad()
+{
+    setReadOnly(true);
+    scheduler->beginLoad();
+    vocabulary->beginLoad();
 }
-//! [8]
+
+void TextEdit::endLoad()
+{
+    scheduler->endLoad();
+    vocabulary->endLoad();
+    setReadOnly(false);
+}
+//! [12]
+
+//! [13]
+//! function documentVocabulary()
+//! words and bigrams of the edited document
+DocumentVocabulary *TextEdit::documentVocabulary() const
+{
+    return vocabulary;
+}
+//! [13]
+
+//! [14]
+//! function: showCompletions(param: string, typed part of the completion)
+//! open the popup below the cursor on the first row of the model
+void TextEdit::showCompletions(const QString &completionPrefix)
+{
+    if (completionPrefix != c->completionPrefix())
+        c->setCompletionPrefix(completionPrefix);
+    c->popup()->setCurrentIndex(c->completionModel()->index(0, 0));
+    QRect cr = cursorRect();
+    cr.setWidth(c->popup()->sizeHintForColumn(0)
+                + c->popup()->verticalScrollBar()->sizeHint().width());
+    c->complete(cr); // popup it up!
+}
+//! [14]
+
+//! [15]
+//! function: updateCompletion()
+//! query the model for the state after the last coalesced keystroke;
+//! the popup is updated at once, or when a background query is answered
+void TextEdit::updateCompletion()
+{
+    if (!c)
+        return;
+
+    //posting the query is timed, a background answer is not
+    PerfProbe completion(PerfProbe::Completion);
+    CompletionModel *model = completionModel();
+
+    //commands, labels and citation keys are completed from their own index
+    QString markupPrefix;
+    const LatexCompletion::Context markup = model ? markupContext(&markupPrefix) : LatexCompletion::Text;
+    if (markup != LatexCompletion::Text) {
+        model->setLatexQuery(markup, markupPrefix);
+        showMatches();
+        return;
+    }
+
+    prevWord = completionKey == " " ? QString() : textUnderCursor();
+
+    //predict the successors of the word before the prefix
+    if (model) {
+        model->setQuery(previousWord(prevWord.length()), prevWord);
+        if (model->isPending()) {
+            awaitingMatches = true;
+            return;
+        }
+    }
+    showMatches();
+}
+//! [15]
+
+//! [16]
+//! function: markupContext(param: returned prefix)
+//! LaTeX context of the text before the cursor, in its line
+LatexCompletion::Context TextEdit::markupContext(QString *prefix) const
+{
+    const QTextCursor tc = textCursor();
+    return LatexCompletion::context(tc.block().text().left(tc.positionInBlock()), prefix);
+}
+//! [16]
+
+//! [17]
+//! function: showMatches()
+//! show the popup for the rows of the last query, or hide it
+void TextEdit::showMatches()
+{
+    const bool forced = completionForced;
+    completionForced = false;
+    awaitingMatches = false;
+
+    CompletionModel *model = completionModel();
+    const QString completionPrefix = model ? model->completionPrefix() : prevWord;
+    if (model && model->latexContext() != LatexCompletion::Text) {
+        if (model->rowCount() == 0) {
+            c->popup()->hide();
+            return;
+        }
+        showCompletions(completionPrefix);
+        return;
+    }
+
+    const bool predicting = model && model->predictionCount() > 0;
+    if (!forced && !predicting && completionPrefix.length() < 2) {
+        c->popup()->hide();
+        return;
+    }
+    showCompletions(completionPrefix);
+}
+
+//! function: matchesReady()
+//! a background query was answered; the model only reports the answer to
+//! its latest query, shown if the editor still waits for it
+void TextEdit::matchesReady()
+{
+    if (awaitingMatches && c)
+        showMatches();
+}
+
+//! function: isCompleting()
+//! true while a keystroke waits for its coalesced query or for the answer
+//! of the completion worker, the popup does not show its rows yet
+bool TextEdit::isCompleting() const
+{
+    return completionTimer.isActive() || awaitingMatches;
+}
+//! [17]
+
+//! [18]
+//! function: find(param: string pattern, options)
+//! find the matches of a query and select the first one from the start of
+//! the selection, so that the selected match grows with the query
+//! Return the number of matches
+int TextEdit::find(const QString &pattern, TextSearch::Options options)
+{
+    search.setQuery(pattern, options);
+    runSearch();
+    const int index = search.matchAfter(textCursor().selectionStart());
+    selectMatch(index < search.matches().size() ? index : 0);
+    return search.matches().size();
+}
+
+//! function: findNext(param: bool, search backward)
+//! select the next or the previous match, around the end of the document
+bool TextEdit::findNext(bool backward)
+{
+    if (search.isStale())
+        runSearch();
+    const int count = search.matches().size();
+    if (count == 0)
+        return false;
+    const QTextCursor tc = textCursor();
+    int index;
+    if (backward) {
+        index = search.matchAfter(tc.selectionStart()) - 1;
+        if (index < 0)
+            index = count - 1;
+    } else {
+        index = search.matchAfter(tc.selectionEnd());
+        if (index == count)
+            index = 0;
+    }
+    selectMatch(index);
+    return true;
+}
+
+//! function: selectMatch(param: index of a match)
+//! select a match and scroll it into view
+void TextEdit::selectMatch(int index)
+{
+    if (index < 0 || index >= search.matches().size())
+        return;
+    const TextMatch &match = search.matches().at(index);
+    QTextCursor tc = textCursor();
+    tc.setPosition(int(match.position));
+    tc.setPosition(int(match.position + match.length), QTextCursor::KeepAnchor);
+    setTextCursor(tc);
+}
+//! [18]
+
+//! [19]
+//! function: replace(param: string), replaceAll(param: string)
+//! replace the selected match and select the next one, or replace every
+//! match; all matches are replaced by a single edit of the range between
+//! the first and the last one, one undo step, whose blocks are highlighted
+//! and indexed as they change like any other edit
+//! Return the number of replaced matches
+bool TextEdit::replace(const QString &replacement)
+{
+    if (search.isStale())
+        runSearch();
+    QTextCursor tc = textCursor();
+    const int index = search.matchAfter(tc.selectionStart());
+    if (tc.hasSelection() && index < search.matches().size()
+            && search.matches().at(index).position == tc.selectionStart()
+            && search.matches().at(index).position + search.matches().at(index).length == tc.selectionEnd()) {
+        tc.insertText(replacement);
+        setTextCursor(tc);
+        runSearch();
+    }
+    return findNext(false);
+}
+
+int TextEdit::replaceAll(const QString &replacement)
+{
+    if (!search.isActive())
+        return 0;
+    if (searchText.isNull())
+        searchText = document()->toPlainText();
+    const QVector<TextMatch> matches = search.findAll(searchText, INT_MAX);
+    if (matches.isEmpty())
+        return 0;
+
+    const qint64 first = matches.first().position;
+    const qint64 end = matches.last().position + matches.last().length;
+    QString replaced;
+    qint64 at = first;
+    foreach (const TextMatch &match, matches) {
+        replaced += searchText.midRef(int(at), int(match.position - at));
+        replaced += replacement;
+        at = match.position + match.length;
+    }
+
+    QTextCursor tc(document());
+    tc.setPosition(int(first));
+    tc.setPosition(int(end), QTextCursor::KeepAnchor);
+    tc.beginEditBlock();
+    tc.insertText(replaced);
+    tc.endEditBlock();
+    runSearch();
+    return matches.size();
+}
+//! [19]
+
+//! [20]
+//! function: clearFind(), textSearch()
+//! drop the query and its highlights, or read its matches
+void TextEdit::clearFind()
+{
+    search.clear();
+    searchText = QString();
+    searchTimer.stop();
+    setExtraSelections(QList<QTextEdit::ExtraSelection>());
+}
+
+const TextSearch &TextEdit::textSearch() const
+{
+    return search;
+}
+//! [20]
+
+//! [21]
+//! function: documentEdited(), runSearch()
+//! an edit makes the matches stale, they are found again once typing pauses;
+//! the plain text is kept between searches while the document is unchanged
+void TextEdit::documentEdited()
+{
+    if (search.pattern().isEmpty())
+        return;
+    searchText = QString();
+    search.invalidate();
+    searchTimer.start();
+}
+
+void TextEdit::runSearch()
+{
+    PerfProbe probe(PerfProbe::Search);
+    searchTimer.stop();
+    if (searchText.isNull() && !search.pattern().isEmpty())
+        searchText = document()->toPlainText();
+    search.search(searchText);
+    updateFindSelections();
+    emit matchesChanged();
+}
+//! [21]
+
+//! [22]
+//! function: updateFindSelections(), resizeEvent(param: QResizeEvent)
+//! highlight the matches in the viewport only, again whenever it scrolls;
+//! the highlights follow edits until the matches are found again
+void TextEdit::updateFindSelections()
+{
+    if (search.isStale())
+        return;
+    QList<QTextEdit::ExtraSelection> selections;
+    const QVector<TextMatch> &matches = search.matches();
+    if (!matches.isEmpty()) {
+        const int first = cursorForPosition(QPoint(0, 0)).position();
+        const int last = cursorForPosition(QPoint(viewport()->width() - 1, viewport()->height() - 1)).position();
+        QTextCharFormat format;
+        format.setBackground(QColor(255, 230, 120));
+        //a match may start before the first visible character
+        for (int index = qMax(0, search.matchAfter(first) - 1);
+             index < matches.size() && matches.at(index).position <= last; ++index) {
+            QTextEdit::ExtraSelection selection;
+            selection.format = format;
+            selection.cursor = QTextCursor(document());
+            selection.cursor.setPosition(int(matches.at(index).position));
+            selection.cursor.setPosition(int(matches.at(index).position + matches.at(index).length),
+                                         QTextCursor::KeepAnchor);
+            selections.append(selection);
+        }
+    }
+    setExtraSelections(selections);
+}
+
+void TextEdit::resizeEvent(QResizeEvent *e)
+{
+    QTextEdit::resizeEvent(e);
+    updateFindSelections();
+}
+//! [22]
+
+//! [23]
+//! function: goToLine(param: line number, from 0)
+//! put the cursor at the start of a line and scroll it into view
+void TextEdit::goToLine(int line)
+{
+    const QTextBlock block = document()->findBlockByNumber(qBound(0, line, document()->blockCount() - 1));
+    setTextCursor(QTextCursor(block));
+    ensureCursorVisible();
+}
+//! [23]
@@ -8,12 +8,18 @@
 
 //import dependencies
 #include <QTextEdit>
+#include <QTimer>
 #include "highlighter.h"
+#include "latexcompletion.h"
+#include "textsearch.h"
 
 QT_BEGIN_NAMESPACE
 class QCompleter;
 class QAbstractItemModel;
 QT_END_NAMESPACE
+class CompletionModel;
+class HighlightScheduler;
+class DocumentVocabulary;
 
 //! [0]
 class TextEdit : public QTextEdit
@@ -27,22 +33,60 @@ class TextEdit : public QTextEdit
 
         void setCompleter(QCompleter *c);
         QCompleter *completer() const;
+        void beginLoad();
+        void endLoad();
+        DocumentVocabulary *documentVocabulary() const;
+        bool isCompleting() const;
+
+        int find(const QString &pattern, TextSearch::Options options);
+        bool findNext(bool backward);
+        bool replace(const QString &replacement);
+        int replaceAll(const QString &replacement);
+        void clearFind();
+        const TextSearch &textSearch() const;
+        void goToLine(int line);
+
+    //set signals
+    signals:
+        void matchesChanged();
 
     //set protected methods & variables
     protected:
         void keyPressEvent(QKeyEvent *e) Q_DECL_OVERRIDE;
         void focusInEvent(QFocusEvent *e) Q_DECL_OVERRIDE;
+        void resizeEvent(QResizeEvent *e) Q_DECL_OVERRIDE;
 
     //set private slots methods
     private slots:
         void insertCompletion(const QString &completion);
+        void updateCompletion();
+        void matchesReady();
+        void documentEdited();
+        void runSearch();
+        void updateFindSelections();
 
     //set private methods & variables
     private:
         QString textUnderCursor() const;
-        QAbstractItemModel *modelUpdate(const QString& completion);
+        QString previousWord(int prefixLength) const;
+        void learnFinishedWord();
+        void modelUpdate(const QString& completion);
+        void showCompletions(const QString &completionPrefix);
+        void showMatches();
+        LatexCompletion::Context markupContext(QString *prefix) const;
+        CompletionModel *completionModel() const;
+        void selectMatch(int index);
         QCompleter *c;
         Highlighter *highlighter;
+        HighlightScheduler *scheduler;
+        DocumentVocabulary *vocabulary;
+        QTimer completionTimer;
+        QString completionKey;      // text of the last coalesced key
+        bool completionForced;      // CTRL+E within the window
+        bool awaitingMatches;       // a background query of the editor is out
+        TextSearch search;
+        QString searchText;         // plain text searched, null once edited
+        QTimer searchTimer;
 };
 //! [0]
 
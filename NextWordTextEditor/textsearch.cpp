@@ -0,0 +1,466 @@
+/*
+ * TextSearch Class
+ * Scan UTF-16 and UTF-8 text for the matches of a literal or a regular expression
+*/
+#include "textsearch.h"
+
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTSEARCH_SSE2
+#endif
+
+namespace {
+
+inline bool isLowerAscii(uint c)
+{
+    return c >= 'a' && c <= 'z';
+}
+
+//a character as compared with the needle
+template <typename Char>
+inline uint folded(Char c, bool fold)
+{
+    return fold && c >= 'A' && c <= 'Z' ? uint(c) | 0x20 : uint(c);
+}
+
+//the needle (ASCII letters lowered if folding) is at text
+template <typename Char>
+inline bool matchesAt(const Char *text, const Char *needle, int n, bool fold)
+{
+    for (int i = 0; i < n; ++i) {
+        if (folded(text[i], fold) != needle[i])
+            return false;
+    }
+    return true;
+}
+
+#ifdef TEXTSEARCH_SSE2
+//one character in every lane
+template <typename Char>
+inline __m128i splat(uint c)
+{
+    return sizeof(Char) == 1 ? _mm_set1_epi8(char(c)) : _mm_set1_epi16(short(c));
+}
+
+template <typename Char>
+inline __m128i equal(__m128i a, __m128i b)
+{
+    return sizeof(Char) == 1 ? _mm_cmpeq_epi8(a, b) : _mm_cmpeq_epi16(a, b);
+}
+#endif
+
+//first start of the needle at or after from, -1 if none
+//16 bytes of starts are tested for the first and the last character at once
+template <typename Char>
+qint64 findNeedle(const Char *text, qint64 length, qint64 from, const Char *needle, int n, bool fold)
+{
+    const qint64 last = length - n;
+    qint64 i = from;
+#ifdef TEXTSEARCH_SSE2
+    const int lanes = 16 / sizeof(Char);
+    //OR 0x20 lowers letters, the full check sorts out other characters
+    const __m128i head = splat<Char>(needle[0]);
+    const __m128i tail = splat<Char>(needle[n - 1]);
+    const __m128i headCase = splat<Char>(fold && isLowerAscii(needle[0]) ? 0x20 : 0);
+    const __m128i tailCase = splat<Char>(fold && isLowerAscii(needle[n - 1]) ? 0x20 : 0);
+    for (; i + lanes - 1 <= last; i += lanes) {
+        const __m128i first = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i)), headCase);
+        const __m128i end = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + n - 1)),
+                                         tailCase);
+        uint mask = uint(_mm_movemask_epi8(_mm_and_si128(equal<Char>(first, head), equal<Char>(end, tail))));
+        //a UTF-16 lane sets two bits
+        if (sizeof(Char) == 2)
+            mask &= 0x5555;
+        while (mask) {
+            const qint64 candidate = i + qint64(qCountTrailingZeroBits(mask) / sizeof(Char));
+            if (matchesAt(text + candidate, needle, n, fold))
+                return candidate;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i <= last; ++i) {
+        if (matchesAt(text + i, needle, n, fold))
+            return i;
+    }
+    return -1;
+}
+
+inline void appendMatch(QVector<TextMatch> *matches, qint64 position, qint64 length)
+{
+    TextMatch match;
+    match.position = position;
+    match.length = length;
+    matches->append(match);
+}
+
+//bytes of the UTF-8 encoding of characters from to to of a text
+qint64 utf8Length(const QString &text, int from, int to)
+{
+    qint64 bytes = 0;
+    for (int i = from; i < to; ++i) {
+        const uint c = text.at(i).unicode();
+        bytes += c < 0x80 ? 1 : c < 0x800 || QChar::isSurrogate(c) ? 2 : 3;
+    }
+    return bytes;
+}
+
+//matches of a regular expression in a UTF-8 line starting at position
+void matchLine(const QRegularExpression &expression, const char *line, qint64 length, qint64 position,
+               int limit, QVector<TextMatch> *matches)
+{
+    if (length > 0 && line[length - 1] == '\r')
+        --length;
+    const QString text = QString::fromUtf8(line, int(length));
+    QRegularExpressionMatchIterator it = expression.globalMatch(text);
+    int column = 0;
+    while (matches->size() < limit && it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        if (match.capturedLength() == 0)
+            continue;
+        position += utf8Length(text, column, match.capturedStart());
+        const qint64 bytes = utf8Length(text, match.capturedStart(), match.capturedEnd());
+        appendMatch(matches, position, bytes);
+        position += bytes;
+        column = match.capturedEnd();
+    }
+}
+
+//matches of a regular expression in the lines of UTF-8 spans
+void matchLines(const QRegularExpression &expression, const QVector<TextSearch::Span> &spans,
+                int limit, QVector<TextMatch> *matches)
+{
+    QByteArray pending;     // head of a line continued in the next span
+    qint64 lineStart = 0;
+    qint64 base = 0;
+    foreach (const TextSearch::Span &span, spans) {
+        const char *p = span.data;
+        const char *end = span.data + span.length;
+        while (p < end && matches->size() < limit) {
+            const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (!newline) {
+                pending.append(p, int(end - p));
+                break;
+            }
+            if (pending.isEmpty()) {
+                matchLine(expression, p, newline - p, lineStart, limit, matches);
+            } else {
+                pending.append(p, int(newline - p));
+                matchLine(expression, pending.constData(), pending.size(), lineStart, limit, matches);
+                pending.clear();
+            }
+            lineStart = base + (newline - span.data) + 1;
+            p = newline + 1;
+        }
+        base += span.length;
+    }
+    if (matches->size() < limit)
+        matchLine(expression, pending.constData(), pending.size(), lineStart, limit, matches);
+}
+
+} // namespace
+
+//! [0]
+//! main function
+//! no query, nothing found
+TextSearch::TextSearch()
+    : complete(true), stale(false), narrowing(false)
+{
+}
+//! [0]
+
+//! [1]
+//! function: setQuery(param: string pattern, options)
+//! prepare the needle or the expression; a literal extending the previous
+//! one is narrowed from its matches by the next search
+void TextSearch::setQuery(const QString &pattern, Options options)
+{
+    const Qt::CaseSensitivity cs = options & CaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    bool overlaps = false;
+    for (int k = 1; k < needle.size() && !overlaps; ++k)
+        overlaps = needle.endsWith(needle.left(k));
+    //found belongs to the current query only once it was searched
+    const bool extends = isLiteral() && !overlaps && !narrowing && !stale && complete && options == flags
+            && pattern.size() > query.size() && pattern.startsWith(query, cs);
+
+    query = pattern;
+    flags = options;
+    expression = QRegularExpression();
+    needle.clear();
+    needleUtf8.clear();
+    narrowing = false;
+    stale = true;
+    if (pattern.isEmpty())
+        return;
+
+    //the kernel folds ASCII letters only
+    const bool fold = cs == Qt::CaseInsensitive;
+    bool literal = !(options & RegularExpression);
+    if (literal && fold) {
+        foreach (const QChar &c, pattern) {
+            if (c.unicode() >= 0x80 && (c.toLower() != c || c.toUpper() != c))
+                literal = false;
+        }
+    }
+    if (!literal) {
+        expression.setPattern(options & RegularExpression ? pattern : QRegularExpression::escape(pattern));
+        expression.setPatternOptions(fold ? QRegularExpression::MultilineOption | QRegularExpression::CaseInsensitiveOption
+                                          : QRegularExpression::MultilineOption);
+        return;
+    }
+    needle = pattern;
+    if (fold) {
+        for (int i = 0; i < needle.size(); ++i) {
+            if (needle.at(i).unicode() < 0x80)
+                needle[i] = QChar(folded(needle.at(i).unicode(), true));
+        }
+    }
+    needleUtf8 = needle.toUtf8();
+    narrowing = extends;
+    stale = !extends;
+}
+
+//! function: pattern(), isActive(), errorString()
+//! the query, whether it can match, and why a regular expression cannot
+QString TextSearch::pattern() const
+{
+    return query;
+}
+
+bool TextSearch::isActive() const
+{
+    return isLiteral() || (!query.isEmpty() && expression.isValid());
+}
+
+QString TextSearch::errorString() const
+{
+    return isActive() || query.isEmpty() ? QString() : expression.errorString();
+}
+
+bool TextSearch::isLiteral() const
+{
+    return !needle.isEmpty();
+}
+//! [1]
+
+//! [2]
+//! function: search(param: text of the document), search(param: UTF-8 spans)
+//! find the matches of the query, narrowing the previous ones if possible
+void TextSearch::search(const QString &text)
+{
+    if (narrowing) {
+        found = narrowed(text);
+    } else {
+        found = findAll(text, MaxMatches);
+        complete = found.size() < MaxMatches;
+    }
+    stale = false;
+    narrowing = false;
+}
+
+void TextSearch::search(const QVector<Span> &spans)
+{
+    if (narrowing) {
+        found = narrowed(spans);
+    } else {
+        found = findAll(spans, MaxMatches);
+        complete = found.size() < MaxMatches;
+    }
+    stale = false;
+    narrowing = false;
+}
+//! [2]
+
+//! [3]
+//! function: findAll(param: text of the document, most matches)
+//! positions and lengths in characters of the text
+QVector<TextMatch> TextSearch::findAll(const QString &text, int limit) const
+{
+    QVector<TextMatch> matches;
+    if (!isActive())
+        return matches;
+    if (isLiteral()) {
+        const ushort *data = text.utf16();
+        const int n = needle.size();
+        const bool fold = !(flags & CaseSensitive);
+        qint64 from = 0;
+        while (matches.size() < limit && (from = findNeedle(data, text.size(), from, needle.utf16(), n, fold)) >= 0) {
+            appendMatch(&matches, from, n);
+            from += n;
+        }
+        return matches;
+    }
+    QRegularExpressionMatchIterator it = expression.globalMatch(text);
+    while (matches.size() < limit && it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        if (match.capturedLength() > 0)
+            appendMatch(&matches, match.capturedStart(), match.capturedLength());
+    }
+    return matches;
+}
+
+//! function: findAll(param: UTF-8 spans of the text, most matches)
+//! positions and lengths in bytes of the text; a literal is also looked
+//! for across the end of every span, expressions are matched line by line
+QVector<TextMatch> TextSearch::findAll(const QVector<Span> &spans, int limit) const
+{
+    QVector<TextMatch> matches;
+    if (!isActive())
+        return matches;
+    if (!isLiteral()) {
+        matchLines(expression, spans, limit, &matches);
+        return matches;
+    }
+
+    const uchar *key = reinterpret_cast<const uchar *>(needleUtf8.constData());
+    const int n = needleUtf8.size();
+    const bool fold = !(flags & CaseSensitive);
+    QByteArray carry;       // the last n - 1 bytes before the span
+    qint64 base = 0;        // position of the span
+    qint64 next = 0;        // matches do not overlap
+    foreach (const Span &span, spans) {
+        //matches starting in the carry and ending in the span
+        if (!carry.isEmpty()) {
+            const QByteArray window = carry + QByteArray::fromRawData(span.data, int(qMin(span.length, qint64(n - 1))));
+            const qint64 windowBase = base - carry.size();
+            const uchar *data = reinterpret_cast<const uchar *>(window.constData());
+            qint64 from = qMax(qint64(0), next - windowBase);
+            while (matches.size() < limit && (from = findNeedle(data, window.size(), from, key, n, fold)) >= 0
+                   && from < carry.size()) {
+                appendMatch(&matches, windowBase + from, n);
+                next = windowBase + from + n;
+                from += n;
+            }
+        }
+        const uchar *data = reinterpret_cast<const uchar *>(span.data);
+        qint64 from = qMax(qint64(0), next - base);
+        while (matches.size() < limit && (from = findNeedle(data, span.length, from, key, n, fold)) >= 0) {
+            appendMatch(&matches, base + from, n);
+            next = base + from + n;
+            from += n;
+        }
+        if (matches.size() >= limit)
+            break;
+        if (n > 1) {
+            const qint64 tail = qMin(span.length, qint64(n - 1));
+            carry.append(span.data + span.length - tail, int(tail));
+            carry = carry.right(n - 1);
+        }
+        base += span.length;
+    }
+    return matches;
+}
+//! [3]
+
+//! [4]
+//! function: narrowed(param: text of the document), narrowed(param: UTF-8 spans)
+//! the previous matches that the longer needle still matches, without overlaps
+QVector<TextMatch> TextSearch::narrowed(const QString &text) const
+{
+    QVector<TextMatch> matches;
+    const ushort *data = text.utf16();
+    const int n = needle.size();
+    const bool fold = !(flags & CaseSensitive);
+    qint64 next = 0;
+    foreach (const TextMatch &match, found) {
+        if (match.position < next || match.position + n > text.size())
+            continue;
+        if (matchesAt(data + match.position, needle.utf16(), n, fold)) {
+            appendMatch(&matches, match.position, n);
+            next = match.position + n;
+        }
+    }
+    return matches;
+}
+
+QVector<TextMatch> TextSearch::narrowed(const QVector<Span> &spans) const
+{
+    QVector<TextMatch> matches;
+    const uchar *key = reinterpret_cast<const uchar *>(needleUtf8.constData());
+    const int n = needleUtf8.size();
+    const bool fold = !(flags & CaseSensitive);
+    QByteArray gathered;    // a candidate across the end of a span
+    int span = 0;
+    qint64 base = 0;
+    qint64 next = 0;
+    foreach (const TextMatch &match, found) {
+        //the matches are sorted, the spans are walked once
+        while (span < spans.size() && base + spans.at(span).length <= match.position)
+            base += spans.at(span++).length;
+        if (span == spans.size())
+            break;
+        if (match.position < next)
+            continue;
+        const qint64 offset = match.position - base;
+        const uchar *candidate = reinterpret_cast<const uchar *>(spans.at(span).data + offset);
+        if (offset + n > spans.at(span).length) {
+            gathered = QByteArray(spans.at(span).data + offset, int(spans.at(span).length - offset));
+            for (int s = span + 1; s < spans.size() && gathered.size() < n; ++s)
+                gathered.append(spans.at(s).data, int(qMin(spans.at(s).length, qint64(n - gathered.size()))));
+            if (gathered.size() < n)
+                continue;
+            candidate = reinterpret_cast<const uchar *>(gathered.constData());
+        }
+        if (matchesAt(candidate, key, n, fold)) {
+            appendMatch(&matches, match.position, n);
+            next = match.position + n;
+        }
+    }
+    return matches;
+}
+//! [4]
+
+//! [5]
+//! function: matches(), isComplete(), isStale()
+//! the matches of the last search, sorted; whether none were left out
+//! past MaxMatches, and whether the text changed since
+const QVector<TextMatch> &TextSearch::matches() const
+{
+    return found;
+}
+
+bool TextSearch::isComplete() const
+{
+    return complete;
+}
+
+bool TextSearch::isStale() const
+{
+    return stale;
+}
+
+//! function: invalidate(), clear()
+//! the text changed, the next search scans it again; or drop the query
+void TextSearch::invalidate()
+{
+    stale = true;
+    narrowing = false;
+}
+
+void TextSearch::clear()
+{
+    setQuery(QString(), flags);
+    found.clear();
+    complete = true;
+    stale = false;
+}
+//! [5]
+
+//! [6]
+//! function: matchAfter(param: position)
+//! index of the first match starting at or after a position, or the count
+int TextSearch::matchAfter(qint64 position) const
+{
+    TextMatch key;
+    key.position = position;
+    key.length = 0;
+    return int(std::lower_bound(found.constBegin(), found.constEnd(), key,
+                                [](const TextMatch &a, const TextMatch &b) {
+                                    return a.position < b.position;
+                                }) - found.constBegin());
+}
+//! [6]
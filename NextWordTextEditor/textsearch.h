@@ -0,0 +1,92 @@
+/*
+ * Header TextSearch class
+ * Find matches of a query in the text of the editors
+*/
+
+#ifndef TEXTSEARCH_H
+#define TEXTSEARCH_H
+
+//import dependencies
+#include <QFlags>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+//a match, in characters of a QString or in bytes of UTF-8 text
+struct TextMatch
+{
+    qint64 position;
+    qint64 length;
+};
+
+//! [0]
+//! Literal queries are found by an SSE2 kernel over the UTF-16 text of the
+//! document or over the UTF-8 pieces of the large file editor: the first and
+//! last character of the needle are compared against 16 bytes at a time and
+//! only the candidates are checked in full. Case-insensitive search folds
+//! ASCII letters in the kernel; queries with other cased letters, and
+//! regular expressions, go through QRegularExpression, line by line in
+//! UTF-8 text. Matches do not overlap.
+//! While the query grows the matches of the previous query are narrowed
+//! instead of scanning the text again, as long as the text did not change
+//! and the previous needle cannot overlap itself, so that every later match
+//! starts at a previous one. Only MaxMatches matches are kept for display.
+class TextSearch
+{
+    //set public methods & variables
+    public:
+        enum Option {
+            CaseSensitive = 0x1,
+            RegularExpression = 0x2
+        };
+        Q_DECLARE_FLAGS(Options, Option)
+
+        //a run of UTF-8 text, read in place
+        struct Span
+        {
+            const char *data;
+            qint64 length;
+        };
+
+        static const int MaxMatches = 1 << 20;
+
+        TextSearch();
+
+        void setQuery(const QString &pattern, Options options);
+        QString pattern() const;
+        bool isActive() const;
+        QString errorString() const;
+
+        void search(const QString &text);
+        void search(const QVector<Span> &spans);
+        QVector<TextMatch> findAll(const QString &text, int limit) const;
+        QVector<TextMatch> findAll(const QVector<Span> &spans, int limit) const;
+
+        const QVector<TextMatch> &matches() const;
+        bool isComplete() const;
+        bool isStale() const;
+        void invalidate();
+        void clear();
+        int matchAfter(qint64 position) const;
+
+    //set private methods & variables
+    private:
+        bool isLiteral() const;
+        QVector<TextMatch> narrowed(const QString &text) const;
+        QVector<TextMatch> narrowed(const QVector<Span> &spans) const;
+
+        QString query;
+        Options flags;
+        QRegularExpression expression;  // regular expressions and Unicode case folding
+        QString needle;                 // literal query, ASCII letters lowered
+        QByteArray needleUtf8;          // the same in UTF-8
+        QVector<TextMatch> found;
+        bool complete;                  // found holds every match
+        bool stale;                     // found is not of the query and text
+        bool narrowing;                 // the next search may narrow found
+};
+//! [0]
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(TextSearch::Options)
+
+#endif // TEXTSEARCH_H
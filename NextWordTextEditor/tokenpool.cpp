@@ -0,0 +1,235 @@
+/*
+ * TokenPool Class
+ * Intern the tokens of the word lists and map words to their ids
+*/
+#include "tokenpool.h"
+#include "dictionaryimage.h"
+
+#include <algorithm>
+#include <cstring>
+
+//! [0]
+//! function: Builder(param: lines of the word lists best ranked first)
+//! split every line at spaces and intern its tokens in order of appearance,
+//! so a token keeps the spelling of its best ranked line
+TokenPool::Builder::Builder(const QStringList &lines)
+{
+    lineOffsets.reserve(lines.size() + 1);
+    foreach (const QString &line, lines) {
+        lineOffsets.append(tokens.size());
+        foreach (const QString &word, line.split(QLatin1Char(' '), QString::SkipEmptyParts))
+            tokens.append(intern(word));
+    }
+    lineOffsets.append(tokens.size());
+    //ids are only needed while interning
+    ids.clear();
+    keyOffsets.append(keyPool.size());
+    wordOffsets.append(wordPool.size());
+}
+
+//! function: intern(param: string)
+//! return the token id of a word, adding it when new
+qint32 TokenPool::Builder::intern(const QString &word)
+{
+    const QByteArray key = word.toCaseFolded().toUtf8();
+    QHash<QByteArray, qint32>::const_iterator it = ids.constFind(key);
+    if (it != ids.constEnd())
+        return it.value();
+    const qint32 id = keyOffsets.size();
+    ids.insert(key, id);
+    keyOffsets.append(keyPool.size());
+    wordOffsets.append(wordPool.size());
+    keyPool.append(key);
+    wordPool.append(word.toUtf8());
+    return id;
+}
+//! [0]
+
+//! [1]
+//! function: tokenCount(), lineCount(), lineTokens(param: line, out: number of tokens)
+//! token ids of a line, empty for a blank line
+int TokenPool::Builder::tokenCount() const
+{
+    return keyOffsets.size() - 1;
+}
+
+int TokenPool::Builder::lineCount() const
+{
+    return lineOffsets.size() - 1;
+}
+
+const qint32 *TokenPool::Builder::lineTokens(int line, int *count) const
+{
+    *count = lineOffsets.at(line + 1) - lineOffsets.at(line);
+    return tokens.constData() + lineOffsets.at(line);
+}
+//! [1]
+
+//! [2]
+//! function: key(param: token id), word(param: token id)
+//! folded key and spelling of a token while compiling
+QByteArray TokenPool::Builder::key(int id) const
+{
+    const int offset = keyOffsets.at(id);
+    return keyPool.mid(offset, keyOffsets.at(id + 1) - offset);
+}
+
+QString TokenPool::Builder::word(int id) const
+{
+    const int offset = wordOffsets.at(id);
+    return QString::fromUtf8(wordPool.constData() + offset, wordOffsets.at(id + 1) - offset);
+}
+//! [2]
+
+//! [3]
+//! function: write(param: output image)
+//! hash the keys and store the arena as sections of the image
+void TokenPool::Builder::write(DictionaryImage *image) const
+{
+    //open addressing, at most half full
+    const int count = keyOffsets.size() - 1;
+    int hashSize = 16;
+    while (hashSize < count * 2)
+        hashSize *= 2;
+    QVector<qint32> table(hashSize, -1);
+    for (int id = 0; id < count; ++id) {
+        const int offset = keyOffsets.at(id);
+        quint32 slot = hashKey(keyPool.constData() + offset, keyOffsets.at(id + 1) - offset)
+                & quint32(hashSize - 1);
+        while (table.at(slot) != -1)
+            slot = (slot + 1) & quint32(hashSize - 1);
+        table[slot] = id;
+    }
+
+    image->setSection(DictionaryImage::TokenKeyOffsets, keyOffsets);
+    image->setSection(DictionaryImage::TokenWordOffsets, wordOffsets);
+    image->setSection(DictionaryImage::TokenKeyPool, keyPool);
+    image->setSection(DictionaryImage::TokenWordPool, wordPool);
+    image->setSection(DictionaryImage::TokenHash, table);
+}
+//! [3]
+
+//! [4]
+//! main function
+//! create an empty pool
+TokenPool::TokenPool()
+{
+    clear();
+}
+//! [4]
+
+//! [5]
+//! function: attach(param: compiled image)
+//! point the pool at the tables of the image, which must outlive it
+bool TokenPool::attach(const DictionaryImage &image)
+{
+    clear();
+    if (!image.isValid())
+        return false;
+
+    int keyOffsetCount, wordOffsetCount, keyPoolSize, wordPoolSize, hashSize;
+    keyOffsets = image.section<qint32>(DictionaryImage::TokenKeyOffsets, &keyOffsetCount);
+    wordOffsets = image.section<qint32>(DictionaryImage::TokenWordOffsets, &wordOffsetCount);
+    keyPool = image.section<char>(DictionaryImage::TokenKeyPool, &keyPoolSize);
+    wordPool = image.section<char>(DictionaryImage::TokenWordPool, &wordPoolSize);
+    hashTable = image.section<qint32>(DictionaryImage::TokenHash, &hashSize);
+
+    //every offset and id must stay inside its section, and a probe must
+    //reach a free slot, before a lookup may trust the tables
+    const int tokens = keyOffsetCount - 1;
+    if (tokens < 0 || wordOffsetCount != keyOffsetCount
+            || hashSize <= tokens || (hashSize & (hashSize - 1)) != 0
+            || !DictionaryImage::validOffsets(keyOffsets, keyOffsetCount, keyPoolSize)
+            || !DictionaryImage::validOffsets(wordOffsets, wordOffsetCount, wordPoolSize)
+            || !DictionaryImage::validIds(hashTable, hashSize, -1, tokens)
+            || std::find(hashTable, hashTable + hashSize, -1) == hashTable + hashSize) {
+        clear();
+        return false;
+    }
+    count = tokens;
+    hashMask = quint32(hashSize - 1);
+    return true;
+}
+//! [5]
+
+//! [6]
+//! function: clear()
+//! detach from the image
+void TokenPool::clear()
+{
+    count = 0;
+    hashMask = 0;
+    keyOffsets = 0;
+    wordOffsets = 0;
+    keyPool = 0;
+    wordPool = 0;
+    hashTable = 0;
+}
+//! [6]
+
+//! [7]
+//! function: size()
+//! number of distinct tokens
+int TokenPool::size() const
+{
+    return count;
+}
+//! [7]
+
+//! [8]
+//! function: find(param: string), word(param: token id)
+//! map between a word (case-insensitive) and its token id, -1 if missing
+int TokenPool::find(const QString &word) const
+{
+    if (count == 0)
+        return -1;
+    const QByteArray key = word.toCaseFolded().toUtf8();
+    quint32 slot = hashKey(key.constData(), key.size()) & hashMask;
+    for (qint32 id = hashTable[slot]; id != -1; id = hashTable[slot]) {
+        const int offset = keyOffsets[id];
+        if (keyOffsets[id + 1] - offset == key.size()
+                && std::memcmp(keyPool + offset, key.constData(), key.size()) == 0)
+            return id;
+        slot = (slot + 1) & hashMask;
+    }
+    return -1;
+}
+
+QString TokenPool::word(int id) const
+{
+    const int offset = wordOffsets[id];
+    return QString::fromUtf8(wordPool + offset, wordOffsets[id + 1] - offset);
+}
+//! [8]
+
+//! [9]
+//! function: key(param: token id, out: length), keyStartsWith(param: token id, folded prefix)
+//! folded UTF-8 key of a token, read in place
+const char *TokenPool::key(int id, int *length) const
+{
+    *length = keyOffsets[id + 1] - keyOffsets[id];
+    return keyPool + keyOffsets[id];
+}
+
+bool TokenPool::keyStartsWith(int id, const QByteArray &prefix) const
+{
+    const int offset = keyOffsets[id];
+    if (keyOffsets[id + 1] - offset < prefix.size())
+        return false;
+    return std::memcmp(keyPool + offset, prefix.constData(), prefix.size()) == 0;
+}
+//! [9]
+
+//! [10]
+//! function: hashKey(param: folded UTF-8 key)
+//! FNV-1a, stable across runs so the table can be stored in the image
+quint32 TokenPool::hashKey(const char *key, int length)
+{
+    quint32 hash = 2166136261u;
+    for (int i = 0; i < length; ++i) {
+        hash ^= quint8(key[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+//! [10]
@@ -0,0 +1,80 @@
+/*
+ * Header TokenPool class
+ * Interned token arena shared by the prefix index and the predictor
+*/
+
+#ifndef TOKENPOOL_H
+#define TOKENPOOL_H
+
+//import dependencies
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class DictionaryImage;
+
+//! [0]
+//! Every distinct token of the word lists is stored once, as its case-folded
+//! key and the spelling it first appeared with, and is known everywhere else
+//! by a 32-bit id. An open addressing hash table over the keys maps a word
+//! back to its id. Index entries and bigrams are sequences of these ids, so
+//! a head word repeated on a thousand bigram lines costs four bytes per line,
+//! and display strings are only assembled for the rows actually shown.
+//! All tables are read in place from a DictionaryImage.
+class TokenPool
+{
+    //set public methods & variables
+    public:
+        //the arena while a dictionary is compiled
+        class Builder
+        {
+            public:
+                explicit Builder(const QStringList &lines);
+
+                int tokenCount() const;
+                int lineCount() const;
+                const qint32 *lineTokens(int line, int *count) const;
+                QByteArray key(int id) const;
+                QString word(int id) const;
+                void write(DictionaryImage *image) const;
+
+            private:
+                qint32 intern(const QString &word);
+
+                QHash<QByteArray, qint32> ids;
+                QByteArray keyPool;
+                QByteArray wordPool;
+                QVector<qint32> keyOffsets;
+                QVector<qint32> wordOffsets;
+                QVector<qint32> lineOffsets;
+                QVector<qint32> tokens;
+        };
+
+        TokenPool();
+
+        bool attach(const DictionaryImage &image);
+        void clear();
+
+        int size() const;
+        int find(const QString &word) const;
+        QString word(int id) const;
+        const char *key(int id, int *length) const;
+        bool keyStartsWith(int id, const QByteArray &prefix) const;
+
+        static quint32 hashKey(const char *key, int length);
+
+    //set private methods & variables
+    private:
+        int count;
+        quint32 hashMask;
+        const qint32 *keyOffsets;
+        const qint32 *wordOffsets;
+        const char *keyPool;
+        const char *wordPool;
+        const qint32 *hashTable;
+};
+//! [0]
+
+#endif // TOKENPOOL_H
@@ -0,0 +1,133 @@
+/*
+ * UsageRanking Class
+ * Decayed frequency counters for accepted completions
+*/
+#include "usageranking.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+quint64 bigramKey(int head, int tail)
+{
+    return (quint64(quint32(head)) << 32) | quint32(tail);
+}
+
+} // namespace
+
+//! [0]
+//! main function
+//! create an empty ranking
+UsageRanking::UsageRanking()
+    : clock(0)
+{
+}
+//! [0]
+
+//! [1]
+//! function: clear(), isEmpty()
+//! forget all recorded uses
+void UsageRanking::clear()
+{
+    words.clear();
+    bigrams.clear();
+    clock = 0;
+}
+
+bool UsageRanking::isEmpty() const
+{
+    return words.isEmpty() && bigrams.isEmpty();
+}
+//! [1]
+
+//! [2]
+//! function: recordWord(param: entry id, weight), recordBigram(param: token ids, weight)
+//! count one use of a word or of a word following another
+void UsageRanking::recordWord(int id, double weight)
+{
+    ++clock;
+    QHash<qint32, Usage>::iterator it = words.find(id);
+    if (it == words.end()) {
+        Usage usage = { 0.0, clock };
+        it = words.insert(id, usage);
+    }
+    record(&it.value(), weight);
+}
+
+void UsageRanking::recordBigram(int head, int tail, double weight)
+{
+    ++clock;
+    record(&bigrams[bigramKey(head, tail)], weight);
+}
+//! [2]
+
+//! [3]
+//! function: wordScore(param: entry id), bigramScore(param: token ids)
+//! decayed use count, 0 for never used
+double UsageRanking::wordScore(int id) const
+{
+    QHash<qint32, Usage>::const_iterator it = words.constFind(id);
+    return it == words.constEnd() ? 0.0 : decayed(it.value());
+}
+
+double UsageRanking::bigramScore(int head, int tail) const
+{
+    QHash<quint64, Usage>::const_iterator it = bigrams.constFind(bigramKey(head, tail));
+    return it == bigrams.constEnd() ? 0.0 : decayed(it.value());
+}
+//! [3]
+
+//! [4]
+//! function: usedWords(param: entry range)
+//! used entries with begin <= id < end, best score first
+QVector<int> UsageRanking::usedWords(int begin, int end) const
+{
+    QVector<int> ids;
+    if (end - begin < words.size()) {
+        for (int id = begin; id < end; ++id) {
+            if (words.contains(id))
+                ids.append(id);
+        }
+    } else {
+        for (QHash<qint32, Usage>::const_iterator it = words.constBegin(); it != words.constEnd(); ++it) {
+            if (it.key() >= begin && it.key() < end)
+                ids.append(it.key());
+        }
+    }
+    std::sort(ids.begin(), ids.end(), [this](int a, int b) { return wordLessThan(a, b); });
+    return ids;
+}
+//! [4]
+
+//! [5]
+//! function: wordLessThan(param: entry ids)
+//! true when a ranks before b: higher score, then more recent use
+bool UsageRanking::wordLessThan(int a, int b) const
+{
+    QHash<qint32, Usage>::const_iterator ia = words.constFind(a);
+    QHash<qint32, Usage>::const_iterator ib = words.constFind(b);
+    const double sa = ia == words.constEnd() ? 0.0 : decayed(ia.value());
+    const double sb = ib == words.constEnd() ? 0.0 : decayed(ib.value());
+    if (sa != sb)
+        return sa > sb;
+    const quint32 ta = ia == words.constEnd() ? 0 : ia.value().tick;
+    const quint32 tb = ib == words.constEnd() ? 0 : ib.value().tick;
+    return ta > tb;
+}
+//! [5]
+
+//! [6]
+//! function: record(param: counter, weight)
+//! decay the counter to the current tick and add the new use
+void UsageRanking::record(Usage *usage, double weight)
+{
+    usage->score = decayed(*usage) + weight;
+    usage->tick = clock;
+}
+
+double UsageRanking::decayed(const Usage &usage) const
+{
+    return usage.score * std::pow(0.5, double(clock - usage.tick) / HalfLife);
+}
+//! [6]
@@ -0,0 +1,57 @@
+/*
+ * Header UsageRanking class
+ * Learned ranking of accepted completions
+*/
+
+#ifndef USAGERANKING_H
+#define USAGERANKING_H
+
+//import dependencies
+#include <QHash>
+#include <QVector>
+
+//! [0]
+//! Keeps a decayed use count per word entry and per bigram (previous token,
+//! next token). Recording a use touches one counter; scores halve after
+//! HalfLife further recorded uses, so recent choices outrank old habits.
+//! Counters are hashed, so recording is O(1); the used entries of a prefix
+//! range are found by probing the range or scanning the used words,
+//! whichever is smaller.
+class UsageRanking
+{
+    //set public methods & variables
+    public:
+        UsageRanking();
+
+        void clear();
+        bool isEmpty() const;
+
+        void recordWord(int id, double weight = 1.0);
+        void recordBigram(int head, int tail, double weight = 1.0);
+
+        double wordScore(int id) const;
+        double bigramScore(int head, int tail) const;
+        QVector<int> usedWords(int begin, int end) const;
+
+        bool wordLessThan(int a, int b) const;
+
+        static const int HalfLife = 200;
+
+    //set private methods & variables
+    private:
+        struct Usage
+        {
+            double score;
+            quint32 tick;
+        };
+
+        void record(Usage *usage, double weight);
+        double decayed(const Usage &usage) const;
+
+        QHash<qint32, Usage> words;
+        QHash<quint64, Usage> bigrams;
+        quint32 clock;
+};
+//! [0]
+
+#endif // USAGERANKING_H
@@ -0,0 +1,592 @@
+/*
+ * WordIndex Class
+ * Sorted, deduplicated, case-folded prefix index used by the completer
+*/
+#include "wordindex.h"
+#include "dictionaryimage.h"
+
+#include <QHash>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+//ranges this small are filtered directly instead of split into more nodes
+const int LeafSize = 8;
+
+struct Record
+{
+    QByteArray key;
+    int line;
+};
+
+bool recordLessThan(const Record &a, const Record &b)
+{
+    if (a.key != b.key)
+        return a.key < b.key;
+    return a.line < b.line;
+}
+
+//tables of the index while it is compiled, the keys only shape the trie
+struct Builder
+{
+    QByteArray keyPool;
+    QVector<qint32> keyOffsets;
+    QVector<qint32> tokenOffsets;
+    QVector<qint32> tokens;
+    QVector<qint32> ranks;
+    QVector<WordIndex::Node> nodes;
+    QVector<quint8> edgeLabels;
+    QVector<qint32> edgeTargets;
+    QVector<qint32> bestOffsets;
+    QVector<qint32> best;
+
+    int buildNode(int begin, int end, int depth);
+    void buildBest();
+};
+
+//! function: buildNode(param: entry range, key depth)
+//! append the trie node for a range of entries sharing depth bytes
+//! children are grouped by the byte at depth; return the node id
+int Builder::buildNode(int begin, int end, int depth)
+{
+    const int id = nodes.size();
+    WordIndex::Node node;
+    node.begin = begin;
+    node.end = end;
+    node.firstEdge = edgeLabels.size();
+    node.edgeCount = 0;
+    nodes.append(node);
+
+    if (end - begin <= LeafSize)
+        return id;
+
+    //a key ending at this depth sorts before all of its extensions
+    int first = begin;
+    while (first < end && keyOffsets.at(first + 1) - keyOffsets.at(first) == depth)
+        ++first;
+
+    QVector<int> bounds;
+    for (int i = first; i < end; ) {
+        const char label = keyPool.at(keyOffsets.at(i) + depth);
+        int next = i + 1;
+        while (next < end && keyPool.at(keyOffsets.at(next) + depth) == label)
+            ++next;
+        edgeLabels.append(quint8(label));
+        edgeTargets.append(-1);
+        bounds.append(i);
+        i = next;
+    }
+    bounds.append(end);
+
+    const int firstEdge = nodes.at(id).firstEdge;
+    nodes[id].edgeCount = bounds.size() - 1;
+    for (int k = 0; k + 1 < bounds.size(); ++k) {
+        //the recursion appends edges, take the slot only afterwards
+        const int child = buildNode(bounds.at(k), bounds.at(k + 1), depth + 1);
+        edgeTargets[firstEdge + k] = child;
+    }
+    return id;
+}
+
+//! function: buildBest()
+//! keep the best ranked entries of every node too large to sort per query
+void Builder::buildBest()
+{
+    bestOffsets.reserve(nodes.size() + 1);
+    QVector<qint32> ids;
+    const QVector<qint32> &r = ranks;
+    auto rankLessThan = [&r](qint32 a, qint32 b) { return r.at(a) < r.at(b); };
+    foreach (const WordIndex::Node &node, nodes) {
+        bestOffsets.append(best.size());
+        if (node.end - node.begin <= WordIndex::BestCount)
+            continue;
+        ids.resize(0);
+        for (int id = node.begin; id < node.end; ++id)
+            ids.append(id);
+        std::partial_sort(ids.begin(), ids.begin() + WordIndex::BestCount, ids.end(), rankLessThan);
+        for (int i = 0; i < WordIndex::BestCount; ++i)
+            best.append(ids.at(i));
+    }
+    bestOffsets.append(best.size());
+}
+
+//one DP row per trie depth, prefixes are short
+typedef QVarLengthArray<int, 32> Row;
+
+//next row of the Levenshtein matrix after appending byte to the key prefix
+//return the smallest cell, a lower bound for every longer key prefix
+int nextRow(const QByteArray &query, const int *row, quint8 byte, int *next)
+{
+    next[0] = row[0] + 1;
+    int smallest = next[0];
+    for (int j = 1; j <= query.size(); ++j) {
+        const int substitute = row[j - 1] + (quint8(query.at(j - 1)) != byte ? 1 : 0);
+        next[j] = qMin(qMin(row[j], next[j - 1]) + 1, substitute);
+        smallest = qMin(smallest, next[j]);
+    }
+    return smallest;
+}
+
+int rowMinimum(const int *row, int size)
+{
+    return *std::min_element(row, row + size);
+}
+
+} // namespace
+
+//entries matched so far, best distance per entry
+struct WordIndex::FuzzySearch
+{
+    QByteArray query;
+    int maxDistance;
+    int limit;
+    QHash<int, int> distances;
+
+    void match(int id, int distance)
+    {
+        QHash<int, int>::iterator it = distances.find(id);
+        if (it == distances.end())
+            distances.insert(id, distance);
+        else if (distance < it.value())
+            it.value() = distance;
+    }
+};
+
+//! [0]
+//! main function
+//! create an empty index
+WordIndex::WordIndex()
+{
+    clear();
+}
+//! [0]
+
+//! [1]
+//! function: compile(param: interned lines of the word list best ranked first, output image)
+//! sort and deduplicate the lines by their folded key, build the prefix
+//! trie and store all tables as sections of the image; an entry keeps the
+//! token ids of its line, the tokens themselves are written by the pool
+void WordIndex::compile(const TokenPool::Builder &tokens, DictionaryImage *image)
+{
+    QVector<Record> records;
+    records.reserve(tokens.lineCount());
+    for (int line = 0; line < tokens.lineCount(); ++line) {
+        int length;
+        const qint32 *ids = tokens.lineTokens(line, &length);
+        if (length == 0)
+            continue;
+        Record record;
+        record.key = tokens.key(ids[0]);
+        for (int i = 1; i < length; ++i)
+            record.key += ' ' + tokens.key(ids[i]);
+        record.line = line;
+        records.append(record);
+    }
+    std::sort(records.begin(), records.end(), recordLessThan);
+
+    //keep the best ranked spelling of every folded key
+    Builder builder;
+    QVector<int> lines;
+    lines.reserve(records.size());
+    builder.keyOffsets.reserve(records.size() + 1);
+    builder.tokenOffsets.reserve(records.size() + 1);
+    for (int i = 0; i < records.size(); ++i) {
+        const Record &record = records.at(i);
+        if (i > 0 && record.key == records.at(i - 1).key)
+            continue;
+        int length;
+        const qint32 *ids = tokens.lineTokens(record.line, &length);
+        builder.keyOffsets.append(builder.keyPool.size());
+        builder.tokenOffsets.append(builder.tokens.size());
+        builder.keyPool.append(record.key);
+        for (int t = 0; t < length; ++t)
+            builder.tokens.append(ids[t]);
+        lines.append(record.line);
+    }
+    builder.keyOffsets.append(builder.keyPool.size());
+    builder.tokenOffsets.append(builder.tokens.size());
+    records.clear();
+
+    //rank entries by their position in the source list
+    const int count = lines.size();
+    QVector<qint32> byRank(count);
+    for (int i = 0; i < count; ++i)
+        byRank[i] = i;
+    std::sort(byRank.begin(), byRank.end(), [&lines](qint32 a, qint32 b) {
+        return lines.at(a) < lines.at(b);
+    });
+    builder.ranks.resize(count);
+    for (int r = 0; r < count; ++r)
+        builder.ranks[byRank.at(r)] = r;
+
+    builder.buildNode(0, count, 0);
+    builder.buildBest();
+
+    image->setSection(DictionaryImage::WordTokenOffsets, builder.tokenOffsets);
+    image->setSection(DictionaryImage::WordTokens, builder.tokens);
+    image->setSection(DictionaryImage::WordRanks, builder.ranks);
+    image->setSection(DictionaryImage::WordNodes, builder.nodes);
+    image->setSection(DictionaryImage::WordEdgeLabels, builder.edgeLabels);
+    image->setSection(DictionaryImage::WordEdgeTargets, builder.edgeTargets);
+    image->setSection(DictionaryImage::WordBestOffsets, builder.bestOffsets);
+    image->setSection(DictionaryImage::WordBest, builder.best);
+}
+//! [1]
+
+//! [2]
+//! function: attach(param: compiled image)
+//! point the index at the tables of the image, which must outlive it
+bool WordIndex::attach(const DictionaryImage &image)
+{
+    clear();
+    if (!tokens.attach(image))
+        return false;
+
+    int tokenOffsetCount, entryTokenCount, rankCount, edgeCount, targetCount, bestOffsetCount, bestCount;
+    tokenOffsets = image.section<qint32>(DictionaryImage::WordTokenOffsets, &tokenOffsetCount);
+    entryTokens = image.section<qint32>(DictionaryImage::WordTokens, &entryTokenCount);
+    ranks = image.section<qint32>(DictionaryImage::WordRanks, &rankCount);
+    nodes = image.section<Node>(DictionaryImage::WordNodes, &nodeCount);
+    edgeLabels = image.section<quint8>(DictionaryImage::WordEdgeLabels, &edgeCount);
+    edgeTargets = image.section<qint32>(DictionaryImage::WordEdgeTargets, &targetCount);
+    bestOffsets = image.section<qint32>(DictionaryImage::WordBestOffsets, &bestOffsetCount);
+    best = image.section<qint32>(DictionaryImage::WordBest, &bestCount);
+
+    //every offset and id must stay inside its section, an entry has at
+    //least one token and trie edges only lead to later nodes
+    if (tokenOffsetCount != rankCount + 1 || edgeCount != targetCount || nodeCount < 1
+            || bestOffsetCount != nodeCount + 1
+            || !DictionaryImage::validOffsets(tokenOffsets, tokenOffsetCount, entryTokenCount, true)
+            || !DictionaryImage::validIds(entryTokens, entryTokenCount, 0, tokens.size())
+            || !DictionaryImage::validIds(ranks, rankCount, 0, rankCount)
+            || !DictionaryImage::validOffsets(bestOffsets, bestOffsetCount, bestCount)
+            || !DictionaryImage::validIds(best, bestCount, 0, rankCount)
+            || !validNodes(rankCount, edgeCount)) {
+        clear();
+        return false;
+    }
+
+    count = rankCount;
+    return true;
+}
+
+//! function: validNodes(param: number of entries, number of edges)
+//! node ranges lie within the entries and edges within the edge sections
+bool WordIndex::validNodes(int entries, int edges) const
+{
+    for (int node = 0; node < nodeCount; ++node) {
+        const Node &n = nodes[node];
+        if (n.begin < 0 || n.begin > n.end || n.end > entries
+                || n.edgeCount < 0 || n.firstEdge < 0 || n.firstEdge > edges - n.edgeCount
+                || !DictionaryImage::validIds(edgeTargets + n.firstEdge, n.edgeCount, node + 1, nodeCount))
+            return false;
+    }
+    return true;
+}
+//! [2]
+
+//! [3]
+//! function: clear()
+//! detach from the image
+void WordIndex::clear()
+{
+    tokens.clear();
+    count = 0;
+    nodeCount = 0;
+    tokenOffsets = 0;
+    entryTokens = 0;
+    nodes = 0;
+    edgeLabels = 0;
+    edgeTargets = 0;
+    bestOffsets = 0;
+    best = 0;
+    ranks = 0;
+}
+//! [3]
+
+//! [4]
+//! function: size()
+//! number of distinct entries
+int WordIndex::size() const
+{
+    return count;
+}
+
+bool WordIndex::isEmpty() const
+{
+    return count == 0;
+}
+//! [4]
+
+//! [5]
+//! function: word(param: entry id)
+//! assemble the display string of an entry from its tokens
+QString WordIndex::word(int id) const
+{
+    QString text = tokens.word(entryTokens[tokenOffsets[id]]);
+    for (int t = tokenOffsets[id] + 1; t < tokenOffsets[id + 1]; ++t) {
+        text += QLatin1Char(' ');
+        text += tokens.word(entryTokens[t]);
+    }
+    return text;
+}
+
+int WordIndex::rank(int id) const
+{
+    return ranks[id];
+}
+//! [5]
+
+//! [6]
+//! function: find(param: string)
+//! return the entry id of a word (case-insensitive), -1 if missing
+int WordIndex::find(const QString &word) const
+{
+    const QByteArray key = foldKey(word.trimmed());
+    int begin, end;
+    if (key.isEmpty() || !locate(key, &begin, &end))
+        return -1;
+    //the exact key sorts before its extensions
+    Key exact;
+    entryKey(begin, &exact);
+    if (exact.size() != key.size())
+        return -1;
+    return begin;
+}
+//! [6]
+
+//! [7]
+//! function: complete(param: prefix, max number of results)
+//! return ids of entries starting with prefix, best ranked first
+//! a large range answers from the best entries of its node, only small
+//! ranges and limits above BestCount are sorted here
+QVector<int> WordIndex::complete(const QString &prefix, int limit) const
+{
+    QVector<int> ids;
+    int begin, end, node;
+    if (limit <= 0 || !locate(foldKey(prefix), &begin, &end, &node))
+        return ids;
+
+    int stored;
+    const qint32 *top = bestEntries(node, &stored);
+    if (stored > 0 && limit <= stored) {
+        ids.reserve(limit);
+        for (int i = 0; i < limit; ++i)
+            ids.append(top[i]);
+        return ids;
+    }
+
+    ids.reserve(end - begin);
+    for (int i = begin; i < end; ++i)
+        ids.append(i);
+
+    const qint32 *r = ranks;
+    auto rankLessThan = [r](int a, int b) { return r[a] < r[b]; };
+    if (ids.size() > limit) {
+        std::partial_sort(ids.begin(), ids.begin() + limit, ids.end(), rankLessThan);
+        ids.resize(limit);
+    } else {
+        std::sort(ids.begin(), ids.end(), rankLessThan);
+    }
+    return ids;
+}
+//! [7]
+
+//! [8]
+//! function: prefixRange(param: prefix, out: entry range)
+//! entries starting with prefix are the contiguous ids [begin, end)
+bool WordIndex::prefixRange(const QString &prefix, int *begin, int *end) const
+{
+    return locate(foldKey(prefix), begin, end);
+}
+//! [8]
+
+//! [9]
+//! function: locate(param: folded prefix, out: entry range)
+//! walk the trie along the prefix, then trim the remaining leaf range
+//! node receives the deepest node reached, whose range may be wider
+bool WordIndex::locate(const QByteArray &prefix, int *begin, int *end, int *node) const
+{
+    if (nodeCount == 0)
+        return false;
+
+    int at = 0;
+    int depth = 0;
+    while (depth < prefix.size() && nodes[at].edgeCount > 0) {
+        const Node &n = nodes[at];
+        const quint8 label = quint8(prefix.at(depth));
+        const quint8 *labels = edgeLabels + n.firstEdge;
+        const quint8 *it = std::lower_bound(labels, labels + n.edgeCount, label);
+        if (it == labels + n.edgeCount || *it != label)
+            return false;
+        at = edgeTargets[n.firstEdge + int(it - labels)];
+        ++depth;
+    }
+
+    int b = nodes[at].begin;
+    int e = nodes[at].end;
+    if (depth < prefix.size()) {
+        //keys in a leaf are sorted, so the matches are contiguous
+        while (b < e && !keyStartsWith(b, prefix))
+            ++b;
+        int last = b;
+        while (last < e && keyStartsWith(last, prefix))
+            ++last;
+        e = last;
+    }
+    *begin = b;
+    *end = e;
+    if (node)
+        *node = at;
+    return b < e;
+}
+
+//! function: bestEntries(param: node, out: count)
+//! best ranked entries of a node, none for nodes small enough to sort
+const qint32 *WordIndex::bestEntries(int node, int *count) const
+{
+    *count = bestOffsets[node + 1] - bestOffsets[node];
+    return best + bestOffsets[node];
+}
+
+bool WordIndex::keyStartsWith(int id, const QByteArray &prefix) const
+{
+    Key key;
+    entryKey(id, &key);
+    if (key.size() < prefix.size())
+        return false;
+    return std::memcmp(key.constData(), prefix.constData(), prefix.size()) == 0;
+}
+
+//! function: entryKey(param: entry id, out: key)
+//! folded key of an entry, its token keys joined by spaces
+void WordIndex::entryKey(int id, Key *key) const
+{
+    key->resize(0);
+    for (int t = tokenOffsets[id]; t < tokenOffsets[id + 1]; ++t) {
+        if (t > tokenOffsets[id])
+            key->append(' ');
+        int length;
+        const char *part = tokens.key(entryTokens[t], &length);
+        key->append(part, length);
+    }
+}
+//! [9]
+
+//! [10]
+//! function: foldKey(param: string)
+//! case-folded UTF-8 key used for sorting and prefix matching
+QByteArray WordIndex::foldKey(const QString &text)
+{
+    return text.toCaseFolded().toUtf8();
+}
+//! [10]
+
+//! [11]
+//! function: fuzzyComplete(param: prefix, max edit distance, max number of results)
+//! return entries with a key prefix within maxDistance edits of prefix,
+//! closest first, then best ranked; exact prefix matches have distance 0
+QVector<WordIndex::FuzzyMatch> WordIndex::fuzzyComplete(const QString &prefix, int maxDistance, int limit) const
+{
+    QVector<FuzzyMatch> matches;
+    if (limit <= 0 || nodeCount == 0)
+        return matches;
+
+    FuzzySearch search;
+    search.query = foldKey(prefix);
+    search.maxDistance = maxDistance;
+    search.limit = limit;
+    Row row(search.query.size() + 1);
+    for (int j = 0; j < row.size(); ++j)
+        row[j] = j;
+    fuzzyNode(&search, 0, 0, row.constData());
+
+    matches.reserve(search.distances.size());
+    for (QHash<int, int>::const_iterator it = search.distances.constBegin(); it != search.distances.constEnd(); ++it) {
+        FuzzyMatch match;
+        match.id = it.key();
+        match.distance = it.value();
+        matches.append(match);
+    }
+    const qint32 *r = ranks;
+    auto closerThan = [r](const FuzzyMatch &a, const FuzzyMatch &b) {
+        return a.distance != b.distance ? a.distance < b.distance : r[a.id] < r[b.id];
+    };
+    if (matches.size() > limit) {
+        std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), closerThan);
+        matches.resize(limit);
+    } else {
+        std::sort(matches.begin(), matches.end(), closerThan);
+    }
+    return matches;
+}
+//! [11]
+
+//! [12]
+//! function: fuzzyNode(param: search, node, depth, DP row of the node prefix)
+//! a node whose prefix is close enough matches its whole range; children
+//! are only visited while they can still match, and more closely
+//! of a large range only the best entries are recorded: any other entry
+//! either matches more closely through a child or ranks below them
+void WordIndex::fuzzyNode(FuzzySearch *search, int node, int depth, const int *row) const
+{
+    const Node &n = nodes[node];
+    const int columns = search->query.size() + 1;
+    const int distance = row[columns - 1];
+    const int smallest = rowMinimum(row, columns);
+    if (distance <= search->maxDistance) {
+        int stored;
+        const qint32 *top = bestEntries(node, &stored);
+        if (stored > 0 && search->limit <= stored) {
+            for (int i = 0; i < search->limit; ++i)
+                search->match(top[i], distance);
+        } else {
+            for (int id = n.begin; id < n.end; ++id)
+                search->match(id, distance);
+        }
+        if (smallest >= distance)
+            return;
+    }
+    if (smallest > search->maxDistance)
+        return;
+
+    if (n.edgeCount == 0) {
+        for (int id = n.begin; id < n.end; ++id)
+            fuzzyKey(search, id, depth, row);
+        return;
+    }
+    Row next(columns);
+    for (int k = 0; k < n.edgeCount; ++k) {
+        if (nextRow(search->query, row, edgeLabels[n.firstEdge + k], next.data()) <= search->maxDistance)
+            fuzzyNode(search, edgeTargets[n.firstEdge + k], depth + 1, next.constData());
+    }
+}
+
+//! function: fuzzyKey(param: search, entry id, depth, DP row at that depth)
+//! continue along the remaining bytes of a single key of a leaf range
+void WordIndex::fuzzyKey(FuzzySearch *search, int id, int depth, const int *row) const
+{
+    const int columns = search->query.size() + 1;
+    Key entry;
+    entryKey(id, &entry);
+    const char *key = entry.constData();
+    const int length = entry.size();
+    Row rows(2 * columns);
+    const int *current = row;
+    int *next = rows.data();
+    int *spare = next + columns;
+    int closest = search->maxDistance + 1;
+    for (int i = depth; i < length; ++i) {
+        const int smallest = nextRow(search->query, current, quint8(key[i]), next);
+        closest = qMin(closest, next[columns - 1]);
+        if (smallest >= closest)
+            break;
+        current = next;
+        std::swap(next, spare);
+    }
+    if (closest <= search->maxDistance)
+        search->match(id, closest);
+}
+//! [12]
@@ -0,0 +1,101 @@
+/*
+ * Header WordIndex class
+ * Compact prefix index over the word suggestion list
+*/
+
+#ifndef WORDINDEX_H
+#define WORDINDEX_H
+
+//import dependencies
+#include <QByteArray>
+#include <QString>
+#include <QVarLengthArray>
+#include <QVector>
+#include "tokenpool.h"
+
+class DictionaryImage;
+
+//! [0]
+//! Words are case-folded, deduplicated and sorted by their folded UTF-8 key.
+//! An entry is stored as the ids of its tokens in the shared TokenPool, its
+//! key and display string are assembled from them when needed.
+//! A byte trie on top of the sorted keys maps every prefix to the contiguous
+//! range of entries sharing it. Nodes with more than BestCount entries also
+//! store their BestCount best ranked entries, so completing a prefix costs
+//! the prefix length plus the number of results, independent of the
+//! dictionary size; only a limit above BestCount sorts the whole range.
+//! The rank of an entry is its position in the source list (0 = best),
+//! learned usage is layered on top by UsageRanking.
+//! Fuzzy completion walks the same trie with one row of a Levenshtein
+//! matrix per depth and prunes a branch once every cell of its row exceeds
+//! the allowed distance, so only the few branches near the prefix are read;
+//! a close enough node contributes its best entries, not its whole range.
+//! All tables are read in place from a DictionaryImage.
+class WordIndex
+{
+    //set public methods & variables
+    public:
+        struct Node
+        {
+            qint32 begin;       // first entry sharing this prefix
+            qint32 end;         // one past the last entry
+            qint32 firstEdge;   // children in the edge label/target sections
+            qint32 edgeCount;   // 0 for a leaf range
+        };
+
+        struct FuzzyMatch
+        {
+            qint32 id;
+            qint32 distance;    // edits between the prefix and the closest key prefix
+        };
+
+        //best entries kept per node, enough for any completion query
+        static const int BestCount = 100;
+
+        WordIndex();
+
+        static void compile(const TokenPool::Builder &tokens, DictionaryImage *image);
+        bool attach(const DictionaryImage &image);
+        void clear();
+
+        int size() const;
+        bool isEmpty() const;
+        QString word(int id) const;
+        int rank(int id) const;
+        int find(const QString &word) const;
+        bool prefixRange(const QString &prefix, int *begin, int *end) const;
+        QVector<int> complete(const QString &prefix, int limit) const;
+        QVector<FuzzyMatch> fuzzyComplete(const QString &prefix, int maxDistance, int limit) const;
+
+        static QByteArray foldKey(const QString &text);
+
+    //set private methods & variables
+    private:
+        //keys of multi-word entries are short
+        typedef QVarLengthArray<char, 64> Key;
+
+        bool validNodes(int entries, int edges) const;
+        bool locate(const QByteArray &prefix, int *begin, int *end, int *node = 0) const;
+        const qint32 *bestEntries(int node, int *count) const;
+        bool keyStartsWith(int id, const QByteArray &prefix) const;
+        void entryKey(int id, Key *key) const;
+
+        struct FuzzySearch;
+        void fuzzyNode(FuzzySearch *search, int node, int depth, const int *row) const;
+        void fuzzyKey(FuzzySearch *search, int id, int depth, const int *row) const;
+
+        TokenPool tokens;
+        int count;
+        int nodeCount;
+        const qint32 *tokenOffsets;
+        const qint32 *entryTokens;
+        const Node *nodes;
+        const quint8 *edgeLabels;
+        const qint32 *edgeTargets;
+        const qint32 *bestOffsets;
+        const qint32 *best;
+        const qint32 *ranks;
+};
+//! [0]
+
+#endif // WORDINDEX_H